@@ -57,6 +57,7 @@
  * Preamble
  *****************************************************************************/
 
+// Change to #define for every per-block and per-chunk message; see ccnxVLCLog.h.
 #undef DEBUG
 
 #ifdef HAVE_CONFIG_H
@@ -64,6 +65,19 @@
 #endif
 
 #include "ccnxVLCUtils.h"
+#include "ccnxVLCDispatcher.h"
+#include "ccnxVLCFetcher.h"
+#include "ccnxVLCChunkedFlow.h"
+#include "ccnxVLCChunkRing.h"
+#include "ccnxVLCChunkCache.h"
+#include "ccnxVLCNameTemplate.h"
+#include "ccnxVLCRateAdapter.h"
+#include "ccnxVLCManifest.h"
+#include "ccnxVLCDiskCache.h"
+#include "ccnxVLCHistogram.h"
+#include "ccnxVLCLog.h"
+#include "ccnxVLCTrace.h"
+#include "ccnxVLCPrefixSelector.h"
 
 #include <parc/algol/parc_Memory.h>
 #include <ccnx/api/ccnx_Portal/ccnx_Portal.h>
@@ -78,8 +92,47 @@
 #include <vlc_access.h>
 #include <vlc_url.h>
 #include <vlc_threads.h>
+#include <vlc_atomic.h>
 
 
+/*****************************************************************************
+ * Logging
+ *****************************************************************************/
+// Messages from the per-block and per-chunk paths, compiled in according to
+// CCNX_VLC_LOG_LEVEL (see ccnxVLCLog.h). When compiled out the arguments are still type
+// checked, but never evaluated.
+#if CCNX_VLC_LOG_LEVEL >= CCNxVLCLogLevel_Blocks
+# define _LOG_BLOCK(p_access, ...) msg_Dbg(p_access, __VA_ARGS__)
+#else
+# define _LOG_BLOCK(p_access, ...) do { if (0) msg_Dbg(p_access, __VA_ARGS__); } while (0)
+#endif
+
+#if CCNX_VLC_LOG_LEVEL >= CCNxVLCLogLevel_Chunks
+# define _LOG_CHUNK(p_access, ...) msg_Dbg(p_access, __VA_ARGS__)
+#else
+# define _LOG_CHUNK(p_access, ...) do { if (0) msg_Dbg(p_access, __VA_ARGS__); } while (0)
+#endif
+
+// The shortest time between two messages from the same _LOG_LIMITED call.
+#define _LOG_LIMIT_INTERVAL_US 5000000
+
+// Log with `msg_Function` (e.g. msg_Warn) a message that can repeat as fast as VLC calls us,
+// at most once every _LOG_LIMIT_INTERVAL_US per call site across every stream, saying how
+// many were dropped in between. `format` must be a string literal with at least one argument.
+#define _LOG_LIMITED(msg_Function, p_access, format, ...) do {                               \
+        static CCNxVLCLogLimit _limit;                                                       \
+        unsigned _suppressed;                                                                \
+        if (ccnxVLCLogLimit_Allow(&_limit, ccnxVLCUtils_NowMicroseconds(),                   \
+                                  _LOG_LIMIT_INTERVAL_US, &_suppressed)) {                   \
+            if (_suppressed > 0) {                                                           \
+                msg_Function(p_access, format " (%u more since suppressed)", __VA_ARGS__,    \
+                             _suppressed);                                                   \
+            } else {                                                                         \
+                msg_Function(p_access, format, __VA_ARGS__);                                 \
+            }                                                                                \
+        }                                                                                    \
+    } while (0)
+
 /*****************************************************************************
  * Disable internationalization
  *****************************************************************************/
@@ -93,6 +146,117 @@
 #define SEEKABLE_LONGTEXT N_(               \
 "Enable or disable seeking within a CCN stream.")
 
+#define WINDOW_TEXT N_("Pipeline window")
+#define WINDOW_LONGTEXT N_(                 \
+"Number of chunks ahead of the playback position that may be requested. This is " \
+"also the largest congestion window.")
+
+#define CONGESTION_TEXT N_("Congestion control")
+#define CONGESTION_LONGTEXT N_(             \
+"How the number of outstanding Interests adapts: \"aimd\" (slow start and " \
+"additive increase / multiplicative decrease), \"delay\" (AIMD that also backs " \
+"off as the RTT rises) or \"fixed\" (always use the full pipeline window).")
+
+#define RETRIES_TEXT N_("Interest retransmissions")
+#define RETRIES_LONGTEXT N_(                \
+"How many times an unanswered chunk Interest is retransmitted before the read " \
+"fails. The retransmission timeout adapts to the measured round trip time.")
+
+#define READAHEAD_TEXT N_("Read-ahead chunks")
+#define READAHEAD_LONGTEXT N_(              \
+"Number of received chunks the fetch thread buffers ahead of the demuxer.")
+
+#define BLOCKSIZE_TEXT N_("Maximum block size (KiB)")
+#define BLOCKSIZE_LONGTEXT N_(              \
+"Consecutive chunks that have already arrived are returned to VLC together, " \
+"in blocks of up to this many kibibytes.")
+
+#define CHUNKED_TEXT N_("Chunked flow")
+#define CHUNKED_LONGTEXT N_(                \
+"While a stream plays straight through, let the transport's flow controller " \
+"fetch its chunks, on a Portal of its own in chunked mode. After a seek, chunks " \
+"are fetched in message mode until reading settles, then a new flow starts from " \
+"there. Needs {chunk} to be the last segment of the name schema.")
+
+#define CACHE_TEXT N_("Chunk cache size (MB)")
+#define CACHE_LONGTEXT N_(                  \
+"Recently received chunks are kept in memory, up to this many megabytes, so " \
+"that seeking back to them does not go to the network. The cache is shared by " \
+"every stream in the process, so players showing the same content fetch each " \
+"chunk once; its size is the largest any open stream asks for. 0 disables the cache.")
+
+#define DISKCACHE_TEXT N_("Disk cache directory")
+#define DISKCACHE_LONGTEXT N_(              \
+"If set, received chunks are also stored in this directory, one file per title, " \
+"so that playing the title again reads them from disk instead of the network, " \
+"even after a restart. Not used with adaptive layers.")
+
+#define DISKCACHESIZE_TEXT N_("Disk cache size (MB)")
+#define DISKCACHESIZE_LONGTEXT N_(          \
+"The most space the disk cache directory may take. The least recently played " \
+"titles are deleted to make room for a new one.")
+
+#define MANIFEST_TEXT N_("Manifest name schema")
+#define MANIFEST_LONGTEXT N_(               \
+"If set, the name schema of a manifest listing the byte offset of every chunk, " \
+"fetched when the stream is opened, for producers whose chunks vary in size. " \
+"It uses the same variables as the name schema, e.g. /manifest/{path}/{chunk}.")
+
+#define PREFETCH_TEXT N_("Chunks prefetched at open")
+#define PREFETCH_LONGTEXT N_(               \
+"Number of chunks from the start and from the end of the content requested in " \
+"parallel when the stream is opened, where demuxers look for headers and " \
+"indexes. The chunks from the end are only kept if the chunk cache is enabled.")
+
+#define PREFIXES_TEXT N_("Prefixes")
+#define PREFIXES_LONGTEXT N_(               \
+"The prefixes of the producers holding a replica of the content, separated " \
+"by commas, e.g. ccnx:/site1/video,ccnx:/site2/video. Interests are spread " \
+"over them according to how quickly and reliably each answers, and move off " \
+"one that stops answering. Also accepted as an option of the MRL, e.g. " \
+":ccn-prefixes=... . By default ccnx:/ccnx/tutorial alone.")
+
+#define SCHEMA_TEXT N_("Name schema")
+#define SCHEMA_LONGTEXT N_(                 \
+"How the name of each chunk Interest is built after the prefix. {path} is " \
+"replaced by the segments of the MRL path, {chunk} by the chunk number, " \
+"and {frame} and {layers} by the values below.")
+
+#define FRAME_TEXT N_("Frame")
+#define FRAME_LONGTEXT N_(                  \
+"Value of {frame} in the name schema.")
+
+#define LAYERS_TEXT N_("Layers")
+#define LAYERS_LONGTEXT N_(                 \
+"Value of {layers} in the name schema: the number of layers of a scalable " \
+"stream to request.")
+
+#define ADAPTIVE_TEXT N_("Adaptive layers")
+#define ADAPTIVE_LONGTEXT N_(               \
+"Request fewer layers when the network cannot keep up with playback, and more " \
+"again once it can, between 1 and the number of layers above. The chunk size, " \
+"content size and chunk offsets are learned from the first chunk, so every " \
+"number of layers must be published with the same chunk boundaries.")
+
+#define STATSINTERVAL_TEXT N_("Statistics interval (s)")
+#define STATSINTERVAL_LONGTEXT N_(          \
+"How often to log the percentiles of Interest RTT, block latency, read-ahead " \
+"depth and stall time since the stream opened, in seconds. 0 disables the " \
+"summary.")
+
+#define STATSFILE_TEXT N_("Statistics file")
+#define STATSFILE_LONGTEXT N_(              \
+"If set, the histograms behind the statistics summary are appended to this " \
+"file as one line of JSON per stream when it closes, and whenever its " \
+"ccn-dump-stats variable is triggered. Otherwise they go to the debug log.")
+
+#define TRACE_TEXT N_("Trace file")
+#define TRACE_LONGTEXT N_(                  \
+"If set, the lifetime of every chunk (Interest sent and retransmitted, " \
+"ContentObject received, handed to VLC), cache hits, stalls and seeks are " \
+"written to this file as a Chrome trace, which chrome://tracing and " \
+"ui.perfetto.dev open. The file is overwritten whenever a stream opens.")
+
 static int  _CCNxOpen(vlc_object_t *);
 static void _CCNxClose(vlc_object_t *);
 
@@ -103,6 +267,25 @@ vlc_module_begin();
     set_subcategory(SUBCAT_INPUT_ACCESS);
 
     add_bool("ccn-streams-seekable", true, SEEKABLE_TEXT, SEEKABLE_LONGTEXT, true )
+    add_integer("ccn-pipeline-window", 16, WINDOW_TEXT, WINDOW_LONGTEXT, true )
+    add_string("ccn-congestion-control", "aimd", CONGESTION_TEXT, CONGESTION_LONGTEXT, true )
+    add_integer("ccn-interest-retries", 4, RETRIES_TEXT, RETRIES_LONGTEXT, true )
+    add_bool("ccn-chunked-flow", false, CHUNKED_TEXT, CHUNKED_LONGTEXT, true )
+    add_integer("ccn-readahead", 64, READAHEAD_TEXT, READAHEAD_LONGTEXT, true )
+    add_integer("ccn-block-size", 256, BLOCKSIZE_TEXT, BLOCKSIZE_LONGTEXT, true )
+    add_integer("ccn-cache-size", 32, CACHE_TEXT, CACHE_LONGTEXT, true )
+    add_string("ccn-disk-cache-dir", "", DISKCACHE_TEXT, DISKCACHE_LONGTEXT, true )
+    add_integer("ccn-disk-cache-size", 2048, DISKCACHESIZE_TEXT, DISKCACHESIZE_LONGTEXT, true )
+    add_integer("ccn-prefetch-chunks", 32, PREFETCH_TEXT, PREFETCH_LONGTEXT, true )
+    add_string("ccn-manifest-schema", "", MANIFEST_TEXT, MANIFEST_LONGTEXT, true )
+    add_string("ccn-prefixes", "", PREFIXES_TEXT, PREFIXES_LONGTEXT, true )
+    add_string("ccn-name-schema", CCNxVLCNameTemplate_DefaultSchema, SCHEMA_TEXT, SCHEMA_LONGTEXT, true )
+    add_integer("ccn-frame", 50, FRAME_TEXT, FRAME_LONGTEXT, true )
+    add_integer("ccn-layers", 4, LAYERS_TEXT, LAYERS_LONGTEXT, true )
+    add_bool("ccn-adaptive-layers", false, ADAPTIVE_TEXT, ADAPTIVE_LONGTEXT, true )
+    add_integer("ccn-stats-interval", 10, STATSINTERVAL_TEXT, STATSINTERVAL_LONGTEXT, true )
+    add_string("ccn-stats-file", "", STATSFILE_TEXT, STATSFILE_LONGTEXT, true )
+    add_string("ccn-trace-file", "", TRACE_TEXT, TRACE_LONGTEXT, true )
 
     change_safe();
     set_capability("access", 0);
@@ -111,261 +294,1865 @@ vlc_module_begin();
     set_callbacks(_CCNxOpen, _CCNxClose);
 vlc_module_end();
 
-// The prefix of the name that we'll use for our Interests. "ccnx:/cnx/tutorial" is
-// what the tutorial_Server listens for, and we're using that to serve our movies.
-static const char *_domainPrefix = "ccnx:/ccnx/tutorial"; // because we're using tutorial_Server
+// The prefix of the name that we'll use for our Interests, unless the ccn-prefixes option
+// lists others. "ccnx:/cnx/tutorial" is what the tutorial_Server listens for, and we're
+// using that to serve our movies.
+static const char *_domainPrefix = "ccnx:/ccnx/tutorial"; // because we're using tutorial_Server
+
+// How long the fetch thread waits on the portal before checking whether it should stop.
+#define _FETCH_POLL_INTERVAL_US 100000
+
+// The pipeline window used to fetch a manifest.
+#define _MANIFEST_WINDOW 16
+
+// How many chunks the fetch thread must read in sequence before it starts a chunked flow,
+// so that a demuxer hopping around the file doesn't start one for every hop.
+#define _CHUNKED_FLOW_START_RUN 8
+
+// How far ahead of a chunked flow the fetch thread may move, having found chunks in the
+// cache, before the flow is abandoned rather than waited for.
+#define _CHUNKED_FLOW_MAX_SKIP 16
+
+// How long a chunked flow may deliver nothing before we fall back to message mode.
+#define _CHUNKED_FLOW_STALL_US 4000000
+
+// How many events each thread's trace buffer holds before it is written out, while tracing.
+#define _TRACE_EVENTS_PER_THREAD 65536
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+struct access_sys_t
+{
+    // The stream and fetcher are only used by the fetch thread once it has started.
+    CCNxVLCDispatcher *dispatcher; // Owns the one Portal shared by every stream of the process
+    CCNxVLCDispatcherStream *stream; // Our Interests, and the ContentObjects answering them
+    CCNxName **prefixes;           // The prefixes of the replicas of the content; the first names it in the caches
+    size_t prefixCount;
+    CCNxVLCNameTemplate **nameTemplates; // Build the names of our Interests under each prefix; only the chunk number varies
+    CCNxVLCPrefixSelector *prefixSelector; // Spreads the fetcher's Interests over the prefixes, or NULL if there is one
+    uint64_t prefixFailovers;      // Times a prefix was found down, as last logged by the fetch thread
+    CCNxVLCFetcher *fetcher;       // Keeps a window of chunk Interests outstanding on the stream
+    vlc_thread_t fetchThread;      // Fills the read-ahead queue from the fetcher
+    CCNxPortalFactory *portalFactory; // Creates the Portal of each chunked flow, or NULL if they are disabled
+    CCNxVLCChunkedFlow *flow;      // Delivers chunks while reading is sequential, or NULL in message mode
+    uint64_t sequentialChunk;      // The chunk after the last one the fetch thread retrieved
+    uint64_t sequentialRun;        // How many chunks the fetch thread has retrieved in sequence
+    uint64_t flowsStarted;         // Chunked flows started by the fetch thread
+    uint64_t flowChunks;           // Chunks delivered by the chunked flows since stopped
+    size_t maxBlockSize;           // _CCNxBlock stops adding chunks to a block beyond this many bytes
+    mtime_t lastStatsLog;          // When the stats were last written to the debug log
+    uint64_t interestsCreated;     // Interests created by _createInterestForChunk
+    int64_t interestAllocations;   // parcMemory allocations held by those Interests when created
+
+    // Consecutive received chunks, oldest first. The fetch thread adds them at the tail with
+    // p_sys->lock held, so that a chunk from before a seek can't get in after it, and
+    // _CCNxBlock takes them from the head without the lock.
+    CCNxVLCChunkRing *readAhead;
+    size_t readAheadSize;          // The fetch thread stops adding chunks at this many
+    CCNxVLCChunkDescriptor *blockChunks; // The chunks _CCNxBlock is making a block of, readAheadSize long
+    atomic_bool fetchWaiting;      // The fetch thread is waiting on fetchWake; see _signalRoom()
+
+    vlc_mutex_t lock;              // Protects everything below
+    vlc_cond_t  dataReady;         // Signalled when a chunk is queued or fetching stops
+    vlc_cond_t  fetchWake;         // Signalled when the fetch thread may have work to do
+    bool blockWaiting;             // _CCNxBlock is waiting on dataReady
+
+    uint64_t fetchChunk;           // The next chunk the fetch thread will retrieve
+    unsigned fetchGeneration;      // Incremented whenever _CCNxBlock moves fetchChunk
+    bool fetchStopped;             // The fetcher reached the end of the content, or failed
+    bool fetchFailed;              // The fetcher failed
+    bool paused;                   // VLC has paused playback; don't fetch more
+    bool closing;                  // _CCNxClose wants the fetch thread to exit
+
+    CCNxVLCChunkCache *cache;      // The process-wide cache of received chunks, or NULL if disabled
+    size_t cacheCapacity;          // The capacity we asked the shared cache for
+    CCNxVLCDiskCache *diskCache;   // This title's chunks on disk, or NULL if disabled
+
+    uint64_t chunkSize;            // Payload size of the first chunk, learned at open; all but the final one match it
+    bool chunkSizeWarned;          // We have logged a chunk whose size doesn't match chunkSize
+    CCNxVLCManifest *manifest;     // Where each chunk starts, or NULL if every chunk is chunkSize bytes
+    uint64_t contentSize;          // Size of the content in bytes, or 0 if the producer didn't say
+
+    CCNxVLCRateAdapter *rateAdapter; // Chooses {layers} for the fetch thread, or NULL if disabled
+    atomic_uint_least64_t bytesConsumed; // Payload bytes _CCNxBlock has taken from the read-ahead queue
+
+    CCNxVLCFetcherStats stats;     // Fetcher and congestion control state, refreshed by the fetch thread
+
+    // Recorded without a lock by the thread named, and read by any. All NULL if they could
+    // not be allocated.
+    CCNxVLCHistogram *rttHistogram;     // Interest RTTs in us, by the fetcher
+    CCNxVLCHistogram *latencyHistogram; // How long each _CCNxBlock call took in us, by _CCNxBlock
+    CCNxVLCHistogram *depthHistogram;   // Chunks in the read-ahead queue at each _CCNxBlock call, by _CCNxBlock
+    CCNxVLCHistogram *stallHistogram;   // How long _CCNxBlock waited for the fetch thread in us, by _CCNxBlock
+    mtime_t statsInterval;         // How often _CCNxBlock logs a summary of the histograms, or 0 for never
+    mtime_t lastStatsSummary;      // When _CCNxBlock last did
+    char *statsFile;               // Where _dumpStatistics() appends the histograms, or NULL for the debug log
+
+    CCNxVLCTrace *trace;           // The ccn-trace-file trace, or NULL if not tracing
+    CCNxVLCTraceBuffer *fetchTrace; // Recorded into by the fetch thread, and the fetcher; NULL if not tracing
+    CCNxVLCTraceBuffer *blockTrace; // Recorded into by _CCNxBlock and _CCNxSeek; NULL if not tracing
+};
+
+/**
+ * Write the fetcher and congestion control state to the debug log.
+ */
+static void
+_logFetcherStats(access_t *p_access, const CCNxVLCFetcherStats *stats)
+{
+    msg_Dbg(p_access, "fetcher: cwnd %.2f ssthresh %.2f srtt %"PRIu64"us rttvar %"PRIu64"us "
+                      "rto %"PRIu64"us minrtt %"PRIu64"us outstanding %zu sent %"PRIu64" "
+                      "received %"PRIu64" discarded %"PRIu64" retransmitted %"PRIu64" failed %"PRIu64" "
+                      "gaps %"PRIu64" timeouts %"PRIu64" decreases %"PRIu64,
+            stats->congestion.cwnd, stats->congestion.ssthresh,
+            stats->congestion.srttUs, stats->congestion.rttvarUs,
+            stats->congestion.rtoUs, stats->congestion.minRttUs,
+            stats->outstanding, stats->interestsSent, stats->contentObjectsReceived,
+            stats->contentObjectsDiscarded, stats->retransmissions, stats->failures,
+            stats->congestion.gapEvents, stats->congestion.timeouts, stats->congestion.decreases);
+}
+
+/**
+ * Release whichever of the histograms were created. The fetcher must not record into them
+ * again.
+ */
+static void
+_releaseStatistics(access_sys_t *p_sys)
+{
+    CCNxVLCHistogram **histograms[] = {
+        &p_sys->rttHistogram, &p_sys->latencyHistogram, &p_sys->depthHistogram, &p_sys->stallHistogram
+    };
+    for (size_t i = 0; i < sizeof(histograms) / sizeof(histograms[0]); i++) {
+        if (*histograms[i] != NULL) {
+            ccnxVLCHistogram_Release(histograms[i]);
+        }
+    }
+    free(p_sys->statsFile);
+    p_sys->statsFile = NULL;
+}
+
+/**
+ * Create the histograms behind the statistics, and have the fetcher record its RTTs in one.
+ * They only help diagnose playback, so without them the stream plays on unmeasured.
+ */
+static void
+_createStatistics(access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    p_sys->rttHistogram = ccnxVLCHistogram_Create();
+    p_sys->latencyHistogram = ccnxVLCHistogram_Create();
+    p_sys->depthHistogram = ccnxVLCHistogram_Create();
+    p_sys->stallHistogram = ccnxVLCHistogram_Create();
+    if (p_sys->rttHistogram == NULL || p_sys->latencyHistogram == NULL
+        || p_sys->depthHistogram == NULL || p_sys->stallHistogram == NULL) {
+        msg_Warn(p_access, "_CCNxOpen: could not create statistics, continuing without them");
+        _releaseStatistics(p_sys);
+        return;
+    }
+    ccnxVLCFetcher_SetRttHistogram(p_sys->fetcher, p_sys->rttHistogram);
+
+    int64_t statsIntervalSeconds = var_InheritInteger(p_access, "ccn-stats-interval");
+    p_sys->statsInterval = (statsIntervalSeconds > 0) ? statsIntervalSeconds * CLOCK_FREQ : 0;
+    p_sys->lastStatsSummary = mdate();
+
+    p_sys->statsFile = var_InheritString(p_access, "ccn-stats-file");
+    if (p_sys->statsFile != NULL && p_sys->statsFile[0] == '\0') {
+        free(p_sys->statsFile);
+        p_sys->statsFile = NULL;
+    }
+}
+
+static void
+_recordStatistic(CCNxVLCHistogram *histogram, uint64_t value)
+{
+    if (histogram != NULL) {
+        ccnxVLCHistogram_Record(histogram, value);
+    }
+}
+
+/**
+ * Log one line of percentiles from the histograms, since the stream opened.
+ */
+static void
+_logStatisticsSummary(access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    CCNxVLCHistogramSummary rtt, latency, depth, stalls;
+    ccnxVLCHistogram_GetSummary(p_sys->rttHistogram, &rtt);
+    ccnxVLCHistogram_GetSummary(p_sys->latencyHistogram, &latency);
+    ccnxVLCHistogram_GetSummary(p_sys->depthHistogram, &depth);
+    ccnxVLCHistogram_GetSummary(p_sys->stallHistogram, &stalls);
+
+    msg_Info(p_access, "statistics: rtt p50 %"PRIu64" p99 %"PRIu64" us; %"PRIu64" blocks, latency p50 %"PRIu64
+                       " p99 %"PRIu64" us; read-ahead mean %.1f p50 %"PRIu64" min %"PRIu64" chunks; "
+                       "%"PRIu64" stalls, p50 %"PRIu64" p99 %"PRIu64" max %"PRIu64" us",
+             rtt.p50, rtt.p99, latency.count, latency.p50, latency.p99,
+             depth.mean, depth.p50, depth.min,
+             stalls.count, stalls.p50, stalls.p99, stalls.max);
+}
+
+/**
+ * Write `string` to `file` as a JSON string, quotes included.
+ */
+static void
+_writeJSONString(FILE *file, const char *string)
+{
+    fputc('"', file);
+    for (const unsigned char *c = (const unsigned char *) string; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(file, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(file, "\\u%04x", *c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+/**
+ * Write the histograms as one JSON object to the statistics file, or the debug log if there
+ * isn't one. `reason` says what asked for them. Takes no lock, so may be called from any
+ * thread while the stream plays.
+ */
+static void
+_dumpStatistics(access_t *p_access, const char *reason)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if (p_sys->rttHistogram == NULL) {
+        return;
+    }
+
+    char *json = NULL;
+    size_t length = 0;
+    FILE *stream = open_memstream(&json, &length);
+    if (stream == NULL) {
+        return;
+    }
+    fprintf(stream, "{\"location\":");
+    _writeJSONString(stream, p_access->psz_location);
+    fprintf(stream, ",\"reason\":\"%s\",\"time\":%"PRId64",\"rttUs\":", reason, (int64_t) time(NULL));
+    ccnxVLCHistogram_WriteJSON(p_sys->rttHistogram, stream);
+    fprintf(stream, ",\"blockLatencyUs\":");
+    ccnxVLCHistogram_WriteJSON(p_sys->latencyHistogram, stream);
+    fprintf(stream, ",\"readAheadChunks\":");
+    ccnxVLCHistogram_WriteJSON(p_sys->depthHistogram, stream);
+    fprintf(stream, ",\"stallUs\":");
+    ccnxVLCHistogram_WriteJSON(p_sys->stallHistogram, stream);
+    fprintf(stream, "}");
+    bool failed = ferror(stream);
+    fclose(stream);
+
+    if (failed) {
+        msg_Warn(p_access, "_dumpStatistics: out of memory");
+    } else if (p_sys->statsFile != NULL) {
+        // One write per object, so lines from streams closing together don't interleave.
+        // open_memstream() leaves room for a NUL after the text, which becomes the newline.
+        json[length] = '\n';
+        FILE *file = fopen(p_sys->statsFile, "a");
+        if (file == NULL || fwrite(json, 1, length + 1, file) != length + 1) {
+            msg_Warn(p_access, "_dumpStatistics: could not write to %s", p_sys->statsFile);
+        }
+        if (file != NULL) {
+            fclose(file);
+        }
+    } else {
+        msg_Dbg(p_access, "statistics: %s", json);
+    }
+    free(json);
+}
+
+/**
+ * Called when something (e.g. a Lua script) triggers the stream's ccn-dump-stats variable.
+ */
+static int
+_dumpStatisticsCallback(vlc_object_t *p_this, char const *psz_var,
+                        vlc_value_t oldval, vlc_value_t newval, void *p_data)
+{
+    _dumpStatistics((access_t *) p_data, "request");
+    return VLC_SUCCESS;
+}
+
+/**
+ * If the "ccn-trace-file" option is set, start tracing into it, with one buffer for the fetch
+ * thread (which the fetcher records into too) and one for the thread VLC reads on. Like the
+ * statistics, the stream plays on untraced if that fails.
+ */
+static void
+_createTrace(access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    char *path = var_InheritString(p_access, "ccn-trace-file");
+    if (path == NULL || path[0] == '\0') {
+        free(path);
+        return;
+    }
+
+    p_sys->trace = ccnxVLCTrace_Create(path, p_access->psz_location);
+    if (p_sys->trace != NULL) {
+        p_sys->fetchTrace = ccnxVLCTrace_AddThread(p_sys->trace, "fetch", _TRACE_EVENTS_PER_THREAD);
+        p_sys->blockTrace = ccnxVLCTrace_AddThread(p_sys->trace, "_CCNxBlock", _TRACE_EVENTS_PER_THREAD);
+        if (p_sys->fetchTrace == NULL || p_sys->blockTrace == NULL) {
+            ccnxVLCTrace_Release(&p_sys->trace);
+            p_sys->fetchTrace = NULL;
+            p_sys->blockTrace = NULL;
+        }
+    }
+    if (p_sys->trace == NULL) {
+        msg_Warn(p_access, "_CCNxOpen: could not trace to %s, continuing without it", path);
+    } else {
+        msg_Dbg(p_access, "_CCNxOpen: tracing to %s", path);
+        ccnxVLCFetcher_SetTraceBuffer(p_sys->fetcher, p_sys->fetchTrace);
+    }
+    free(path);
+}
+
+/**
+ * Finish the trace, if there is one. Nothing may record into it again, so the fetcher
+ * (which records abandoned Interests as it is released) must already be gone.
+ */
+static void
+_releaseTrace(access_sys_t *p_sys)
+{
+    if (p_sys->trace != NULL) {
+        ccnxVLCTrace_Release(&p_sys->trace);
+        p_sys->fetchTrace = NULL;
+        p_sys->blockTrace = NULL;
+    }
+}
+
+
+/**
+ * Return the CCnxPortalFactory shared by every stream, supplying some default credentials.
+ * Only the first stream opened pays for loading (or, the very first time, generating) the
+ * keystore.
+ */
+static CCNxPortalFactory *
+_setupPortalFactory(void)
+{
+    const char *keystoreName = "vlc-ccnx-keystore";
+    const char *keystorePassword = "keystore_password";
+    const char *subjectName = keystoreName;
+
+    return ccnxVLCUtils_AcquireSharedPortalFactory(keystoreName, keystorePassword, subjectName);
+}
+
+/**
+ * Detach from the dispatcher, closing the shared Portal if we were its last user.
+ */
+static void
+_releaseStream(access_sys_t *p_sys)
+{
+    ccnxVLCDispatcherStream_Release(&p_sys->stream);
+    ccnxVLCDispatcher_Release(&p_sys->dispatcher);
+}
+
+/**
+ * Set a numeric variable of the name template from a module option.
+ */
+static int
+_setNameVariableFromOption(access_t *p_access, CCNxVLCNameTemplate *nameTemplate,
+                           const char *variable, const char *option)
+{
+    char value[32];
+    snprintf(value, sizeof(value), "%"PRId64, var_InheritInteger(p_access, option));
+
+    return ccnxVLCNameTemplate_SetVariable(nameTemplate, variable, value);
+}
+
+/**
+ * Build a name template from `schema`, following `prefix`, with its variables set from our
+ * options.
+ *
+ * @return a CCNxVLCNameTemplate instance, or NULL if the schema is invalid or memory could not
+ *         be allocated. This instance must eventually be released by calling ccnxVLCNameTemplate_Release().
+ */
+static CCNxVLCNameTemplate *
+_createNameTemplateFromSchema(access_t *p_access, const CCNxName *prefix, const char *schema, const char *fileName)
+{
+    CCNxVLCNameTemplate *result = ccnxVLCNameTemplate_Create(prefix, schema, fileName);
+
+    if (result == NULL) {
+        msg_Err(p_access, "_createNameTemplateFromSchema: invalid name schema '%s'", schema);
+        return NULL;
+    }
+
+    if (_setNameVariableFromOption(p_access, result, "frame", "ccn-frame") != 0
+        || _setNameVariableFromOption(p_access, result, "layers", "ccn-layers") != 0) {
+        ccnxVLCNameTemplate_Release(&result);
+        return NULL;
+    }
+
+    const char *unset = ccnxVLCNameTemplate_GetUnsetVariable(result);
+    if (unset != NULL) {
+        msg_Err(p_access, "_createNameTemplateFromSchema: name schema '%s' uses unknown variable {%s}", schema, unset);
+        ccnxVLCNameTemplate_Release(&result);
+        return NULL;
+    }
+
+    return result;
+}
+
+/**
+ * Release the `count` name templates of `templates`, and the array.
+ */
+static void
+_releaseNameTemplates(CCNxVLCNameTemplate **templates, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (templates[i] != NULL) {
+            ccnxVLCNameTemplate_Release(&templates[i]);
+        }
+    }
+    free(templates);
+}
+
+/**
+ * Build a name template from `schema` for each of our prefixes, in the same order.
+ *
+ * @return an array of p_sys->prefixCount templates, or NULL if the schema is invalid or
+ *         memory could not be allocated. It must eventually be released by calling
+ *         _releaseNameTemplates().
+ */
+static CCNxVLCNameTemplate **
+_createNameTemplatesFromSchema(access_t *p_access, const char *schema, const char *fileName)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    CCNxVLCNameTemplate **result = calloc(p_sys->prefixCount, sizeof(CCNxVLCNameTemplate *));
+    if (result == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < p_sys->prefixCount; i++) {
+        result[i] = _createNameTemplateFromSchema(p_access, p_sys->prefixes[i], schema, fileName);
+        if (result[i] == NULL) {
+            _releaseNameTemplates(result, p_sys->prefixCount);
+            return NULL;
+        }
+    }
+    return result;
+}
+
+/**
+ * Build the templates for the names of the chunks of the given file, one per prefix, from
+ * the "ccn-name-schema" option. By default that is the prefix, "fetch", one segment for
+ * each component of the file's path, then the chunk number, the frame ("F50") and the
+ * number of layers ("L4").
+ *
+ * @param p_access - the VLC access_t structure
+ * @param fileName - the name of the file (movie) from which to retrieve blocks. It is not modified.
+ *
+ * @return an array of p_sys->prefixCount templates, or NULL if the schema is invalid or
+ *         memory could not be allocated. It must eventually be released by calling
+ *         _releaseNameTemplates().
+ */
+static CCNxVLCNameTemplate **
+_createNameTemplates(access_t *p_access, const char *fileName)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    char *schema = var_InheritString(p_access, "ccn-name-schema");
+    if (schema == NULL) {
+        schema = strdup(CCNxVLCNameTemplate_DefaultSchema);
+        if (schema == NULL) {
+            return NULL;
+        }
+    }
+
+    CCNxVLCNameTemplate **result = _createNameTemplatesFromSchema(p_access, schema, fileName);
+    free(schema);
+
+    for (size_t i = 0; result != NULL && i < p_sys->prefixCount; i++) {
+        CCNxName *firstName = ccnxVLCNameTemplate_CreateName(result[i], 0);
+        char *stringName = ccnxName_ToString(firstName);
+        msg_Info(p_access, "_createNameTemplates first chunk = %s", stringName);
+        parcMemory_Deallocate(&stringName);
+        ccnxName_Release(&firstName);
+    }
+
+    return result;
+}
+
+/**
+ * Release our prefixes, with their name templates and selector.
+ */
+static void
+_releasePrefixes(access_sys_t *p_sys)
+{
+    if (p_sys->prefixSelector != NULL) {
+        ccnxVLCPrefixSelector_Release(&p_sys->prefixSelector);
+    }
+    if (p_sys->nameTemplates != NULL) {
+        _releaseNameTemplates(p_sys->nameTemplates, p_sys->prefixCount);
+        p_sys->nameTemplates = NULL;
+    }
+    for (size_t i = 0; i < p_sys->prefixCount; i++) {
+        ccnxName_Release(&p_sys->prefixes[i]);
+    }
+    free(p_sys->prefixes);
+    p_sys->prefixes = NULL;
+    p_sys->prefixCount = 0;
+}
+
+/**
+ * Parse the "ccn-prefixes" option into p_sys->prefixes, skipping (with a warning) any that
+ * is not a valid name. Without the option, the domain prefix alone is used.
+ *
+ * @return true if there is at least one prefix.
+ */
+static bool
+_parsePrefixes(access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    char *list = var_InheritString(p_access, "ccn-prefixes");
+    if (list == NULL || strspn(list, ", \t") == strlen(list)) {
+        free(list);
+        list = strdup(_domainPrefix);
+        if (list == NULL) {
+            return false;
+        }
+    }
+
+    // No more prefixes than separated substrings, plus one.
+    size_t capacity = 1;
+    for (const char *c = list; *c != '\0'; c++) {
+        capacity += (strchr(", \t", *c) != NULL);
+    }
+    p_sys->prefixes = calloc(capacity, sizeof(CCNxName *));
+    if (p_sys->prefixes == NULL) {
+        free(list);
+        return false;
+    }
+
+    char *savePtr = NULL;
+    for (char *token = strtok_r(list, ", \t", &savePtr);
+         token != NULL && p_sys->prefixCount < capacity;
+         token = strtok_r(NULL, ", \t", &savePtr)) {
+        CCNxName *prefix = ccnxName_CreateFromCString(token);
+        if (prefix == NULL) {
+            msg_Warn(p_access, "_parsePrefixes: ignoring invalid prefix '%s'", token);
+            continue;
+        }
+        p_sys->prefixes[p_sys->prefixCount++] = prefix;
+    }
+    free(list);
+
+    return p_sys->prefixCount > 0;
+}
+
+/**
+ * Set up the prefixes we fetch from, with a name template for each and, if there are
+ * several, the selector spreading Interests over them.
+ *
+ * @return true on success. Otherwise nothing is left to release.
+ */
+static bool
+_createPrefixes(access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if (_parsePrefixes(p_access)) {
+        p_sys->nameTemplates = _createNameTemplates(p_access, p_access->psz_location);
+    }
+    if (p_sys->nameTemplates != NULL && p_sys->prefixCount > 1) {
+        p_sys->prefixSelector = ccnxVLCPrefixSelector_Create(p_sys->prefixCount);
+        if (p_sys->prefixSelector != NULL) {
+            msg_Dbg(p_access, "_createPrefixes: spreading Interests over %zu prefixes", p_sys->prefixCount);
+        }
+    }
+
+    if (p_sys->nameTemplates == NULL || (p_sys->prefixCount > 1 && p_sys->prefixSelector == NULL)) {
+        _releasePrefixes(p_sys);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Return the prefix for Interests that can't be spread over several: the best one.
+ */
+static size_t
+_bestPrefix(const access_sys_t *p_sys)
+{
+    return (p_sys->prefixSelector != NULL) ? ccnxVLCPrefixSelector_GetBest(p_sys->prefixSelector) : 0;
+}
+
+/**
+ * Write what the prefix selector knows about each prefix to the debug log, and warn about
+ * any prefix found down since the last call. Only called from the fetch thread, which owns
+ * the selector through the fetcher, or once it has exited.
+ */
+static void
+_logPrefixStats(access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if (p_sys->prefixSelector == NULL) {
+        return;
+    }
+
+    uint64_t failovers = 0;
+    for (size_t i = 0; i < p_sys->prefixCount; i++) {
+        CCNxVLCPrefixStats stats;
+        ccnxVLCPrefixSelector_GetStats(p_sys->prefixSelector, i, &stats);
+        failovers += stats.failovers;
+    }
+    bool newFailover = (failovers > p_sys->prefixFailovers);
+    p_sys->prefixFailovers = failovers;
+
+    for (size_t i = 0; i < p_sys->prefixCount; i++) {
+        CCNxVLCPrefixStats stats;
+        ccnxVLCPrefixSelector_GetStats(p_sys->prefixSelector, i, &stats);
+        char *prefix = ccnxName_ToString(p_sys->prefixes[i]);
+        if (newFailover && stats.down) {
+            msg_Warn(p_access, "prefix %s stopped answering, moving its Interests to the others", prefix);
+        }
+        msg_Dbg(p_access, "prefix %s: %s, share %.1f%% srtt %"PRIu64"us loss %.1f%% sent %"PRIu64" "
+                          "received %"PRIu64" timeouts %"PRIu64" failovers %"PRIu64,
+                prefix, stats.down ? "down" : "up", stats.share * 100.0, stats.srttUs, stats.loss * 100.0,
+                stats.interestsSent, stats.contentObjectsReceived, stats.timeouts, stats.failovers);
+        parcMemory_Deallocate(&prefix);
+    }
+}
+
+/**
+ * Given a desired chunk number, create and return a CCNxInterest with the appropriate
+ * name required for retrieving that chunk of the file we were opened with.
+ *
+ * Only the chunk number segment is built here; the rest comes from the name template.
+ * The parcMemory allocations still held by the new Interest are added to
+ * p_sys->interestAllocations, so _CCNxClose can report the average per Interest.
+ *
+ * @param p_access - the VLC access_t structure
+ * @param prefix - which of our prefixes to name the chunk under
+ * @param chunkNum - the number of the desired chunk of the file to retrieve
+ * 
+ * @return a CCNxInterest instance with a name suitable for retrieving the desired
+ *         chunk of the specified filed, or NULL if the name could not be made. This
+ *         instance must eventually be released by calling ccnxInterest_Release().
+ */
+static CCNxInterest *
+_createInterestForChunk(access_t *p_access, size_t prefix, uint64_t chunkNum)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    int64_t allocationsBefore = parcMemory_Outstanding();
+
+    CCNxInterest *result = ccnxVLCNameTemplate_CreateInterest(p_sys->nameTemplates[prefix], chunkNum);
+
+    // Only the fetch thread creates Interests, but other threads may allocate in between, so
+    // this is an estimate. It is good enough to compare name building strategies.
+    p_sys->interestAllocations += (int64_t) parcMemory_Outstanding() - allocationsBefore;
+    p_sys->interestsCreated++;
+
+    return result;
+}
+
+
+/**
+ * The CCNxVLCFetcherInterestFactory used by our fetcher. The context is the access_t.
+ */
+static CCNxInterest *
+_createInterestForFetcher(void *context, size_t prefix, uint64_t chunkNum)
+{
+    access_t *p_access = context;
+
+    return _createInterestForChunk(p_access, prefix, chunkNum);
+}
+
+/**
+ * Given the position handed to us by VLC when _ccnxBlock() is called, figure
+ * out which chunk contains it. It looks like the position is just a byte count
+ * so, without a manifest, we just divide by our chunkSize to figure out which
+ * chunk contains it. Every chunk but the final one is chunkSize bytes, so this
+ * also holds for a short final chunk. With a manifest, we look the position up
+ * in it. Positions past the end map to chunks past the final one.
+ * 
+ * @param p_sys - our access_sys_t
+ * @param position - a position (byte offset) of the movie 
+ *
+ * @return - the chunk number corresponding to the positiong offset
+ */
+static uint64_t 
+_calculateChunkForPosition(const access_sys_t *p_sys, uint64_t position)
+{
+    if (p_sys->manifest != NULL) {
+        return ccnxVLCManifest_GetChunkForPosition(p_sys->manifest, position);
+    }
+    if (p_sys->chunkSize == 0) {
+        // Only an empty first chunk has no size, and then there is nothing else to read.
+        return (position == 0) ? 0 : UINT64_MAX;
+    }
+    return position / p_sys->chunkSize;
+}
+
+/**
+ * Return the position (byte offset) of the first byte of the given chunk.
+ *
+ * @param p_sys - our access_sys_t
+ * @param chunkNum - a chunk number
+ *
+ * @return - the position at which `chunkNum` starts
+ */
+static uint64_t
+_calculateChunkOffset(const access_sys_t *p_sys, uint64_t chunkNum)
+{
+    if (p_sys->manifest != NULL) {
+        return ccnxVLCManifest_GetChunkOffset(p_sys->manifest, chunkNum);
+    }
+    return chunkNum * p_sys->chunkSize;
+}
+
+/**
+ * Return the position just past the last byte of the given chunk.
+ */
+static uint64_t
+_calculateChunkEnd(const access_sys_t *p_sys, uint64_t chunkNum)
+{
+    uint64_t end = _calculateChunkOffset(p_sys, chunkNum + 1);
+    return (p_sys->contentSize > 0 && end > p_sys->contentSize) ? p_sys->contentSize : end;
+}
+
+/**
+ * A block_t whose buffer points into the payload of a ContentObject. The block
+ * holds a reference to the ContentObject, which is released with the block.
+ */
+typedef struct {
+    block_t self;
+    CCNxContentObject *contentObject;
+} _CCNxPayloadBlock;
+
+static void
+_releasePayloadBlock(block_t *p_block)
+{
+    _CCNxPayloadBlock *payloadBlock = (_CCNxPayloadBlock *) p_block;
+
+    ccnxContentObject_Release(&payloadBlock->contentObject);
+    free(payloadBlock);
+}
+
+/**
+ * Helper function to create and return a VLC block_t containing the requested
+ * data at position `position`, extracted from the supplied ContentObject.
+ * The block refers directly to the ContentObject's payload; no bytes are copied, so
+ * it must not reach VLC, which may write to it, while anyone else holds the
+ * ContentObject. See `_takeBlock`.
+ *
+ * @param p_access the VLC access structure
+ * @param contentObject the CCNxContentObject instance from which to extract the data
+ * @param chunkOffset the position at which the chunk starts
+ * @param chunkNum the chunk number of the supplied CCNxContentObject
+ * @param position the position of the requested data (from VLC)
+ * @param [out] payloadSize the size of the payload that was in the ContentObject
+ *
+ * @return a block_t containing the requested data, or NULL
+ */
+static block_t *
+_extractRequestedBlock(access_t *p_access, 
+                       CCNxContentObject *contentObject, 
+                       uint64_t chunkOffset, uint64_t chunkNum, 
+                       uint64_t position, size_t *payloadSize)
+{
+    block_t *result = NULL;
+
+    PARCBuffer *payload = ccnxContentObject_GetPayload(contentObject);
+    *payloadSize = parcBuffer_Remaining(payload);
+
+    u_char *rawPayload = parcBuffer_Overlay(payload, 0);
+
+    size_t startOffset = position - chunkOffset;
+    if (startOffset < *payloadSize) {
+        size_t numBytes = *payloadSize - startOffset;
+
+        _CCNxPayloadBlock *payloadBlock = malloc(sizeof(_CCNxPayloadBlock));
+        if (payloadBlock == NULL) {
+            return NULL;
+        }
+
+        block_Init(&payloadBlock->self, rawPayload + startOffset, numBytes);
+        payloadBlock->self.pf_release = _releasePayloadBlock;
+        payloadBlock->contentObject = ccnxContentObject_Acquire(contentObject);
+        result = &payloadBlock->self;
+
+        _LOG_CHUNK(p_access, "Adding %zu bytes from chunk %"PRIu64, numBytes, chunkNum);
+    }
+
+    return result;
+}
+
+/**
+ * Return how many chunks, starting with `chunkNum` which holds `position`, _CCNxBlock needs
+ * to make a block of maxBlockSize bytes, but no more than the read-ahead queue holds.
+ */
+static size_t
+_calculateBlockChunkCount(const access_sys_t *p_sys, uint64_t chunkNum, uint64_t position)
+{
+    if (p_sys->maxBlockSize == 0) {
+        return 1;
+    }
+
+    uint64_t count = _calculateChunkForPosition(p_sys, position + p_sys->maxBlockSize - 1) - chunkNum + 1;
+    return (count < p_sys->readAheadSize) ? (size_t) count : p_sys->readAheadSize;
+}
+
+/**
+ * Take up to `maxCount` consecutive chunks, starting with `chunkNum`, from the head of the
+ * read-ahead queue into `descriptors`. Doesn't need p_sys->lock, as _CCNxBlock is the only
+ * thread taking chunks from the queue, but the caller must let the fetch thread know there
+ * is room, with _signalRoom() or, holding the lock, by signalling fetchWake.
+ */
+static size_t
+_consumeReadAhead(access_sys_t *p_sys, uint64_t chunkNum, CCNxVLCChunkDescriptor *descriptors, size_t maxCount)
+{
+    size_t count = ccnxVLCChunkRing_DequeueRun(p_sys->readAhead, chunkNum, descriptors, maxCount);
+
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        bytes += parcBuffer_Remaining(ccnxContentObject_GetPayload(descriptors[i].contentObject));
+    }
+    atomic_fetch_add(&p_sys->bytesConsumed, bytes);
+
+    return count;
+}
+
+/**
+ * Wake the fetch thread if it is waiting for room in the read-ahead queue, which we have
+ * just made without p_sys->lock. Must be called without p_sys->lock held.
+ */
+static void
+_signalRoom(access_sys_t *p_sys)
+{
+    // The fetch thread sets fetchWaiting before it looks at the queue for the last time, so
+    // with a fence on each side either it sees our room or we see it waiting. Most of the
+    // time it isn't, and we don't touch the lock at all.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&p_sys->fetchWaiting)) {
+        vlc_mutex_lock(&p_sys->lock);
+        vlc_cond_signal(&p_sys->fetchWake);
+        vlc_mutex_unlock(&p_sys->lock);
+    }
+}
+
+/**
+ * Discard every chunk in the read-ahead queue. Must be called with p_sys->lock held, or
+ * once the fetch thread has exited.
+ */
+static void
+_flushReadAhead(access_sys_t *p_sys)
+{
+    CCNxVLCChunkDescriptor descriptor;
+    while (ccnxVLCChunkRing_Dequeue(p_sys->readAhead, &descriptor)) {
+        ccnxContentObject_Release(&descriptor.contentObject);
+    }
+}
+
+/**
+ * Make sure the next chunk out of the read-ahead queue will be `chunkNum`. Chunks before it
+ * are dropped; if it is neither queued nor the next one to be fetched (i.e. we have seeked),
+ * the queue is flushed and the fetch thread is restarted at `chunkNum`.
+ * Must be called with p_sys->lock held.
+ */
+static void
+_positionReadAhead(access_sys_t *p_sys, uint64_t chunkNum)
+{
+    const CCNxVLCChunkDescriptor *head;
+    bool dropped = false;
+    while ((head = ccnxVLCChunkRing_Peek(p_sys->readAhead)) != NULL && head->chunkNumber < chunkNum) {
+        CCNxVLCChunkDescriptor skipped;
+        ccnxVLCChunkRing_Dequeue(p_sys->readAhead, &skipped);
+        ccnxContentObject_Release(&skipped.contentObject);
+        dropped = true;
+    }
+
+    // After a failure we always restart, so a transient portal error is retried.
+    bool queued = head != NULL && head->chunkNumber == chunkNum;
+    bool nextToFetch = head == NULL && p_sys->fetchChunk == chunkNum && !p_sys->fetchFailed;
+
+    if (!queued && !nextToFetch) {
+        _flushReadAhead(p_sys);
+        p_sys->fetchChunk = chunkNum;
+        p_sys->fetchGeneration++;
+        p_sys->fetchStopped = false;
+        p_sys->fetchFailed = false;
+        vlc_cond_signal(&p_sys->fetchWake);
+    } else if (dropped) {
+        vlc_cond_signal(&p_sys->fetchWake);
+    }
+}
+
+/**
+ * Look `chunkNum` up in the shared cache, under the names we would request it by now, so
+ * that chunks of another variant (e.g. a different number of layers) don't match. The
+ * cache holds each chunk under the prefix it arrived from, so we try each. Reads the name
+ * templates, so must be called from the fetch thread or with p_sys->lock held.
+ */
+static CCNxContentObject *
+_getCachedChunk(access_sys_t *p_sys, uint64_t chunkNum)
+{
+    CCNxContentObject *result = NULL;
+
+    for (size_t i = 0; i < p_sys->prefixCount && result == NULL; i++) {
+        CCNxName *name = ccnxVLCNameTemplate_CreateName(p_sys->nameTemplates[i], chunkNum);
+        if (name != NULL) {
+            result = ccnxVLCChunkCache_Get(p_sys->cache, name);
+            ccnxName_Release(&name);
+        }
+    }
+    return result;
+}
+
+/**
+ * Write a received chunk to the disk cache, if there is one and the chunk isn't there yet.
+ * A chunk whose size doesn't match the layout of the content is left out, rather than
+ * overwriting its neighbours. Only reads state that is fixed once the stream is open, so
+ * may be called without p_sys->lock.
+ */
+static void
+_storeChunkOnDisk(access_sys_t *p_sys, uint64_t chunkNum, CCNxContentObject *contentObject)
+{
+    if (p_sys->diskCache == NULL || ccnxVLCDiskCache_HasChunk(p_sys->diskCache, chunkNum)) {
+        return;
+    }
+
+    PARCBuffer *payload = ccnxContentObject_GetPayload(contentObject);
+    uint64_t offset = _calculateChunkOffset(p_sys, chunkNum);
+    if (parcBuffer_Remaining(payload) == _calculateChunkEnd(p_sys, chunkNum) - offset) {
+        ccnxVLCDiskCache_PutChunk(p_sys->diskCache, chunkNum, offset,
+                                  parcBuffer_Overlay(payload, 0), parcBuffer_Remaining(payload));
+    }
+}
+
+/**
+ * Return a block VLC may write to in place of `p_block`, a block made by
+ * `block_ChainGather`. A gathered chain is already a copy. A single chunk still
+ * points into its ContentObject's payload, which may have other holders: the chunk
+ * cache, and every other stream the shared dispatcher delivered the same
+ * ContentObject to. So it is copied here.
+ */
+static block_t *
+_takeBlock(block_t *p_block)
+{
+    if (p_block == NULL || p_block->pf_release != _releasePayloadBlock) {
+        return p_block;
+    }
+    block_t *result = block_Alloc(p_block->i_buffer);
+    if (result != NULL) {
+        memcpy(result->p_buffer, p_block->p_buffer, p_block->i_buffer);
+    }
+    block_Release(p_block);
+    return result;
+}
+
+/**
+ * Return a block holding the bytes from the current position to the end of the run of
+ * consecutive chunks present in the disk cache, stopping at the first chunk that reaches
+ * maxBlockSize, copied from the mapped file. VLC may modify the blocks we give it, so they
+ * can't point into the read-only mapping, any more than into a shared ContentObject.
+ * `chunkNum` holds the current position and must be present.
+ */
+static block_t *
+_readBlockFromDisk(access_t *p_access, uint64_t chunkNum)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    uint64_t start = p_access->info.i_pos;
+    uint64_t end = _calculateChunkEnd(p_sys, chunkNum);
+
+    while (end - start < p_sys->maxBlockSize && end < p_sys->contentSize
+           && ccnxVLCDiskCache_HasChunk(p_sys->diskCache, chunkNum + 1)) {
+        chunkNum++;
+        end = _calculateChunkEnd(p_sys, chunkNum);
+    }
+    block_t *result = block_Alloc(end - start);
+    if (result != NULL) {
+        memcpy(result->p_buffer, ccnxVLCDiskCache_GetData(p_sys->diskCache) + start, end - start);
+        p_access->info.i_pos = end;
+        p_access->info.b_eof = (end >= p_sys->contentSize);
+    }
+    return result;
+}
+
+/**
+ * Take the ContentObject for `chunkNum` into `descriptor` if it is already available, without
+ * waiting: from the head of the read-ahead queue, or from the cache. Returns false if the
+ * chunk has not arrived yet. Must be called with p_sys->lock held.
+ */
+static bool
+_takeAvailableChunk(access_sys_t *p_sys, uint64_t chunkNum, CCNxVLCChunkDescriptor *descriptor)
+{
+    if (_consumeReadAhead(p_sys, chunkNum, descriptor, 1) == 1) {
+        vlc_cond_signal(&p_sys->fetchWake);
+        return true;
+    }
+    if (p_sys->cache != NULL) {
+        descriptor->chunkNumber = chunkNum;
+        descriptor->contentObject = _getCachedChunk(p_sys, chunkNum);
+        return descriptor->contentObject != NULL;
+    }
+    return false;
+}
+
+/**
+ * Let the rate adapter pick the number of layers for the following Interests, from the
+ * state of the read-ahead queue. Only called from the fetch thread, which owns the name
+ * template, with p_sys->lock held. The sizes and offsets we learned from chunk 0 still
+ * apply after a switch only because every layer count must share chunk boundaries; see
+ * ADAPTIVE_LONGTEXT.
+ */
+static void
+_adaptLayers(access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    size_t queued = ccnxVLCChunkRing_GetCount(p_sys->readAhead);
+    unsigned previous = ccnxVLCRateAdapter_GetLevel(p_sys->rateAdapter);
+    unsigned layers = ccnxVLCRateAdapter_Update(p_sys->rateAdapter, ccnxVLCUtils_NowMicroseconds(),
+                                                queued, p_sys->readAheadSize, atomic_load(&p_sys->bytesConsumed));
+    if (layers != previous) {
+        CCNxVLCRateAdapterStats stats;
+        ccnxVLCRateAdapter_GetStats(p_sys->rateAdapter, &stats);
+        msg_Dbg(p_access, "_adaptLayers: %u -> %u layers, goodput %"PRIu64" B/s, consumption %"PRIu64" B/s, "
+                          "read-ahead %zu/%zu",
+                previous, layers, stats.goodputBps, stats.consumptionBps,
+                queued, p_sys->readAheadSize);
+
+        char value[16];
+        snprintf(value, sizeof(value), "%u", layers);
+        for (size_t i = 0; i < p_sys->prefixCount; i++) {
+            ccnxVLCNameTemplate_SetVariable(p_sys->nameTemplates[i], "layers", value);
+        }
+    }
+}
+
+/**
+ * Stop the chunked flow, closing its Portal. Only called by the fetch thread, which owns the
+ * flow, or once it has exited.
+ */
+static void
+_stopChunkedFlow(access_sys_t *p_sys)
+{
+    CCNxVLCChunkedFlowStats flowStats;
+    ccnxVLCChunkedFlow_GetStats(p_sys->flow, &flowStats);
+    p_sys->flowChunks += flowStats.contentObjectsReceived;
+    ccnxVLCChunkedFlow_Release(&p_sys->flow);
+}
+
+/**
+ * Retrieve a chunk for the fetch thread. Once the fetch thread has read a run of chunks in
+ * sequence, they come from a chunked flow started at the next one. A seek, or a flow that
+ * fails, sends us back to the fetcher in message mode until the next run. If a flow fails
+ * without delivering anything, the transport doesn't support them and we stop trying.
+ */
+static CCNxVLCFetcherResult
+_fetchChunk(access_t *p_access, uint64_t chunkNum, CCNxContentObject **contentObjectP)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if (p_sys->flow != NULL) {
+        uint64_t nextChunk = ccnxVLCChunkedFlow_GetNextChunkNumber(p_sys->flow);
+        if (chunkNum < nextChunk || chunkNum - nextChunk > _CHUNKED_FLOW_MAX_SKIP) {
+            // _CCNxBlock seeked; the flow is heading somewhere we no longer want to read.
+            _stopChunkedFlow(p_sys);
+        }
+    }
+
+    if (p_sys->flow == NULL && p_sys->portalFactory != NULL
+        && chunkNum == p_sys->sequentialChunk && p_sys->sequentialRun >= _CHUNKED_FLOW_START_RUN) {
+        CCNxInterest *interest = _createInterestForChunk(p_access, _bestPrefix(p_sys), chunkNum);
+        if (interest != NULL) {
+            p_sys->flow = ccnxVLCChunkedFlow_Create(p_sys->portalFactory, interest, _CHUNKED_FLOW_STALL_US);
+            ccnxInterest_Release(&interest);
+        }
+        if (p_sys->flow == NULL) {
+            msg_Warn(p_access, "_fetchChunk: could not start a chunked flow, continuing in message mode");
+            ccnxPortalFactory_Release(&p_sys->portalFactory);
+        } else {
+            msg_Dbg(p_access, "_fetchChunk: chunked flow started at chunk [%"PRIu64"]", chunkNum);
+            p_sys->flowsStarted++;
+        }
+    }
+
+    if (p_sys->flow == NULL) {
+        return ccnxVLCFetcher_GetChunk(p_sys->fetcher, chunkNum, _FETCH_POLL_INTERVAL_US, contentObjectP);
+    }
+
+    CCNxVLCFetcherResult result = ccnxVLCChunkedFlow_GetChunk(p_sys->flow, chunkNum, _FETCH_POLL_INTERVAL_US,
+                                                              contentObjectP);
+    if (result == CCNxVLCFetcherResult_Success) {
+        // The flow's Interests are the transport's, so all we see is the arrival.
+        ccnxVLCTraceBuffer_Instant(p_sys->fetchTrace, "flow chunk", "chunk", chunkNum);
+    }
+    if (result == CCNxVLCFetcherResult_Error) {
+        CCNxVLCChunkedFlowStats flowStats;
+        ccnxVLCChunkedFlow_GetStats(p_sys->flow, &flowStats);
+        if (flowStats.contentObjectsReceived == 0) {
+            msg_Warn(p_access, "_fetchChunk: chunked flow delivered nothing, using message mode from now on");
+            ccnxPortalFactory_Release(&p_sys->portalFactory);
+        } else {
+            msg_Dbg(p_access, "_fetchChunk: chunked flow failed at chunk [%"PRIu64"], continuing in message mode",
+                    chunkNum);
+        }
+        _stopChunkedFlow(p_sys);
+        p_sys->sequentialRun = 0;
+
+        // The fetch thread asks again, and the fetcher takes over.
+        result = CCNxVLCFetcherResult_Timeout;
+    }
+    return result;
+}
+
+/**
+ * Return true if the fetch thread should stop adding chunks to the read-ahead queue until
+ * _CCNxBlock takes some. Only called by whoever adds chunks to the queue (the fetch thread,
+ * or _prefetchOpeningChunks before it starts): _CCNxBlock may take chunks at any moment, so
+ * to anyone else the answer may already be out of date.
+ */
+static bool
+_isReadAheadFull(access_sys_t *p_sys)
+{
+    return ccnxVLCChunkRing_GetCount(p_sys->readAhead) >= p_sys->readAheadSize;
+}
+
+/*****************************************************************************
+ * _fetchThread: retrieves consecutive chunks into the read-ahead queue, so
+ * that _CCNxBlock rarely has to wait on the network.
+ *****************************************************************************/
+static void *
+_fetchThread(void *data)
+{
+    access_t *p_access = data;
+    access_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_lock(&p_sys->lock);
+    while (!p_sys->closing) {
+        if (p_sys->paused || p_sys->fetchStopped || _isReadAheadFull(p_sys)) {
+            // _CCNxBlock takes chunks without the lock, and only signals for room if it sees
+            // us waiting, so say so before looking at the queue for the last time.
+            atomic_store(&p_sys->fetchWaiting, true);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (p_sys->paused || p_sys->fetchStopped || _isReadAheadFull(p_sys)) {
+                vlc_cond_wait(&p_sys->fetchWake, &p_sys->lock);
+            }
+            atomic_store(&p_sys->fetchWaiting, false);
+            continue;
+        }
+
+        if (p_sys->diskCache != NULL && ccnxVLCDiskCache_HasChunk(p_sys->diskCache, p_sys->fetchChunk)) {
+            // _CCNxBlock reads these from disk, so move on to the next chunk it will need
+            // from the network. The read-ahead queue stays in ascending order.
+            uint64_t chunkCount = ccnxVLCDiskCache_GetChunkCount(p_sys->diskCache);
+            while (p_sys->fetchChunk < chunkCount && ccnxVLCDiskCache_HasChunk(p_sys->diskCache, p_sys->fetchChunk)) {
+                p_sys->fetchChunk++;
+            }
+            if (p_sys->fetchChunk >= chunkCount) {
+                p_sys->fetchStopped = true;
+                vlc_cond_signal(&p_sys->dataReady);
+            }
+            continue;
+        }
+
+        uint64_t chunkNum = p_sys->fetchChunk;
+        unsigned generation = p_sys->fetchGeneration;
+        vlc_mutex_unlock(&p_sys->lock);
+
+        // Another stream of this process showing the same content may already have
+        // retrieved the chunk, in which case we don't ask the network for it again.
+        CCNxContentObject *contentObject = NULL;
+        CCNxVLCFetcherResult result = CCNxVLCFetcherResult_Success;
+        bool fromCache = false;
+        if (p_sys->cache != NULL) {
+            contentObject = _getCachedChunk(p_sys, chunkNum);
+            fromCache = (contentObject != NULL);
+        }
+        if (fromCache) {
+            ccnxVLCTraceBuffer_Instant(p_sys->fetchTrace, "cache hit", "chunk", chunkNum);
+        } else {
+            result = _fetchChunk(p_access, chunkNum, &contentObject);
+        }
+
+        if (result == CCNxVLCFetcherResult_Success) {
+            _storeChunkOnDisk(p_sys, chunkNum, contentObject);
+            p_sys->sequentialRun = (chunkNum == p_sys->sequentialChunk) ? p_sys->sequentialRun + 1 : 1;
+            p_sys->sequentialChunk = chunkNum + 1;
+        }
+
+        if (mdate() - p_sys->lastStatsLog > CLOCK_FREQ) {
+            CCNxVLCFetcherStats stats;
+            ccnxVLCFetcher_GetStats(p_sys->fetcher, &stats);
+            _logFetcherStats(p_access, &stats);
+            _logPrefixStats(p_access);
+            p_sys->lastStatsLog = mdate();
+        }
+
+        vlc_mutex_lock(&p_sys->lock);
+        ccnxVLCFetcher_GetStats(p_sys->fetcher, &p_sys->stats);
+
+        if (p_sys->rateAdapter != NULL) {
+            if (result == CCNxVLCFetcherResult_Success && !fromCache) {
+                ccnxVLCRateAdapter_OnChunkReceived(p_sys->rateAdapter,
+                                                   parcBuffer_Remaining(ccnxContentObject_GetPayload(contentObject)),
+                                                   ccnxVLCUtils_NowMicroseconds());
+            }
+            _adaptLayers(p_access);
+        }
+
+        if (generation != p_sys->fetchGeneration) {
+            // _CCNxBlock seeked while we were fetching; this chunk is no longer wanted.
+            if (contentObject != NULL) {
+                ccnxContentObject_Release(&contentObject);
+            }
+            continue;
+        }
+
+        switch (result) {
+            case CCNxVLCFetcherResult_Success: {
+                if (p_sys->cache != NULL && !fromCache) {
+                    ccnxVLCChunkCache_Put(p_sys->cache, contentObject);
+                }
 
-/*****************************************************************************
- * Local prototypes
- *****************************************************************************/
-struct access_sys_t
-{
-    CCNxPortal *portal;            // The Portal we'll use for communication
-    CCNxName   *interestBaseName;  // A CCNxName that we'll copy and extend when we create Interests.
-};
+                // There is room: only we add to the queue, and it wasn't full when we started.
+                CCNxVLCChunkDescriptor descriptor = { .chunkNumber = chunkNum, .contentObject = contentObject };
+                ccnxVLCChunkRing_Enqueue(p_sys->readAhead, &descriptor);
+                ccnxVLCTraceBuffer_Instant(p_sys->fetchTrace, "read-ahead", "chunk", chunkNum);
+                p_sys->fetchChunk = chunkNum + 1;
+                if (p_sys->blockWaiting) {
+                    vlc_cond_signal(&p_sys->dataReady);
+                }
+                break;
+            }
+            case CCNxVLCFetcherResult_Timeout:
+                break;
+            case CCNxVLCFetcherResult_EndOfContent:
+                p_sys->fetchStopped = true;
+                vlc_cond_signal(&p_sys->dataReady);
+                break;
+            case CCNxVLCFetcherResult_Failed:
+                _LOG_LIMITED(msg_Err, p_access, "_fetchThread: no response for chunk [%"PRIu64"] after retransmissions",
+                             chunkNum);
+                p_sys->fetchStopped = true;
+                p_sys->fetchFailed = true;
+                vlc_cond_signal(&p_sys->dataReady);
+                break;
+            case CCNxVLCFetcherResult_Error:
+                _LOG_LIMITED(msg_Err, p_access, "_fetchThread: portal failed fetching chunk [%"PRIu64"]", chunkNum);
+                p_sys->fetchStopped = true;
+                p_sys->fetchFailed = true;
+                vlc_cond_signal(&p_sys->dataReady);
+                break;
+        }
+    }
+    vlc_mutex_unlock(&p_sys->lock);
 
+    return NULL;
+}
 
 /**
- * Create a CCnxPortalFactory, supplying some default credentials.
+ * Retrieve one chunk with the fetcher, waiting until it arrives or the fetcher gives up.
+ * Only used before the fetch thread starts.
  */
-static CCNxPortalFactory *
-_setupPortalFactory(void)
+static CCNxVLCFetcherResult
+_fetchChunkNow(CCNxVLCFetcher *fetcher, uint64_t chunkNum, CCNxContentObject **contentObjectP)
 {
-    const char *keystoreName = "vlc-ccnx-keystore";
-    const char *keystorePassword = "keystore_password";
-    const char *subjectName = keystoreName;
+    CCNxVLCFetcherResult result;
+    do {
+        result = ccnxVLCFetcher_GetChunk(fetcher, chunkNum, _FETCH_POLL_INTERVAL_US, contentObjectP);
+    } while (result == CCNxVLCFetcherResult_Timeout);
 
-    return ccnxVLCUtils_SetupPortalFactory(keystoreName, keystorePassword, subjectName);
+    return result;
 }
 
 /**
- * Given a filename and a desired chunk number, create and return a CCNxInterest with
- * the appropriate name required for retrieving that chunk of that filename.
- * 
- * @param p_access - the VLC access_t structure
- * @param fileName - the name of the file (movie) from which to retrieve blocks
- * @param chunkNum - the number of the desired chunk of the file to retrieve
- * 
- * @return a CCNxInterest instance with a name suitable for retrieving the desired
- *         chunk of the specified filed. This instance must eventually be released
- *         by calling ccnxInterest_Release().
+ * The CCNxVLCFetcherInterestFactory used to fetch the manifest. The context is its array of
+ * name templates, one per prefix.
  */
-
 static CCNxInterest *
-_createInterestForChunk(access_t *p_access, char *fileName, uint64_t chunkNum)
+_createInterestForManifest(void *context, size_t prefix, uint64_t chunkNum)
 {
-    access_sys_t *p_sys = p_access->p_sys;
-
-    if (p_sys->interestBaseName == NULL) {
-        CCNxName *interestName = ccnxName_CreateFromCString(_domainPrefix);
-
-        // Append "fetch"
-        PARCBuffer *commandBuffer = parcBuffer_AllocateCString("fetch");
-        CCNxNameSegment *commandSegment = ccnxNameSegment_CreateTypeValue(CCNxNameLabelType_NAME, commandBuffer);
-
-        ccnxName_Append(interestName, commandSegment);
+    CCNxVLCNameTemplate **manifestTemplates = context;
 
-        parcBuffer_Release(&commandBuffer);
-        ccnxNameSegment_Release(&commandSegment);
-
-        // Append the filename
+    return ccnxVLCNameTemplate_CreateInterest(manifestTemplates[prefix], chunkNum);
+}
 
-        // The filename might be a path. E.g. "foo/bar/movie.mpg"
-        // We need to make each of those a segment.
+/**
+ * If the "ccn-manifest-schema" option is set, fetch the manifest it names and keep the chunk
+ * offsets it lists in p_sys->manifest. Without a manifest we assume every chunk but the final
+ * one is chunkSize bytes, so failing to get one is not fatal. Must be called before the fetch
+ * thread starts.
+ */
+static void
+_loadManifest(access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
 
-        char *segment = strtok(fileName, "/");
-        while(segment != NULL) {
-            msg_Info(p_access, "_createInterestForChunk segment = %s", segment);
-            PARCBuffer *segmentBuf = parcBuffer_AllocateCString(segment);
-            CCNxNameSegment *fileNameSegment = ccnxNameSegment_CreateTypeValue(CCNxNameLabelType_NAME, segmentBuf);
-            ccnxName_Append(interestName, fileNameSegment);
+    char *schema = var_InheritString(p_access, "ccn-manifest-schema");
+    if (schema == NULL) {
+        return;
+    }
+    CCNxVLCNameTemplate **manifestTemplates = _createNameTemplatesFromSchema(p_access, schema, p_access->psz_location);
+    free(schema);
+    if (manifestTemplates == NULL) {
+        return;
+    }
 
-            parcBuffer_Release(&segmentBuf);
-            ccnxNameSegment_Release(&fileNameSegment);
+    // A stream of its own, so that manifest chunks arriving late can't be mistaken for
+    // chunks of the content with the same number.
+    int64_t maxRetries = var_InheritInteger(p_access, "ccn-interest-retries");
+    CCNxVLCDispatcherStream *stream = ccnxVLCDispatcher_CreateStream(p_sys->dispatcher);
+    CCNxVLCFetcher *fetcher = NULL;
+    if (stream != NULL) {
+        fetcher = ccnxVLCFetcher_Create(stream, _MANIFEST_WINDOW, CCNxVLCCongestionMode_AIMD,
+                                        (maxRetries > 0) ? (unsigned) maxRetries : 0,
+                                        _createInterestForManifest, manifestTemplates);
+    }
+    if (fetcher != NULL) {
+        // The manifest's Interests teach the selector about the prefixes before the content's.
+        ccnxVLCFetcher_SetPrefixSelector(fetcher, p_sys->prefixSelector);
+    }
 
-            segment = strtok(NULL, "/");
+    uint8_t *data = NULL;
+    size_t length = 0;
+    size_t capacity = 0;
+    bool complete = false;
+    uint64_t chunkNum = 0;
+
+    while (fetcher != NULL) {
+        CCNxContentObject *contentObject = NULL;
+        CCNxVLCFetcherResult result = _fetchChunkNow(fetcher, chunkNum, &contentObject);
+        if (result == CCNxVLCFetcherResult_EndOfContent) {
+            complete = true;
+            break;
+        }
+        if (result != CCNxVLCFetcherResult_Success) {
+            break;
         }
 
-        p_sys->interestBaseName = interestName;
+        PARCBuffer *payload = ccnxContentObject_GetPayload(contentObject);
+        size_t payloadSize = parcBuffer_Remaining(payload);
+        if (length + payloadSize > capacity) {
+            size_t newCapacity = (capacity == 0) ? 4096 : capacity;
+            while (newCapacity < length + payloadSize) {
+                newCapacity *= 2;
+            }
+            uint8_t *newData = realloc(data, newCapacity);
+            if (newData == NULL) {
+                ccnxContentObject_Release(&contentObject);
+                break;
+            }
+            data = newData;
+            capacity = newCapacity;
+        }
+        memcpy(data + length, parcBuffer_Overlay(payload, 0), payloadSize);
+        length += payloadSize;
 
-	char *stringName = ccnxName_ToString(p_sys->interestBaseName);
-        msg_Info(p_access, "_createInterestForChunk basename = %s", stringName);
-	parcMemory_Deallocate(&stringName);
+        ccnxContentObject_Release(&contentObject);
+        chunkNum++;
+    }
 
+    if (complete) {
+        p_sys->manifest = ccnxVLCManifest_Create(data, length);
+        if (p_sys->manifest != NULL) {
+            msg_Dbg(p_access, "_loadManifest: %"PRIu64" chunks, %"PRIu64" bytes",
+                    ccnxVLCManifest_GetChunkCount(p_sys->manifest), ccnxVLCManifest_GetContentSize(p_sys->manifest));
+        } else {
+            msg_Warn(p_access, "_loadManifest: malformed manifest, assuming fixed size chunks");
+        }
+    } else {
+        msg_Warn(p_access, "_loadManifest: could not retrieve the manifest, assuming fixed size chunks");
     }
 
-    // Copy the interestBaseName since we'll be adding a chunk segment.
-    CCNxName *interestNameWithChunk = ccnxName_Copy(p_sys->interestBaseName);
+    free(data);
+    if (fetcher != NULL) {
+        ccnxVLCFetcher_Release(&fetcher);
+    }
+    if (stream != NULL) {
+        ccnxVLCDispatcherStream_Release(&stream);
+    }
+    _releaseNameTemplates(manifestTemplates, p_sys->prefixCount);
+}
 
-    // This is the manual version. Add the chunk number directly.
-    CCNxNameSegment *chunkNumberSegment = ccnxNameSegmentNumber_Create(CCNxNameLabelType_CHUNK, chunkNum);
-    ccnxName_Append(interestNameWithChunk, chunkNumberSegment);
-    ccnxNameSegment_Release(&chunkNumberSegment);
+/**
+ * If the chunked flow option is set and usable with this stream, keep a PortalFactory for the
+ * fetch thread to create the Portal of each flow with.
+ */
+static void
+_enableChunkedFlows(access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
 
-    // And, finally, create an Interest with the new name.
+    if (!var_InheritBool(p_access, "ccn-chunked-flow")) {
+        return;
+    }
+    if (p_sys->rateAdapter != NULL) {
+        // A flow keeps requesting the layers it was started with.
+        msg_Warn(p_access, "_enableChunkedFlows: chunked flows are not used with adaptive layers");
+        return;
+    }
 
-     // Appending Frame Number for Interest
+    // The transport's flow controller counts chunks in the last segment of the name, which
+    // the schema places the same way under every prefix.
+    CCNxName *name = ccnxVLCNameTemplate_CreateName(p_sys->nameTemplates[0], 0);
+    bool chunkIsLast = false;
+    if (name != NULL) {
+        size_t segmentCount = ccnxName_GetSegmentCount(name);
+        chunkIsLast = segmentCount > 0
+                      && ccnxNameSegment_GetType(ccnxName_GetSegment(name, segmentCount - 1)) == CCNxNameLabelType_CHUNK;
+        ccnxName_Release(&name);
+    }
+    if (!chunkIsLast) {
+        msg_Warn(p_access, "_enableChunkedFlows: {chunk} is not the last segment of the name schema, "
+                           "chunked flows are not used");
+        return;
+    }
 
-     PARCBuffer *frameBuf = parcBuffer_AllocateCString("F50");
+    p_sys->portalFactory = _setupPortalFactory();
+    if (p_sys->portalFactory == NULL) {
+        msg_Warn(p_access, "_enableChunkedFlows: could not create PortalFactory, chunked flows are not used");
+    }
+}
 
-     CCNxNameSegment *frameSegment = ccnxNameSegment_CreateTypeValue(CCNxNameLabelType_NAME, frameBuf);
+/**
+ * Return the directory of the disk cache, which the caller must free, or NULL if the disk
+ * cache is disabled.
+ */
+static char *
+_getDiskCacheDirectory(access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
 
-     ccnxName_Append(interestNameWithChunk, frameSegment);
-     parcBuffer_Release(&frameBuf);
-     ccnxNameSegment_Release(&frameSegment);
+    char *directory = var_InheritString(p_access, "ccn-disk-cache-dir");
+    if (directory != NULL && *directory == '\0') {
+        free(directory);
+        directory = NULL;
+    }
+    if (directory != NULL && p_sys->rateAdapter != NULL) {
+        // The names of the chunks, and so their contents, change with the layers requested.
+        msg_Warn(p_access, "_getDiskCacheDirectory: the disk cache is not used with adaptive layers");
+        free(directory);
+        directory = NULL;
+    }
+    return directory;
+}
 
-     // Appending number of layers for Interest
-     PARCBuffer *layerBuf = parcBuffer_AllocateCString("L4");
+/**
+ * Return what identifies the content in the disk cache: the name of its first chunk under
+ * the first prefix, which includes the variables of the name schema. The caller must release it by calling
+ * parcMemory_Deallocate().
+ */
+static char *
+_createDiskCacheTitle(access_sys_t *p_sys)
+{
+    CCNxName *firstName = ccnxVLCNameTemplate_CreateName(p_sys->nameTemplates[0], 0);
+    if (firstName == NULL) {
+        return NULL;
+    }
+    char *result = ccnxName_ToString(firstName);
+    ccnxName_Release(&firstName);
+    return result;
+}
 
-     CCNxNameSegment *layerSegment = ccnxNameSegment_CreateTypeValue(CCNxNameLabelType_NAME, layerBuf);
+/**
+ * Open the disk cache entry stored for this content by an earlier run, and take the chunk
+ * and content sizes from it, so that the stream opens without going to the network. Must
+ * be called after _loadManifest().
+ *
+ * @return true if the content was found on disk, with its first chunk.
+ */
+static bool
+_openDiskCache(access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
 
-     ccnxName_Append(interestNameWithChunk, layerSegment);
-     parcBuffer_Release(&layerBuf);
-     ccnxNameSegment_Release(&layerSegment);
+    char *directory = _getDiskCacheDirectory(p_access);
+    char *title = (directory != NULL) ? _createDiskCacheTitle(p_sys) : NULL;
+    if (title != NULL) {
+        p_sys->diskCache = ccnxVLCDiskCache_Open(directory, title);
+        parcMemory_Deallocate(&title);
+    }
+    free(directory);
 
+    if (p_sys->diskCache == NULL) {
+        return false;
+    }
 
-    CCNxInterest *result = ccnxInterest_CreateSimple(interestNameWithChunk);
+    uint64_t contentSize = ccnxVLCDiskCache_GetContentSize(p_sys->diskCache);
+    if (!ccnxVLCDiskCache_HasChunk(p_sys->diskCache, 0)
+        || (p_sys->manifest != NULL && ccnxVLCManifest_GetContentSize(p_sys->manifest) != contentSize)) {
+        // Start afresh; _createDiskCache() replaces the entry.
+        ccnxVLCDiskCache_Release(&p_sys->diskCache);
+        return false;
+    }
 
-    ccnxName_Release(&interestNameWithChunk);
+    p_sys->chunkSize = ccnxVLCDiskCache_GetChunkSize(p_sys->diskCache);
+    p_sys->contentSize = contentSize;
 
-    return result;
+    CCNxVLCDiskCacheStats stats;
+    ccnxVLCDiskCache_GetStats(p_sys->diskCache, &stats);
+    msg_Dbg(p_access, "_openDiskCache: %"PRIu64" of %"PRIu64" chunks on disk, content size %"PRIu64,
+            stats.chunksPresent, stats.chunkCount, p_sys->contentSize);
+    return true;
 }
 
-
 /**
- * Given the position handed to us by VLC when _ccnxBlock() is called, figure
- * out which chunk contains it. It looks like the position is just a byte count
- * so we just divide by our chunkSize to figure out which chunk contains it.
- * 
- * @param position - a position (byte offset) of the movie 
- * @param chunkSize - the size (in bytes) of our content chunks
- *
- * @return - the chunk number corresponding to the positiong offset
+ * Create the disk cache entry for this content, once its chunk and content sizes are known,
+ * and store the chunks already queued in the read-ahead. Content of unknown size is not
+ * cached on disk.
  */
-static uint64_t 
-_calculateChunkForPosition(uint64_t position, uint64_t chunkSize)
+static void
+_createDiskCache(access_t *p_access, uint64_t chunkCount)
 {
-    return position / chunkSize;
+    access_sys_t *p_sys = p_access->p_sys;
+
+    if (p_sys->contentSize == 0) {
+        return;
+    }
+
+    char *directory = _getDiskCacheDirectory(p_access);
+    char *title = (directory != NULL) ? _createDiskCacheTitle(p_sys) : NULL;
+    if (title != NULL) {
+        int64_t quotaMB = var_InheritInteger(p_access, "ccn-disk-cache-size");
+        uint64_t quotaBytes = (quotaMB > 0) ? (uint64_t) quotaMB * 1024 * 1024 : 0;
+
+        p_sys->diskCache = ccnxVLCDiskCache_Create(directory, title, quotaBytes,
+                                                   p_sys->chunkSize, chunkCount, p_sys->contentSize);
+        if (p_sys->diskCache == NULL) {
+            msg_Warn(p_access, "_createDiskCache: could not cache %s in %s, continuing without the disk cache",
+                     title, directory);
+        }
+        parcMemory_Deallocate(&title);
+    }
+    free(directory);
+
+    // Only the first chunk is queued yet; _prefetchOpeningChunks stores the others itself.
+    const CCNxVLCChunkDescriptor *head = ccnxVLCChunkRing_Peek(p_sys->readAhead);
+    if (p_sys->diskCache != NULL && head != NULL) {
+        _storeChunkOnDisk(p_sys, head->chunkNumber, head->contentObject);
+    }
 }
 
 /**
- * Helper function to create and return a VLC block_t containing the requested
- * data at position `position`, extracted from the supplied ContentObject.
+ * Fetch the first chunk to learn the chunk size and the final chunk number, then the next
+ * chunks and the last ones, all in parallel. VLC reads the start of the file and, for MP4,
+ * often seeks to the index at the end straight away, so this replaces a string of serial
+ * round trips with one. The final chunk also gives us the exact size of the content.
  *
- * @param p_access the VLC access structure
- * @param contentObject the CCNxContentObject instance from which to extract the data
- * @param chunkSize the size of the chunks being transferred
- * @param chunkNum the chunk number of the supplied CCNxContentObject
- * @param position the position of the requested data (from VLC)
- * @param [out] payloadSize the size of the payload that was in the ContentObject
+ * The consecutive chunks from the start are left in the read-ahead queue, and everything
+ * is cached. Without a cache, only the final chunk is fetched from the end, for its size.
+ * Once the size is known, the disk cache entry is created and everything is stored in it.
+ * Must be called after _loadManifest() and before the fetch thread starts.
  *
- * @return a block_t containing the requested data, or NULL
+ * @return VLC_SUCCESS, or VLC_EGENERIC if the first chunk could not be retrieved.
  */
-static block_t *
-_extractRequestedBlock(access_t *p_access, 
-                       CCNxContentObject *contentObject, 
-                       uint64_t chunkSize, uint64_t chunkNum, 
-                       uint64_t position, size_t *payloadSize)
+static int
+_prefetchOpeningChunks(access_t *p_access)
 {
-    block_t *result = NULL;
+    access_sys_t *p_sys = p_access->p_sys;
 
-    PARCBuffer *payload = ccnxContentObject_GetPayload(contentObject);
-    *payloadSize = parcBuffer_Remaining(payload);
+    CCNxContentObject *firstChunk = NULL;
+    if (_fetchChunkNow(p_sys->fetcher, 0, &firstChunk) != CCNxVLCFetcherResult_Success) {
+        msg_Err(p_access, "_prefetchOpeningChunks: could not retrieve the first chunk");
+        return VLC_EGENERIC;
+    }
 
-    u_char *rawPayload = parcBuffer_Overlay(payload, 0);
+    p_sys->chunkSize = parcBuffer_Remaining(ccnxContentObject_GetPayload(firstChunk));
+    if (p_sys->cache != NULL) {
+        ccnxVLCChunkCache_Put(p_sys->cache, firstChunk);
+    }
+    CCNxVLCChunkDescriptor first = { .chunkNumber = 0, .contentObject = firstChunk };
+    ccnxVLCChunkRing_Enqueue(p_sys->readAhead, &first);
+    p_sys->fetchChunk = 1;
+
+    // A manifest gives the exact size and chunk count whatever happens below. A disk cache
+    // entry is laid out for the exact size, so is only made when we know it.
+    if (p_sys->manifest != NULL) {
+        p_sys->contentSize = ccnxVLCManifest_GetContentSize(p_sys->manifest);
+        _createDiskCache(p_access, ccnxVLCManifest_GetChunkCount(p_sys->manifest));
+    }
 
-    size_t startOffset = position % chunkSize;
-    size_t numBytesToCopy = *payloadSize - startOffset;
-    if (numBytesToCopy > 0) {
-        result = block_Alloc(numBytesToCopy);
+    if (!ccnxContentObject_HasFinalChunkNumber(firstChunk)) {
+        return VLC_SUCCESS;
+    }
+    uint64_t finalChunkNum = ccnxContentObject_GetFinalChunkNumber(firstChunk);
+    if (finalChunkNum == 0) {
+        if (p_sys->manifest == NULL) {
+            p_sys->contentSize = p_sys->chunkSize;
+            _createDiskCache(p_access, 1);
+        }
+        return VLC_SUCCESS;
+    }
+
+    int64_t prefetchChunks = var_InheritInteger(p_access, "ccn-prefetch-chunks");
+    if (prefetchChunks < 1) {
+        prefetchChunks = 1;
+    }
 
-        memcpy(result->p_buffer, rawPayload + startOffset, numBytesToCopy);
-        result->i_size = numBytesToCopy;
+    // Chunks 1 .. headCount, and tailStart .. finalChunkNum, without overlap.
+    uint64_t headCount = (uint64_t) prefetchChunks - 1;
+    if (p_sys->cache == NULL && headCount > p_sys->readAheadSize - 1) {
+        headCount = p_sys->readAheadSize - 1;
+    }
+    if (headCount > finalChunkNum - 1) {
+        headCount = finalChunkNum - 1;
+    }
+    uint64_t tailCount = (p_sys->cache != NULL) ? (uint64_t) prefetchChunks : 1;
+    if (tailCount > finalChunkNum - headCount) {
+        tailCount = finalChunkNum - headCount;
+    }
+    uint64_t tailStart = finalChunkNum - tailCount + 1;
+
+    size_t count = (size_t) (headCount + tailCount);
+    uint64_t *chunkNumbers = malloc(count * sizeof(uint64_t));
+    CCNxContentObject **contentObjects = malloc(count * sizeof(CCNxContentObject *));
+    if (chunkNumbers == NULL || contentObjects == NULL) {
+        free(chunkNumbers);
+        free(contentObjects);
+        return VLC_SUCCESS;
+    }
+    for (size_t i = 0; i < headCount; i++) {
+        chunkNumbers[i] = 1 + i;
+    }
+    for (size_t i = 0; i < tailCount; i++) {
+        chunkNumbers[headCount + i] = tailStart + i;
+    }
 
-        msg_Info(p_access, "Adding %ld bytes from chunk %ld\n", numBytesToCopy, chunkNum);
+    mtime_t start = mdate();
+    size_t received = ccnxVLCFetcher_GetChunkSet(p_sys->fetcher, count, chunkNumbers, contentObjects);
+    msg_Dbg(p_access, "_prefetchOpeningChunks: %zu of %zu chunks in %"PRId64" us",
+            received, count, mdate() - start);
+
+    // Without a manifest, every chunk but the last is a full one. Without the final chunk
+    // either, the size stays unknown (0): VLC takes whatever we report as exact, and we stop
+    // at it.
+    for (size_t i = 0; i < count && p_sys->manifest == NULL; i++) {
+        if (contentObjects[i] != NULL && chunkNumbers[i] == finalChunkNum) {
+            p_sys->contentSize = finalChunkNum * p_sys->chunkSize
+                                 + parcBuffer_Remaining(ccnxContentObject_GetPayload(contentObjects[i]));
+            _createDiskCache(p_access, finalChunkNum + 1);
+        }
     }
 
-    return result;
+    for (size_t i = 0; i < count; i++) {
+        CCNxContentObject *contentObject = contentObjects[i];
+        if (contentObject == NULL) {
+            continue;
+        }
+        if (p_sys->cache != NULL) {
+            ccnxVLCChunkCache_Put(p_sys->cache, contentObject);
+        }
+        _storeChunkOnDisk(p_sys, chunkNumbers[i], contentObject);
+        CCNxVLCChunkDescriptor descriptor = { .chunkNumber = chunkNumbers[i], .contentObject = contentObject };
+        if (chunkNumbers[i] == p_sys->fetchChunk && !_isReadAheadFull(p_sys)
+            && ccnxVLCChunkRing_Enqueue(p_sys->readAhead, &descriptor)) {
+            p_sys->fetchChunk++;
+        } else {
+            ccnxContentObject_Release(&contentObject);
+        }
+    }
+    free(chunkNumbers);
+    free(contentObjects);
+
+    msg_Dbg(p_access, "_prefetchOpeningChunks: chunk size %"PRIu64", content size %"PRIu64,
+            p_sys->chunkSize, p_sys->contentSize);
+
+    return VLC_SUCCESS;
 }
 
-/*****************************************************************************
- * _CCNxBlock: Apparently called when VLC needs a block of data.
- *****************************************************************************/
+/**
+ * Return the block of data at p_access->info.i_pos, for _CCNxBlock.
+ */
 static block_t *
-_CCNxBlock(access_t *p_access)
+_readBlock(access_t *p_access)
 {
     access_sys_t *p_sys = p_access->p_sys;
     block_t *p_block = NULL;
 
-    static uint64_t _lastSeenChunkSize = 1200;
-
     if (p_access->info.b_eof) {
-        msg_Info(p_access, "_CCNxBlock EOF");
+        _LOG_BLOCK(p_access, "_CCNxBlock EOF");
     }
 
-#ifdef DEBUG
-    msg_Info(p_access, "_CCNxBlock called. Block [%ld] [%s]", p_access->info.i_pos, p_access->psz_location);
-#endif
+    _LOG_BLOCK(p_access, "_CCNxBlock called. Block [%"PRIu64"] [%s]", p_access->info.i_pos, p_access->psz_location);
 
-    uint64_t chunkNumberNeeded = _calculateChunkForPosition(p_access->info.i_pos, _lastSeenChunkSize);
-    CCNxInterest *interest = _createInterestForChunk(p_access, p_access->psz_location, chunkNumberNeeded);
+    if (p_sys->contentSize > 0 && p_access->info.i_pos >= p_sys->contentSize) {
+        p_access->info.b_eof = true;
+        return NULL;
+    }
 
-    // Once we know the chunk number, send an Interest for it. We'll get back the
-    // corresponding ContentObject.
+    uint64_t chunkNumberNeeded = _calculateChunkForPosition(p_sys, p_access->info.i_pos);
+    size_t maxChunks = _calculateBlockChunkCount(p_sys, chunkNumberNeeded, p_access->info.i_pos);
+
+    // The fetch thread keeps the read-ahead queue filled with the chunks following this
+    // one, so sequential reads are normally satisfied without waiting on the network, or
+    // even taking the lock. Anything else (i.e. after a seek) is looked up on disk and in
+    // the cache before we move the fetch thread, so the MP4 demuxer hopping between its
+    // audio and video positions doesn't throw away the read-ahead each time.
+    size_t count = _consumeReadAhead(p_sys, chunkNumberNeeded, p_sys->blockChunks, maxChunks);
+    bool fetchFailed = false;
+
+    if (count > 0) {
+        _signalRoom(p_sys);
+    } else if (p_sys->diskCache != NULL && ccnxVLCDiskCache_HasChunk(p_sys->diskCache, chunkNumberNeeded)) {
+        ccnxVLCTraceBuffer_Instant(p_sys->blockTrace, "disk", "chunk", chunkNumberNeeded);
+        return _readBlockFromDisk(p_access, chunkNumberNeeded);
+    } else {
+        bool fromCache = false;
 
-    if (ccnxPortal_Send(p_sys->portal, interest, CCNxStackTimeout_Never)) {
+        vlc_mutex_lock(&p_sys->lock);
+        mutex_cleanup_push(&p_sys->lock);
 
-        msg_Info(p_access, "_CCNxBlock asked Portal for pos [%ld], chunk [%ld]", 
-                            p_access->info.i_pos, chunkNumberNeeded);
+        if (p_sys->cache != NULL) {
+            p_sys->blockChunks[0].chunkNumber = chunkNumberNeeded;
+            p_sys->blockChunks[0].contentObject = _getCachedChunk(p_sys, chunkNumberNeeded);
+            fromCache = (p_sys->blockChunks[0].contentObject != NULL);
+        }
 
-        // Read the ContentObject response.
-        CCNxMetaMessage *response = ccnxPortal_Receive(p_sys->portal, CCNxStackTimeout_Never);
+        if (fromCache) {
+            ccnxVLCTraceBuffer_Instant(p_sys->blockTrace, "cache hit", "chunk", chunkNumberNeeded);
 
-        if (response != NULL) {
-            if (ccnxMetaMessage_IsContentObject(response)) {
-                //msg_Info(p_access, "_CCNxBlock received a chunk!");
-                CCNxContentObject *contentObject = ccnxMetaMessage_GetContentObject(response);
-               
-                CCNxName *receivedName = ccnxContentObject_GetName(contentObject); 
-                uint64_t receivedChunkNumber = ccnxVLCUtils_GetChunkNumberFromName(receivedName);
+            // Also take the chunks after it that are already here, from the head of the
+            // queue or the cache.
+            count = 1;
+            while (count < maxChunks && _takeAvailableChunk(p_sys, chunkNumberNeeded + count, &p_sys->blockChunks[count])) {
+                count++;
+            }
+        } else {
+            _positionReadAhead(p_sys, chunkNumberNeeded);
+            mtime_t stallStart = 0;
+            uint64_t stallTraceStart = 0;
+            while (ccnxVLCChunkRing_Peek(p_sys->readAhead) == NULL && !p_sys->fetchStopped) {
+                if (stallStart == 0) {
+                    stallStart = mdate();
+                    stallTraceStart = ccnxVLCUtils_NowMicroseconds();
+                }
+                p_sys->blockWaiting = true;
+                vlc_cond_wait(&p_sys->dataReady, &p_sys->lock);
+                p_sys->blockWaiting = false;
+            }
+            if (stallStart != 0) {
+                _recordStatistic(p_sys->stallHistogram, (uint64_t) (mdate() - stallStart));
+                ccnxVLCTraceBuffer_Complete(p_sys->blockTrace, "stall", stallTraceStart, "chunk", chunkNumberNeeded);
+            }
+        }
+        fetchFailed = p_sys->fetchFailed;
 
-                // Extract the requested block from the ContentObject.
-                size_t payloadSize = 0;
-                p_block = _extractRequestedBlock(p_access, contentObject, 
-                                                 _lastSeenChunkSize, receivedChunkNumber,
-                                                 p_access->info.i_pos, &payloadSize);
+        vlc_cleanup_run();
 
-                if (p_block) {
-                    p_access->info.i_pos += p_block->i_size;
-                }
+        if (!fromCache) {
+            count = _consumeReadAhead(p_sys, chunkNumberNeeded, p_sys->blockChunks, maxChunks);
+            _signalRoom(p_sys);
+        }
+    }
 
-                uint64_t finalChunkNum = ccnxContentObject_GetFinalChunkNumber(contentObject);
+    if (count > 0) {
+        _LOG_BLOCK(p_access, "_CCNxBlock got pos [%"PRIu64"], chunk [%"PRIu64"]",
+                   p_access->info.i_pos, chunkNumberNeeded);
+
+        // Having waited for the first chunk, we also took the chunks after it that had already
+        // arrived (from the same place we found the first one), so that VLC gets up to
+        // maxBlockSize bytes per call rather than one chunk.
+        block_t *p_chain = NULL;
+        block_t **pp_last = &p_chain;
+        size_t chainSize = 0;
+        size_t used = 0;
+        bool blockFull = false;
+
+        while (used < count && !blockFull) {
+            uint64_t chunkNum = p_sys->blockChunks[used].chunkNumber;
+            CCNxContentObject *contentObject = p_sys->blockChunks[used].contentObject;
+            used++;
+            ccnxVLCTraceBuffer_Instant(p_sys->blockTrace, "handoff", "chunk", chunkNum);
+
+            // Extract the requested block from the ContentObject.
+            size_t payloadSize = 0;
+            block_t *p_chunkBlock = _extractRequestedBlock(p_access, contentObject, 
+                                                           _calculateChunkOffset(p_sys, chunkNum), chunkNum,
+                                                           p_access->info.i_pos, &payloadSize);
+
+            if (p_chunkBlock) {
+                p_access->info.i_pos += p_chunkBlock->i_buffer;
+                chainSize += p_chunkBlock->i_buffer;
+                *pp_last = p_chunkBlock;
+                pp_last = &p_chunkBlock->p_next;
+            }
 
-                if (receivedChunkNumber >= finalChunkNum) {
-                    p_access->info.b_eof = true;
-                    msg_Info(p_access, "EOF");
-                } else {
-                    p_access->info.b_eof = false;
-                    _lastSeenChunkSize = payloadSize; // update the known chunk size
-                } 
+            uint64_t finalChunkNum = ccnxContentObject_GetFinalChunkNumber(contentObject);
+            ccnxContentObject_Release(&contentObject);
 
-                ccnxContentObject_Release(&contentObject);
+            if (chunkNum >= finalChunkNum) {
+                p_access->info.b_eof = true;
+                _LOG_BLOCK(p_access, "EOF");
+                break;
+            }
 
-            } else {
-                msg_Err(p_access, "_CCNxBlock received unexpected message from Portal.");
+            p_access->info.b_eof = false;
+            uint64_t expectedSize = _calculateChunkOffset(p_sys, chunkNum + 1) - _calculateChunkOffset(p_sys, chunkNum);
+            if (payloadSize != expectedSize && !p_sys->chunkSizeWarned) {
+                msg_Warn(p_access, "_CCNxBlock: chunk %"PRIu64" has %zu bytes, expected %"PRIu64"; "
+                                   "positions in this stream will be wrong",
+                         chunkNum, payloadSize, expectedSize);
+                p_sys->chunkSizeWarned = true;
             }
-        } else {
-            msg_Err(p_access, "_CCNxBlock received unexpected null message from Portal.");
+
+            blockFull = (chainSize >= p_sys->maxBlockSize);
+        }
+
+        // We only take as many chunks as the block should need, but a chunk of the wrong
+        // size can leave some over.
+        while (used < count) {
+            ccnxContentObject_Release(&p_sys->blockChunks[used++].contentObject);
         }
+
+        // Several chunks are gathered into one block: one allocation and copy per call is
+        // much cheaper than one call per chunk.
+        if (p_chain != NULL) {
+            p_block = _takeBlock(block_ChainGather(p_chain));
+        }
+    } else if (p_sys->diskCache != NULL && ccnxVLCDiskCache_HasChunk(p_sys->diskCache, chunkNumberNeeded)) {
+        // Another stream sharing the disk cache stored the chunk while we waited, and our
+        // fetch thread skipped it.
+        ccnxVLCTraceBuffer_Instant(p_sys->blockTrace, "disk", "chunk", chunkNumberNeeded);
+        p_block = _readBlockFromDisk(p_access, chunkNumberNeeded);
+    } else if (fetchFailed) {
+        // Give up on the stream rather than have VLC call us again and stall forever.
+        // A seek clears b_eof and tries again.
+        _LOG_LIMITED(msg_Err, p_access, "_CCNxBlock could not retrieve chunk [%"PRIu64"] from Portal.", chunkNumberNeeded);
+        p_access->info.b_eof = true;
     } else {
-        msg_Err(p_access, "_CCNxBlock error writing to portal.");
+        p_access->info.b_eof = true;
+        _LOG_BLOCK(p_access, "EOF");
     }
-    
-    ccnxInterest_Release(&interest);
 
     return (p_block);
 }
 
+/*****************************************************************************
+ * _CCNxBlock: Apparently called when VLC needs a block of data.
+ *****************************************************************************/
+static block_t *
+_CCNxBlock(access_t *p_access)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    mtime_t start = mdate();
+    uint64_t traceStart = (p_sys->blockTrace != NULL) ? ccnxVLCUtils_NowMicroseconds() : 0;
+    uint64_t position = p_access->info.i_pos;
+    _recordStatistic(p_sys->depthHistogram, ccnxVLCChunkRing_GetCount(p_sys->readAhead));
+
+    block_t *p_block = _readBlock(p_access);
+    ccnxVLCTraceBuffer_Complete(p_sys->blockTrace, "_CCNxBlock", traceStart, "position", position);
+
+    mtime_t now = mdate();
+    _recordStatistic(p_sys->latencyHistogram, (uint64_t) (now - start));
+    if (p_sys->statsInterval > 0 && now - p_sys->lastStatsSummary >= p_sys->statsInterval) {
+        _logStatisticsSummary(p_access);
+        p_sys->lastStatsSummary = now;
+    }
+
+    return p_block;
+}
+
 /*****************************************************************************
  * _CCNxSeek:
  *****************************************************************************/
@@ -382,11 +2169,13 @@ _CCNxSeek(access_t *p_access, uint64_t i_pos)
   
     p_access->info.i_pos = i_pos;
 
-    // If we were in a streaming mode, we might send an interest with a particular 
-    // chunk number here, so that that the flow controller starts fetching from that point.
+    // Nothing to fetch yet: _CCNxBlock moves the fetch thread when it is asked for data
+    // here, which abandons a chunked flow heading elsewhere and starts a new one at this
+    // point once reading carries on from it.
 
     p_access->info.b_eof = false;
-    msg_Info(p_access, "SEEK to i_pos [%ld]", i_pos);
+    ccnxVLCTraceBuffer_Instant(p_sys->blockTrace, "seek", "position", i_pos);
+    _LOG_BLOCK(p_access, "SEEK to i_pos [%"PRIu64"]", i_pos);
     return (VLC_SUCCESS);
 }
 
@@ -414,11 +2203,16 @@ _CCNxControl(access_t *p_access, int i_query, va_list args)
             *pb_bool = true;
             break;
 
-        // WALENDO: No longer in vlc_access.h?
-        //case ACCESS_GET_SIZE:
-        //    pui_64 = (uint64_t*)va_arg(args, uint64_t *);
-        //    *pui_64 = p_sys->i_size;
-        //    break;
+        // VLC 2.1 has no ACCESS_GET_SIZE; _CCNxOpen sets p_access->info.i_size instead.
+#ifdef CCNX_VLC_ACCESS_GET_SIZE
+        case ACCESS_GET_SIZE:
+            if (p_sys->contentSize == 0) {
+                return VLC_EGENERIC;
+            }
+            pui_64 = (uint64_t*)va_arg(args, uint64_t *);
+            *pui_64 = p_sys->contentSize;
+            break;
+#endif
             
         case ACCESS_GET_PTS_DELAY:
             pi_64 = (int64_t*)va_arg(args, int64_t *);
@@ -427,7 +2221,12 @@ _CCNxControl(access_t *p_access, int i_query, va_list args)
             break;
             
         case ACCESS_SET_PAUSE_STATE:
-            pb_bool = (bool*)va_arg(args, bool *);
+            // While paused, the fetch thread stops issuing Interests once its current
+            // chunk is in, rather than filling the read-ahead queue at full speed.
+            vlc_mutex_lock(&p_sys->lock);
+            p_sys->paused = (bool) va_arg(args, int);
+            vlc_cond_signal(&p_sys->fetchWake);
+            vlc_mutex_unlock(&p_sys->lock);
             break;
             
         case ACCESS_GET_TITLE_INFO:
@@ -441,7 +2240,7 @@ _CCNxControl(access_t *p_access, int i_query, va_list args)
             return VLC_EGENERIC;
             
         default:
-            msg_Warn(p_access, "_CCNxControl unimplemented query in control - %d", i_query);
+            _LOG_LIMITED(msg_Warn, p_access, "_CCNxControl unimplemented query in control - %d", i_query);
             return VLC_EGENERIC;
             
     }
@@ -459,6 +2258,7 @@ _CCNxOpen(vlc_object_t *p_this)
     int i_err = VLC_EGENERIC;
 
     msg_Info(p_access, "_CCNxOpen called [%s]", p_access->psz_location);
+    mtime_t openStart = mdate();
 
     p_sys = calloc(1, sizeof(access_sys_t));
     if (p_sys == NULL) {
@@ -468,36 +2268,174 @@ _CCNxOpen(vlc_object_t *p_this)
      
     p_access->p_sys = p_sys;
 
+    // Every stream of the process shares one Portal (in message mode), through the
+    // dispatcher, rather than each running its own transport stack.
     CCNxPortalFactory *portalFactory;
     if ((portalFactory = _setupPortalFactory()) != NULL) {
-        p_sys->portal = 
-            ccnxPortalFactory_CreatePortal(portalFactory,
-                                           ccnxPortalRTA_Message    // message mode
-                                           //ccnxPortalRTA_Chunked    // stream mode
-                                           );
-
+        p_sys->dispatcher = ccnxVLCDispatcher_AcquireShared(portalFactory);
         ccnxPortalFactory_Release(&portalFactory);
     } else {
         msg_Err(p_access, "_CCNxOpen failed. Could not create PortalFactory.");
     }
 
-    if (p_sys->portal == NULL) {
+    if (p_sys->dispatcher != NULL) {
+        p_sys->stream = ccnxVLCDispatcher_CreateStream(p_sys->dispatcher);
+        if (p_sys->stream == NULL) {
+            ccnxVLCDispatcher_Release(&p_sys->dispatcher);
+        }
+    }
+
+    if (p_sys->stream == NULL) {
         msg_Err(p_access, "_CCNxOpen failed. Could not create Portal.");
         free(p_sys);
         return(VLC_EGENERIC);
     }
 
-    msg_Info(p_access, "_CCNxOpen: portal open");
+    msg_Info(p_access, "_CCNxOpen: portal open after %"PRId64" us", mdate() - openStart);
+
+    if (!_createPrefixes(p_access)) {
+        msg_Err(p_access, "_CCNxOpen failed. Could not create name templates.");
+        _releaseStream(p_sys);
+        free(p_sys);
+        return(VLC_ENOMEM);
+    }
+
+    int64_t windowSize = var_InheritInteger(p_access, "ccn-pipeline-window");
+    if (windowSize < 1) {
+        windowSize = 1;
+    }
+
+    CCNxVLCCongestionMode congestionMode = CCNxVLCCongestionMode_AIMD;
+    char *congestionName = var_InheritString(p_access, "ccn-congestion-control");
+    if (ccnxVLCCongestion_ParseMode(congestionName, &congestionMode) != 0) {
+        msg_Warn(p_access, "_CCNxOpen: unknown congestion control '%s', using aimd", congestionName);
+    }
+    free(congestionName);
+
+    int64_t maxRetries = var_InheritInteger(p_access, "ccn-interest-retries");
+    if (maxRetries < 0) {
+        maxRetries = 0;
+    }
+
+    p_sys->fetcher = ccnxVLCFetcher_Create(p_sys->stream, (size_t) windowSize, congestionMode, (unsigned) maxRetries,
+                                           _createInterestForFetcher, p_access);
+    if (p_sys->fetcher == NULL) {
+        msg_Err(p_access, "_CCNxOpen failed. Could not create fetcher.");
+        _releasePrefixes(p_sys);
+        _releaseStream(p_sys);
+        free(p_sys);
+        return(VLC_ENOMEM);
+    }
+    ccnxVLCFetcher_SetPrefixSelector(p_sys->fetcher, p_sys->prefixSelector);
+    msg_Dbg(p_access, "_CCNxOpen: pipeline window %"PRId64", congestion mode %d", windowSize, congestionMode);
+
+    int64_t readAheadSize = var_InheritInteger(p_access, "ccn-readahead");
+    if (readAheadSize < 1) {
+        readAheadSize = 1;
+    }
+    p_sys->readAheadSize = (size_t) readAheadSize;
+    p_sys->readAhead = ccnxVLCChunkRing_Create(p_sys->readAheadSize);
+    p_sys->blockChunks = calloc(p_sys->readAheadSize, sizeof(CCNxVLCChunkDescriptor));
+    atomic_init(&p_sys->fetchWaiting, false);
+    atomic_init(&p_sys->bytesConsumed, 0);
+    if (p_sys->readAhead == NULL || p_sys->blockChunks == NULL) {
+        msg_Err(p_access, "_CCNxOpen failed. Could not allocate read-ahead queue.");
+        if (p_sys->readAhead != NULL) {
+            ccnxVLCChunkRing_Release(&p_sys->readAhead);
+        }
+        free(p_sys->blockChunks);
+        ccnxVLCFetcher_Release(&p_sys->fetcher);
+        _releasePrefixes(p_sys);
+        _releaseStream(p_sys);
+        free(p_sys);
+        return(VLC_ENOMEM);
+    }
+
+    int64_t maxBlockSizeKiB = var_InheritInteger(p_access, "ccn-block-size");
+    p_sys->maxBlockSize = (maxBlockSizeKiB > 0) ? (size_t) maxBlockSizeKiB * 1024 : 0;
+
+    int64_t cacheSizeMB = var_InheritInteger(p_access, "ccn-cache-size");
+    if (cacheSizeMB > 0) {
+        p_sys->cacheCapacity = (size_t) cacheSizeMB * 1024 * 1024;
+        p_sys->cache = ccnxVLCChunkCache_AcquireShared(p_sys->cacheCapacity);
+        if (p_sys->cache == NULL) {
+            msg_Warn(p_access, "_CCNxOpen: could not create chunk cache, continuing without it");
+        }
+    }
+
+    if (var_InheritBool(p_access, "ccn-adaptive-layers")) {
+        int64_t maxLayers = var_InheritInteger(p_access, "ccn-layers");
+        if (maxLayers > 1) {
+            p_sys->rateAdapter = ccnxVLCRateAdapter_Create(1, (unsigned) maxLayers);
+        }
+        if (p_sys->rateAdapter == NULL) {
+            msg_Warn(p_access, "_CCNxOpen: adaptive layers need ccn-layers > 1, continuing without them");
+        }
+    }
+
+    _enableChunkedFlows(p_access);
+    _createStatistics(p_access);
+    _createTrace(p_access);
+
+    vlc_mutex_init(&p_sys->lock);
+    vlc_cond_init(&p_sys->dataReady);
+    vlc_cond_init(&p_sys->fetchWake);
+
+    // VLC's demuxers probe more efficiently when they know the size, so we learn it before
+    // returning, from chunks VLC would otherwise be waiting for on its first reads and seeks.
+    // Content played before may not need the network at all.
+    _loadManifest(p_access);
+    int startError = VLC_SUCCESS;
+    if (!_openDiskCache(p_access)) {
+        startError = _prefetchOpeningChunks(p_access);
+    }
+    if (startError == VLC_SUCCESS
+        && vlc_clone(&p_sys->fetchThread, _fetchThread, p_access, VLC_THREAD_PRIORITY_INPUT)) {
+        msg_Err(p_access, "_CCNxOpen failed. Could not start fetch thread.");
+        startError = VLC_EGENERIC;
+    }
 
-    // If we were using the Chunked mode, we could  start the chunks flowing
-    // here. We can't do this until we support seeking in the flow controller, though.
-    //CCNxInterest *interest = _createInterestForChunk(p_access, p_access->psz_location, 0);
-    //ccnxPortal_Send(p_sys->portal, interest);
-    //ccnxInterest_Release(&interest);
+    if (startError != VLC_SUCCESS) {
+        if (p_sys->diskCache != NULL) {
+            ccnxVLCDiskCache_Release(&p_sys->diskCache);
+        }
+        if (p_sys->manifest != NULL) {
+            ccnxVLCManifest_Release(&p_sys->manifest);
+        }
+        vlc_cond_destroy(&p_sys->fetchWake);
+        vlc_cond_destroy(&p_sys->dataReady);
+        vlc_mutex_destroy(&p_sys->lock);
+        if (p_sys->rateAdapter != NULL) {
+            ccnxVLCRateAdapter_Release(&p_sys->rateAdapter);
+        }
+        if (p_sys->cache != NULL) {
+            ccnxVLCChunkCache_ReleaseShared(&p_sys->cache, p_sys->cacheCapacity);
+        }
+        if (p_sys->portalFactory != NULL) {
+            ccnxPortalFactory_Release(&p_sys->portalFactory);
+        }
+        ccnxVLCChunkRing_Release(&p_sys->readAhead);
+        free(p_sys->blockChunks);
+        ccnxVLCFetcher_Release(&p_sys->fetcher);
+        _releaseTrace(p_sys);
+        _releaseStatistics(p_sys);
+        _releasePrefixes(p_sys);
+        _releaseStream(p_sys);
+        free(p_sys);
+        return(startError);
+    }
 
     /* Init p_access */
     access_InitFields(p_access);
+#ifndef CCNX_VLC_ACCESS_GET_SIZE
+    p_access->info.i_size = p_sys->contentSize;
+#endif
     ACCESS_SET_CALLBACKS(NULL, _CCNxBlock, _CCNxControl, _CCNxSeek);
+
+    var_Create(p_access, "ccn-dump-stats", VLC_VAR_VOID);
+    var_AddCallback(p_access, "ccn-dump-stats", _dumpStatisticsCallback, p_access);
+
+    msg_Info(p_access, "_CCNxOpen: opened in %"PRId64" us", mdate() - openStart);
     return (VLC_SUCCESS);
 }
 
@@ -514,10 +2452,87 @@ _CCNxClose(vlc_object_t *p_this)
     msg_Info(p_access, "_CCNxClose called");
 
     if (p_sys != NULL) {
-        ccnxPortal_Release(&p_sys->portal);
-        if (p_sys->interestBaseName) {
-            ccnxName_Release(&p_sys->interestBaseName);
+        var_DelCallback(p_access, "ccn-dump-stats", _dumpStatisticsCallback, p_access);
+        var_Destroy(p_access, "ccn-dump-stats");
+
+        vlc_mutex_lock(&p_sys->lock);
+        p_sys->closing = true;
+        vlc_cond_signal(&p_sys->fetchWake);
+        vlc_mutex_unlock(&p_sys->lock);
+        vlc_join(p_sys->fetchThread, NULL);
+
+        ccnxVLCChunkRing_Release(&p_sys->readAhead);
+        free(p_sys->blockChunks);
+        vlc_cond_destroy(&p_sys->fetchWake);
+        vlc_cond_destroy(&p_sys->dataReady);
+        vlc_mutex_destroy(&p_sys->lock);
+
+        ccnxVLCFetcher_GetStats(p_sys->fetcher, &p_sys->stats);
+        _logFetcherStats(p_access, &p_sys->stats);
+        _logPrefixStats(p_access);
+        if (p_sys->rttHistogram != NULL) {
+            _logStatisticsSummary(p_access);
+            _dumpStatistics(p_access, "close");
+        }
+
+        if (p_sys->flow != NULL) {
+            _stopChunkedFlow(p_sys);
+        }
+        if (p_sys->flowsStarted > 0) {
+            msg_Info(p_access, "_CCNxClose: %"PRIu64" chunked flows delivered %"PRIu64" chunks",
+                     p_sys->flowsStarted, p_sys->flowChunks);
+        }
+        if (p_sys->portalFactory != NULL) {
+            ccnxPortalFactory_Release(&p_sys->portalFactory);
+        }
+
+        CCNxVLCDispatcherStats dispatcherStats;
+        ccnxVLCDispatcher_GetStats(p_sys->dispatcher, &dispatcherStats);
+        msg_Info(p_access, "_CCNxClose: shared portal sent %"PRIu64" Interests and received %"PRIu64" ContentObjects "
+                           "(%"PRIu64" delivered, %"PRIu64" unmatched) for %u streams",
+                 dispatcherStats.interestsSent, dispatcherStats.contentObjectsReceived,
+                 dispatcherStats.deliveries, dispatcherStats.unmatched, dispatcherStats.streams);
+
+        if (p_sys->cache != NULL) {
+            CCNxVLCChunkCacheStats cacheStats;
+            ccnxVLCChunkCache_GetStats(p_sys->cache, &cacheStats);
+            msg_Info(p_access, "_CCNxClose: shared chunk cache hits %"PRIu64" misses %"PRIu64" evictions %"PRIu64
+                               ", holding %zu chunks (%zu of %zu bytes) for %u streams",
+                     cacheStats.hits, cacheStats.misses, cacheStats.evictions, cacheStats.entries,
+                     cacheStats.bytes, cacheStats.capacityBytes, cacheStats.references);
+            ccnxVLCChunkCache_ReleaseShared(&p_sys->cache, p_sys->cacheCapacity);
+        }
+
+        if (p_sys->diskCache != NULL) {
+            CCNxVLCDiskCacheStats diskStats;
+            ccnxVLCDiskCache_GetStats(p_sys->diskCache, &diskStats);
+            msg_Info(p_access, "_CCNxClose: disk cache holds %"PRIu64" of %"PRIu64" chunks, %"PRIu64" written "
+                               "by this stream, %"PRIu64" other titles evicted",
+                     diskStats.chunksPresent, diskStats.chunkCount, diskStats.chunksWritten, diskStats.titlesEvicted);
+            ccnxVLCDiskCache_Release(&p_sys->diskCache);
+        }
+
+        if (p_sys->rateAdapter != NULL) {
+            CCNxVLCRateAdapterStats adapterStats;
+            ccnxVLCRateAdapter_GetStats(p_sys->rateAdapter, &adapterStats);
+            msg_Info(p_access, "_CCNxClose: finished at %u layers after %"PRIu64" switches up and %"PRIu64" down",
+                     adapterStats.level, adapterStats.switchesUp, adapterStats.switchesDown);
+            ccnxVLCRateAdapter_Release(&p_sys->rateAdapter);
+        }
+
+        if (p_sys->interestsCreated > 0) {
+            msg_Info(p_access, "_CCNxClose: %"PRIu64" Interests created, %.2f parcMemory allocations each",
+                     p_sys->interestsCreated, (double) p_sys->interestAllocations / p_sys->interestsCreated);
+        }
+
+        if (p_sys->manifest != NULL) {
+            ccnxVLCManifest_Release(&p_sys->manifest);
         }
+        ccnxVLCFetcher_Release(&p_sys->fetcher);
+        _releaseTrace(p_sys);
+        _releaseStatistics(p_sys);
+        _releasePrefixes(p_sys);
+        _releaseStream(p_sys);
         free(p_sys);
     }
 
@@ -0,0 +1,975 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+/*
+ * ccn_access_bench: plays a synthetic file through the fetch path of the access module (the
+ * dispatcher, fetcher, congestion control and read-ahead ring) from a producer in the same
+ * process, without VLC or a forwarder, and reports the throughput, the Interest rate, the
+ * latency of the blocks handed to the reader and the parcMemory allocations per chunk.
+ *
+ * The reader takes blocks the way _CCNxBlock does: it waits for the chunk it needs, then
+ * takes whatever follows it that has already arrived, up to the block size. It reads as
+ * fast as it can, so the network, not playback, sets the pace.
+ *
+ * With --log-level, the reader also logs what the access module's per-block and per-chunk
+ * messages would at that CCNX_VLC_LOG_LEVEL, through a logger that formats and writes each
+ * message under a lock as VLC's console logger does, to show what they cost in CPU.
+ * With --trace, the fetcher and the reader record into a trace as they do with the
+ * ccn-trace-file option, so that the cost of tracing can be compared in the same way.
+ *
+ * With --replica-rtts, the producer answers under several prefixes, each with its own RTT,
+ * and the fetcher spreads its Interests over them as with the ccn-prefixes option;
+ * --fail-replica makes one of them stop answering halfway through the file.
+ *
+ * Usage: ccn_access_bench [options]; run with --help for the list.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <parc/algol/parc_Memory.h>
+#include <parc/algol/parc_Buffer.h>
+#include <ccnx/common/ccnx_Name.h>
+
+#include "ccnxVLCUtils.h"
+#include "ccnxVLCPortal.h"
+#include "ccnxVLCDispatcher.h"
+#include "ccnxVLCFetcher.h"
+#include "ccnxVLCChunkRing.h"
+#include "ccnxVLCNameTemplate.h"
+#include "ccnxVLCLog.h"
+#include "ccnxVLCTrace.h"
+#include "ccnxVLCPrefixSelector.h"
+
+// How long the fetch thread waits on the fetcher before checking whether it should stop,
+// as in the access module.
+#define _FETCH_POLL_INTERVAL_US 100000
+
+// The most prefixes --replica-rtts may list.
+#define _MAX_REPLICAS 8
+
+typedef struct {
+    size_t chunkSize;              // Payload bytes per chunk
+    uint64_t finalChunk;           // The number of the last chunk of the file
+    uint64_t rttUs;                // Mean time from an Interest to its ContentObject
+    uint64_t jitterUs;             // Each RTT is uniformly up to this much above or below rttUs
+    double loss;                   // The fraction of Interests the producer ignores
+    size_t window;                 // ccn-pipeline-window
+    const char *congestion;        // ccn-congestion-control
+    unsigned retries;              // ccn-interest-retries
+    size_t readAhead;              // ccn-readahead
+    size_t blockSize;              // ccn-block-size, in bytes
+    unsigned seed;                 // Seeds the producer's choice of RTT and losses
+    int logLevel;                  // Which of the access module's messages the reader logs
+    const char *tracePath;         // Where to write a trace of the run, or NULL
+    size_t replicaCount;           // Prefixes the producer answers under, or 0 for the access module's default alone
+    uint64_t replicaRttUs[_MAX_REPLICAS]; // The mean RTT of each, instead of rttUs
+    long failReplica;              // The replica that stops answering halfway through the file, or -1
+} _BenchConfig;
+
+/*****************************************************************************
+ * The mock producer: answers each Interest for a chunk of the file after a
+ * random RTT, unless it decides the Interest was lost.
+ *****************************************************************************/
+
+typedef struct {
+    uint64_t deliverAtUs;
+    CCNxMetaMessage *message;
+} _Delivery;
+
+typedef struct _ready_message {
+    CCNxMetaMessage *message;
+    struct _ready_message *next;
+} _ReadyMessage;
+
+typedef struct {
+    const _BenchConfig *config;
+    PARCBuffer *payload;           // Shared by every ContentObject; nobody moves its position
+
+    pthread_mutex_t lock;          // Guards everything below
+    pthread_cond_t scheduled;      // Signalled when a delivery is added, or the producer is closing
+    pthread_t thread;              // Moves deliveries to the ready list when they fall due
+    bool closing;
+    unsigned seed;
+
+    // Scheduled deliveries, a binary heap ordered by deliverAtUs.
+    _Delivery *heap;
+    size_t heapCount;
+    size_t heapCapacity;
+
+    // Messages due, oldest first. A byte is written to the pipe for each.
+    _ReadyMessage *readyHead;
+    _ReadyMessage **readyTail;
+    int pipe[2];
+
+    uint64_t interestsReceived;
+    uint64_t interestsDropped;
+
+    CCNxName *prefixes[_MAX_REPLICAS]; // Only with config->replicaCount > 0
+    uint64_t replicaInterests[_MAX_REPLICAS];
+} _MockProducer;
+
+static bool
+_heapPush(_MockProducer *producer, const _Delivery *delivery)
+{
+    if (producer->heapCount == producer->heapCapacity) {
+        size_t capacity = (producer->heapCapacity == 0) ? 64 : producer->heapCapacity * 2;
+        _Delivery *heap = realloc(producer->heap, capacity * sizeof(_Delivery));
+        if (heap == NULL) {
+            return false;
+        }
+        producer->heap = heap;
+        producer->heapCapacity = capacity;
+    }
+
+    size_t i = producer->heapCount++;
+    while (i > 0 && producer->heap[(i - 1) / 2].deliverAtUs > delivery->deliverAtUs) {
+        producer->heap[i] = producer->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    producer->heap[i] = *delivery;
+    return true;
+}
+
+static _Delivery
+_heapPop(_MockProducer *producer)
+{
+    _Delivery result = producer->heap[0];
+    _Delivery last = producer->heap[--producer->heapCount];
+
+    size_t i = 0;
+    while (2 * i + 1 < producer->heapCount) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < producer->heapCount && producer->heap[child + 1].deliverAtUs < producer->heap[child].deliverAtUs) {
+            child++;
+        }
+        if (last.deliverAtUs <= producer->heap[child].deliverAtUs) {
+            break;
+        }
+        producer->heap[i] = producer->heap[child];
+        i = child;
+    }
+    producer->heap[i] = last;
+    return result;
+}
+
+static void *
+_producerThread(void *data)
+{
+    _MockProducer *producer = data;
+
+    pthread_mutex_lock(&producer->lock);
+    while (!producer->closing) {
+        if (producer->heapCount == 0) {
+            pthread_cond_wait(&producer->scheduled, &producer->lock);
+            continue;
+        }
+
+        uint64_t nowUs = ccnxVLCUtils_NowMicroseconds();
+        if (producer->heap[0].deliverAtUs > nowUs) {
+            uint64_t dueUs = producer->heap[0].deliverAtUs;
+            struct timespec deadline = { .tv_sec = dueUs / 1000000, .tv_nsec = (dueUs % 1000000) * 1000 };
+            pthread_cond_timedwait(&producer->scheduled, &producer->lock, &deadline);
+            continue;
+        }
+
+        _Delivery delivery = _heapPop(producer);
+        _ReadyMessage *ready = malloc(sizeof(_ReadyMessage));
+        if (ready == NULL) {
+            ccnxMetaMessage_Release(&delivery.message);
+            continue;
+        }
+        ready->message = delivery.message;
+        ready->next = NULL;
+        *producer->readyTail = ready;
+        producer->readyTail = &ready->next;
+
+        char byte = 0;
+        if (write(producer->pipe[1], &byte, 1) != 1) {
+            fprintf(stderr, "mock producer: could not signal a delivery: %s\n", strerror(errno));
+        }
+    }
+    pthread_mutex_unlock(&producer->lock);
+
+    return NULL;
+}
+
+static bool
+_producerSend(void *instance, const CCNxMetaMessage *message, const CCNxStackTimeout *timeout)
+{
+    _MockProducer *producer = instance;
+    const _BenchConfig *config = producer->config;
+
+    if (!ccnxMetaMessage_IsInterest(message)) {
+        return true;
+    }
+    CCNxInterest *interest = ccnxMetaMessage_GetInterest(message);
+    CCNxName *name = ccnxInterest_GetName(interest);
+    uint64_t chunkNumber = ccnxVLCUtils_GetChunkNumberFromName(name);
+
+    size_t replica = 0;
+    while (replica + 1 < config->replicaCount && !ccnxName_StartsWith(name, producer->prefixes[replica])) {
+        replica++;
+    }
+    uint64_t meanRttUs = (config->replicaCount > 0) ? config->replicaRttUs[replica] : config->rttUs;
+    bool failed = ((long) replica == config->failReplica && chunkNumber > config->finalChunk / 2);
+
+    pthread_mutex_lock(&producer->lock);
+    producer->interestsReceived++;
+    producer->replicaInterests[replica]++;
+    bool lost = failed || ((double) rand_r(&producer->seed) / RAND_MAX) < config->loss;
+    int64_t jitterUs = 0;
+    if (config->jitterUs > 0) {
+        jitterUs = (int64_t) (rand_r(&producer->seed) % (2 * config->jitterUs + 1)) - (int64_t) config->jitterUs;
+    }
+    if (lost) {
+        producer->interestsDropped++;
+    }
+    pthread_mutex_unlock(&producer->lock);
+
+    if (lost || chunkNumber > config->finalChunk) {
+        return true;
+    }
+
+    CCNxContentObject *contentObject = ccnxContentObject_CreateWithNameAndPayload(name, producer->payload);
+    ccnxContentObject_SetFinalChunkNumber(contentObject, config->finalChunk);
+
+    int64_t rttUs = (int64_t) meanRttUs + jitterUs;
+    _Delivery delivery = {
+        .deliverAtUs = ccnxVLCUtils_NowMicroseconds() + (uint64_t) (rttUs > 0 ? rttUs : 0),
+        .message     = ccnxMetaMessage_CreateFromContentObject(contentObject)
+    };
+    ccnxContentObject_Release(&contentObject);
+
+    pthread_mutex_lock(&producer->lock);
+    bool scheduled = _heapPush(producer, &delivery);
+    pthread_cond_signal(&producer->scheduled);
+    pthread_mutex_unlock(&producer->lock);
+
+    if (!scheduled) {
+        ccnxMetaMessage_Release(&delivery.message);
+    }
+    return true;
+}
+
+static CCNxMetaMessage *
+_producerReceive(void *instance, const CCNxStackTimeout *timeout)
+{
+    _MockProducer *producer = instance;
+
+    // The dispatcher only receives once the pipe is readable, so there is no need to wait.
+    pthread_mutex_lock(&producer->lock);
+    _ReadyMessage *ready = producer->readyHead;
+    if (ready != NULL) {
+        producer->readyHead = ready->next;
+        if (producer->readyHead == NULL) {
+            producer->readyTail = &producer->readyHead;
+        }
+    }
+    pthread_mutex_unlock(&producer->lock);
+
+    if (ready == NULL) {
+        return NULL;
+    }
+
+    char byte;
+    if (read(producer->pipe[0], &byte, 1) != 1) {
+        fprintf(stderr, "mock producer: lost track of a delivery: %s\n", strerror(errno));
+    }
+    CCNxMetaMessage *result = ready->message;
+    free(ready);
+    return result;
+}
+
+static int
+_producerGetFileId(const void *instance)
+{
+    const _MockProducer *producer = instance;
+
+    return producer->pipe[0];
+}
+
+static bool
+_producerIsEOF(const void *instance)
+{
+    return false;
+}
+
+static void
+_producerRelease(void **instanceP)
+{
+    _MockProducer *producer = *instanceP;
+
+    pthread_mutex_lock(&producer->lock);
+    producer->closing = true;
+    pthread_cond_signal(&producer->scheduled);
+    pthread_mutex_unlock(&producer->lock);
+    pthread_join(producer->thread, NULL);
+
+    while (producer->heapCount > 0) {
+        _Delivery delivery = _heapPop(producer);
+        ccnxMetaMessage_Release(&delivery.message);
+    }
+    while (producer->readyHead != NULL) {
+        _ReadyMessage *ready = producer->readyHead;
+        producer->readyHead = ready->next;
+        ccnxMetaMessage_Release(&ready->message);
+        free(ready);
+    }
+    free(producer->heap);
+    close(producer->pipe[0]);
+    close(producer->pipe[1]);
+    parcBuffer_Release(&producer->payload);
+    for (size_t i = 0; i < producer->config->replicaCount; i++) {
+        ccnxName_Release(&producer->prefixes[i]);
+    }
+    pthread_cond_destroy(&producer->scheduled);
+    pthread_mutex_destroy(&producer->lock);
+    free(producer);
+
+    *instanceP = NULL;
+}
+
+static const CCNxVLCPortalInterface _producerInterface = {
+    .send      = _producerSend,
+    .receive   = _producerReceive,
+    .getFileId = _producerGetFileId,
+    .isEOF     = _producerIsEOF,
+    .release   = _producerRelease
+};
+
+static _MockProducer *
+_createProducer(const _BenchConfig *config)
+{
+    _MockProducer *result = calloc(1, sizeof(_MockProducer));
+    if (result == NULL) {
+        return NULL;
+    }
+    if (pipe(result->pipe) != 0) {
+        free(result);
+        return NULL;
+    }
+    fcntl(result->pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(result->pipe[1], F_SETFL, O_NONBLOCK);
+
+    result->config = config;
+    result->seed = config->seed;
+    result->readyTail = &result->readyHead;
+
+    result->payload = parcBuffer_Allocate(config->chunkSize);
+    memset(parcBuffer_Overlay(result->payload, 0), 'x', config->chunkSize);
+    for (size_t i = 0; i < config->replicaCount; i++) {
+        char prefix[32];
+        snprintf(prefix, sizeof(prefix), "ccnx:/replica%zu", i);
+        result->prefixes[i] = ccnxName_CreateFromCString(prefix);
+    }
+
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&result->scheduled, &attributes);
+    pthread_condattr_destroy(&attributes);
+    pthread_mutex_init(&result->lock, NULL);
+
+    if (pthread_create(&result->thread, NULL, _producerThread, result) != 0) {
+        pthread_cond_destroy(&result->scheduled);
+        pthread_mutex_destroy(&result->lock);
+        parcBuffer_Release(&result->payload);
+        for (size_t i = 0; i < config->replicaCount; i++) {
+            ccnxName_Release(&result->prefixes[i]);
+        }
+        close(result->pipe[0]);
+        close(result->pipe[1]);
+        free(result);
+        return NULL;
+    }
+    return result;
+}
+
+/*****************************************************************************
+ * Counting parcMemory allocations.
+ *****************************************************************************/
+
+static const PARCMemoryInterface *_parcMemory;
+static atomic_uint_fast64_t _parcAllocations;
+
+static void *
+_countingAllocate(size_t size)
+{
+    atomic_fetch_add(&_parcAllocations, 1);
+    return ((void *(*)(size_t)) _parcMemory->Allocate)(size);
+}
+
+static void *
+_countingAllocateAndClear(size_t size)
+{
+    atomic_fetch_add(&_parcAllocations, 1);
+    return ((void *(*)(size_t)) _parcMemory->AllocateAndClear)(size);
+}
+
+static int
+_countingMemAlign(void **pointer, size_t alignment, size_t size)
+{
+    atomic_fetch_add(&_parcAllocations, 1);
+    return ((int (*)(void **, size_t, size_t)) _parcMemory->MemAlign)(pointer, alignment, size);
+}
+
+static char *
+_countingStringDuplicate(const char *string, size_t length)
+{
+    atomic_fetch_add(&_parcAllocations, 1);
+    return ((char *(*)(const char *, size_t)) _parcMemory->StringDuplicate)(string, length);
+}
+
+static PARCMemoryInterface _countingMemory = {
+    .Allocate         = (uintptr_t) _countingAllocate,
+    .AllocateAndClear = (uintptr_t) _countingAllocateAndClear,
+    .MemAlign         = (uintptr_t) _countingMemAlign,
+    .StringDuplicate  = (uintptr_t) _countingStringDuplicate
+};
+
+/**
+ * Count allocations made through parcMemory from now on, passing everything on to the
+ * memory provider in use.
+ */
+static void
+_countParcAllocations(void)
+{
+    _parcMemory = parcMemory_SetInterface(&_countingMemory);
+
+    _countingMemory.Deallocate = _parcMemory->Deallocate;
+    _countingMemory.Reallocate = _parcMemory->Reallocate;
+    _countingMemory.Outstanding = _parcMemory->Outstanding;
+}
+
+/*****************************************************************************
+ * A stand-in for VLC's console logger.
+ *****************************************************************************/
+
+static pthread_mutex_t _logLock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *_logFile;
+
+static void _log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+static void
+_log(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    pthread_mutex_lock(&_logLock);
+    vfprintf(_logFile, format, args);
+    fputc('\n', _logFile);
+    pthread_mutex_unlock(&_logLock);
+    va_end(args);
+}
+
+/**
+ * Send log messages to /dev/null, unbuffered like stderr, so each one still costs a write.
+ */
+static bool
+_openLog(void)
+{
+    _logFile = fopen("/dev/null", "w");
+    if (_logFile == NULL) {
+        return false;
+    }
+    setvbuf(_logFile, NULL, _IONBF, 0);
+    return true;
+}
+
+/**
+ * Return the CPU time used by the whole process, including the mock producer.
+ */
+static uint64_t
+_processCpuMicroseconds(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return (uint64_t) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+           + (uint64_t) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+/**
+ * Return the CPU time used by the calling thread; for the reader, what _CCNxBlock would
+ * cost VLC's input thread.
+ */
+static uint64_t
+_threadCpuMicroseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+
+    return (uint64_t) now.tv_sec * 1000000 + (uint64_t) now.tv_nsec / 1000;
+}
+
+/*****************************************************************************
+ * The player: a fetch thread filling the read-ahead ring, and a reader
+ * taking blocks from it.
+ *****************************************************************************/
+
+typedef struct {
+    const _BenchConfig *config;
+    CCNxVLCFetcher *fetcher;
+    CCNxVLCNameTemplate *nameTemplates[_MAX_REPLICAS]; // One per prefix
+    size_t prefixCount;
+    CCNxVLCPrefixSelector *prefixSelector; // Only with several prefixes
+    CCNxVLCChunkRing *readAhead;
+
+    pthread_mutex_t lock;          // Only taken to wait, or to wake a side that is waiting
+    pthread_cond_t changed;
+    atomic_bool readerWaiting;     // The reader is waiting for a chunk
+    atomic_bool fetcherWaiting;    // The fetch thread is waiting for room
+    bool fetchDone;                // The fetch thread has stopped; guarded by lock
+    bool fetchFailed;              // The fetcher gave up on a chunk; guarded by lock
+} _Player;
+
+static CCNxInterest *
+_createInterest(void *context, size_t prefix, uint64_t chunkNumber)
+{
+    _Player *player = context;
+
+    return ccnxVLCNameTemplate_CreateInterest(player->nameTemplates[prefix], chunkNumber);
+}
+
+/**
+ * Wake the other side if it is waiting, after changing the ring without the lock.
+ */
+static void
+_wake(_Player *player, atomic_bool *waiting)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(waiting)) {
+        pthread_mutex_lock(&player->lock);
+        pthread_cond_broadcast(&player->changed);
+        pthread_mutex_unlock(&player->lock);
+    }
+}
+
+static bool
+_hasRoom(_Player *player)
+{
+    return ccnxVLCChunkRing_GetCount(player->readAhead) < player->config->readAhead;
+}
+
+static bool
+_hasChunkOrDone(_Player *player)
+{
+    return ccnxVLCChunkRing_Peek(player->readAhead) != NULL || player->fetchDone;
+}
+
+/**
+ * Wait until `ready` holds, saying so in `waiting` first so that the other side wakes us.
+ */
+static void
+_waitUntil(_Player *player, atomic_bool *waiting, bool (*ready)(_Player *))
+{
+    pthread_mutex_lock(&player->lock);
+    atomic_store(waiting, true);
+    atomic_thread_fence(memory_order_seq_cst);
+    while (!ready(player)) {
+        pthread_cond_wait(&player->changed, &player->lock);
+    }
+    atomic_store(waiting, false);
+    pthread_mutex_unlock(&player->lock);
+}
+
+static void *
+_fetchThread(void *data)
+{
+    _Player *player = data;
+    bool failed = false;
+
+    for (uint64_t chunkNumber = 0; chunkNumber <= player->config->finalChunk && !failed; chunkNumber++) {
+        CCNxContentObject *contentObject = NULL;
+        CCNxVLCFetcherResult result;
+        do {
+            result = ccnxVLCFetcher_GetChunk(player->fetcher, chunkNumber, _FETCH_POLL_INTERVAL_US, &contentObject);
+        } while (result == CCNxVLCFetcherResult_Timeout);
+
+        if (result != CCNxVLCFetcherResult_Success) {
+            fprintf(stderr, "fetch thread: could not retrieve chunk %"PRIu64" (result %d)\n", chunkNumber, result);
+            failed = true;
+            break;
+        }
+
+        if (!_hasRoom(player)) {
+            _waitUntil(player, &player->fetcherWaiting, _hasRoom);
+        }
+        CCNxVLCChunkDescriptor descriptor = { .chunkNumber = chunkNumber, .contentObject = contentObject };
+        ccnxVLCChunkRing_Enqueue(player->readAhead, &descriptor);
+        _wake(player, &player->readerWaiting);
+    }
+
+    pthread_mutex_lock(&player->lock);
+    player->fetchDone = true;
+    player->fetchFailed = failed;
+    pthread_cond_broadcast(&player->changed);
+    pthread_mutex_unlock(&player->lock);
+
+    return NULL;
+}
+
+static int
+_compareLatency(const void *a, const void *b)
+{
+    uint64_t left = *(const uint64_t *) a;
+    uint64_t right = *(const uint64_t *) b;
+
+    return (left > right) - (left < right);
+}
+
+static void
+_usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --chunk-size BYTES      payload bytes per chunk (1200)\n"
+            "  --final-chunk N         number of the last chunk (8191)\n"
+            "  --rtt US                mean round trip time in microseconds (20000)\n"
+            "  --jitter US             RTTs vary uniformly by up to this much (2000)\n"
+            "  --loss PERCENT          Interests the producer ignores (0)\n"
+            "  --window N              ccn-pipeline-window (16)\n"
+            "  --congestion MODE       ccn-congestion-control (aimd)\n"
+            "  --retries N             ccn-interest-retries (4)\n"
+            "  --readahead N           ccn-readahead (64)\n"
+            "  --block-size KIB        ccn-block-size (256)\n"
+            "  --seed N                seeds the producer's RTTs and losses (1)\n"
+            "  --log-level N           log as the access module does at CCNX_VLC_LOG_LEVEL=N (0)\n"
+            "  --trace FILE            trace the run into FILE as ccn-trace-file does (off)\n"
+            "  --replica-rtts US,...   answer under one prefix per RTT listed, instead of --rtt\n"
+            "  --fail-replica N        replica N (from 0) stops answering halfway through (none)\n",
+            program);
+}
+
+static bool
+_parseArguments(int argc, char *argv[], _BenchConfig *config)
+{
+    static const struct option options[] = {
+        { "chunk-size",  required_argument, NULL, 'c' },
+        { "final-chunk", required_argument, NULL, 'f' },
+        { "rtt",         required_argument, NULL, 'r' },
+        { "jitter",      required_argument, NULL, 'j' },
+        { "loss",        required_argument, NULL, 'l' },
+        { "window",      required_argument, NULL, 'w' },
+        { "congestion",  required_argument, NULL, 'm' },
+        { "retries",     required_argument, NULL, 'n' },
+        { "readahead",   required_argument, NULL, 'a' },
+        { "block-size",  required_argument, NULL, 'b' },
+        { "seed",        required_argument, NULL, 's' },
+        { "log-level",   required_argument, NULL, 'g' },
+        { "trace",       required_argument, NULL, 't' },
+        { "replica-rtts", required_argument, NULL, 'p' },
+        { "fail-replica", required_argument, NULL, 'x' },
+        { "help",        no_argument,       NULL, 'h' },
+        { NULL,          0,                 NULL, 0   }
+    };
+
+    *config = (_BenchConfig) {
+        .chunkSize  = 1200,
+        .finalChunk = 8191,
+        .rttUs      = 20000,
+        .jitterUs   = 2000,
+        .loss       = 0.0,
+        .window     = 16,
+        .congestion = "aimd",
+        .retries    = 4,
+        .readAhead  = 64,
+        .blockSize  = 256 * 1024,
+        .seed       = 1,
+        .logLevel   = CCNxVLCLogLevel_None,
+        .failReplica = -1
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+        switch (option) {
+            case 'c': config->chunkSize = strtoul(optarg, NULL, 10); break;
+            case 'f': config->finalChunk = strtoull(optarg, NULL, 10); break;
+            case 'r': config->rttUs = strtoull(optarg, NULL, 10); break;
+            case 'j': config->jitterUs = strtoull(optarg, NULL, 10); break;
+            case 'l': config->loss = strtod(optarg, NULL) / 100.0; break;
+            case 'w': config->window = strtoul(optarg, NULL, 10); break;
+            case 'm': config->congestion = optarg; break;
+            case 'n': config->retries = (unsigned) strtoul(optarg, NULL, 10); break;
+            case 'a': config->readAhead = strtoul(optarg, NULL, 10); break;
+            case 'b': config->blockSize = strtoul(optarg, NULL, 10) * 1024; break;
+            case 's': config->seed = (unsigned) strtoul(optarg, NULL, 10); break;
+            case 'g': config->logLevel = atoi(optarg); break;
+            case 't': config->tracePath = optarg; break;
+            case 'p':
+                config->replicaCount = 0;
+                for (char *next = optarg; *next != '\0' && config->replicaCount < _MAX_REPLICAS; next += (*next == ',')) {
+                    config->replicaRttUs[config->replicaCount++] = strtoull(next, &next, 10);
+                    if (*next != ',' && *next != '\0') {
+                        return false;
+                    }
+                }
+                break;
+            case 'x': config->failReplica = strtol(optarg, NULL, 10); break;
+            default:
+                return false;
+        }
+    }
+    return optind == argc && config->chunkSize > 0 && config->window > 0 && config->readAhead > 0
+           && config->loss >= 0.0 && config->loss < 1.0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    _BenchConfig config;
+    if (!_parseArguments(argc, argv, &config)) {
+        _usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    CCNxVLCCongestionMode congestionMode;
+    if (ccnxVLCCongestion_ParseMode(config.congestion, &congestionMode) != 0) {
+        fprintf(stderr, "unknown congestion control '%s'\n", config.congestion);
+        return EXIT_FAILURE;
+    }
+
+    if (config.logLevel > CCNxVLCLogLevel_None && !_openLog()) {
+        fprintf(stderr, "could not open /dev/null for logging\n");
+        return EXIT_FAILURE;
+    }
+
+    _countParcAllocations();
+
+    _MockProducer *producer = _createProducer(&config);
+    CCNxVLCDispatcher *dispatcher = (producer != NULL) ? ccnxVLCDispatcher_Create(&_producerInterface, producer) : NULL;
+    CCNxVLCDispatcherStream *stream = (dispatcher != NULL) ? ccnxVLCDispatcher_CreateStream(dispatcher) : NULL;
+    if (stream == NULL) {
+        fprintf(stderr, "could not start the mock producer\n");
+        return EXIT_FAILURE;
+    }
+
+    _Player player = { .config = &config };
+    player.prefixCount = (config.replicaCount > 0) ? config.replicaCount : 1;
+    for (size_t i = 0; i < player.prefixCount; i++) {
+        CCNxName *prefix = (config.replicaCount > 0) ? ccnxName_Acquire(producer->prefixes[i])
+                                                     : ccnxName_CreateFromCString("ccnx:/ccnx/tutorial");
+        player.nameTemplates[i] = ccnxVLCNameTemplate_Create(prefix, CCNxVLCNameTemplate_DefaultSchema, "bench/synthetic.mp4");
+        ccnxName_Release(&prefix);
+        ccnxVLCNameTemplate_SetVariable(player.nameTemplates[i], "frame", "50");
+        ccnxVLCNameTemplate_SetVariable(player.nameTemplates[i], "layers", "4");
+    }
+    player.fetcher = ccnxVLCFetcher_Create(stream, config.window, congestionMode, config.retries, _createInterest, &player);
+    if (player.prefixCount > 1) {
+        player.prefixSelector = ccnxVLCPrefixSelector_Create(player.prefixCount);
+        ccnxVLCFetcher_SetPrefixSelector(player.fetcher, player.prefixSelector);
+    }
+    player.readAhead = ccnxVLCChunkRing_Create(config.readAhead);
+    pthread_mutex_init(&player.lock, NULL);
+    pthread_cond_init(&player.changed, NULL);
+    atomic_init(&player.readerWaiting, false);
+    atomic_init(&player.fetcherWaiting, false);
+
+    // The same buffer size as the access module, so flushes show up as often.
+    CCNxVLCTrace *trace = NULL;
+    CCNxVLCTraceBuffer *readerTrace = NULL;
+    if (config.tracePath != NULL) {
+        trace = ccnxVLCTrace_Create(config.tracePath, "ccn_access_bench");
+        if (trace == NULL) {
+            fprintf(stderr, "could not create trace %s\n", config.tracePath);
+            return EXIT_FAILURE;
+        }
+        ccnxVLCFetcher_SetTraceBuffer(player.fetcher, ccnxVLCTrace_AddThread(trace, "fetch", 65536));
+        readerTrace = ccnxVLCTrace_AddThread(trace, "_CCNxBlock", 65536);
+    }
+
+    uint64_t chunkCount = config.finalChunk + 1;
+    size_t blockChunks = (config.blockSize + config.chunkSize - 1) / config.chunkSize;
+    if (blockChunks == 0) {
+        blockChunks = 1;
+    }
+    if (blockChunks > config.readAhead) {
+        blockChunks = config.readAhead;
+    }
+    CCNxVLCChunkDescriptor *descriptors = calloc(blockChunks, sizeof(CCNxVLCChunkDescriptor));
+    uint64_t *latencies = calloc(chunkCount, sizeof(uint64_t));
+
+    if (config.replicaCount > 0) {
+        printf("synthetic file: %"PRIu64" chunks of %zu bytes from %zu replicas, rtt +/- %"PRIu64" us, loss %.2f%%\n",
+               chunkCount, config.chunkSize, config.replicaCount, config.jitterUs, config.loss * 100.0);
+    } else {
+        printf("synthetic file: %"PRIu64" chunks of %zu bytes, rtt %"PRIu64" us +/- %"PRIu64" us, loss %.2f%%\n",
+               chunkCount, config.chunkSize, config.rttUs, config.jitterUs, config.loss * 100.0);
+    }
+
+    uint64_t allocationsBefore = atomic_load(&_parcAllocations);
+    uint64_t startUs = ccnxVLCUtils_NowMicroseconds();
+    uint64_t processCpuStartUs = _processCpuMicroseconds();
+    uint64_t readerCpuStartUs = _threadCpuMicroseconds();
+
+    pthread_t fetchThread;
+    if (pthread_create(&fetchThread, NULL, _fetchThread, &player) != 0) {
+        fprintf(stderr, "could not start the fetch thread\n");
+        return EXIT_FAILURE;
+    }
+
+    // Read the file as _CCNxBlock would.
+    uint64_t nextChunk = 0;
+    uint64_t bytes = 0;
+    size_t blocks = 0;
+    uint64_t position = 0;
+    while (nextChunk < chunkCount) {
+        uint64_t requestUs = ccnxVLCUtils_NowMicroseconds();
+        uint64_t requestPosition = position;
+        if (config.logLevel >= CCNxVLCLogLevel_Blocks) {
+            _log("_CCNxBlock called. Block [%"PRIu64"] [%s]", position, "bench/synthetic.mp4");
+        }
+
+        size_t count = ccnxVLCChunkRing_DequeueRun(player.readAhead, nextChunk, descriptors, blockChunks);
+        if (count == 0) {
+            _waitUntil(&player, &player.readerWaiting, _hasChunkOrDone);
+            count = ccnxVLCChunkRing_DequeueRun(player.readAhead, nextChunk, descriptors, blockChunks);
+            if (count == 0) {
+                break;
+            }
+        }
+        _wake(&player, &player.fetcherWaiting);
+
+        if (config.logLevel >= CCNxVLCLogLevel_Blocks) {
+            _log("_CCNxBlock got pos [%"PRIu64"], chunk [%"PRIu64"]", position, nextChunk);
+        }
+        for (size_t i = 0; i < count; i++) {
+            size_t payloadSize = parcBuffer_Remaining(ccnxContentObject_GetPayload(descriptors[i].contentObject));
+            if (config.logLevel >= CCNxVLCLogLevel_Chunks) {
+                _log("Adding %zu bytes from chunk %"PRIu64, payloadSize, descriptors[i].chunkNumber);
+            }
+            ccnxVLCTraceBuffer_Instant(readerTrace, "handoff", "chunk", descriptors[i].chunkNumber);
+            bytes += payloadSize;
+            position += payloadSize;
+            ccnxContentObject_Release(&descriptors[i].contentObject);
+        }
+        nextChunk += count;
+        latencies[blocks++] = ccnxVLCUtils_NowMicroseconds() - requestUs;
+        ccnxVLCTraceBuffer_Complete(readerTrace, "_CCNxBlock", requestUs, "position", requestPosition);
+    }
+
+    uint64_t elapsedUs = ccnxVLCUtils_NowMicroseconds() - startUs;
+    uint64_t readerCpuUs = _threadCpuMicroseconds() - readerCpuStartUs;
+    uint64_t processCpuUs = _processCpuMicroseconds() - processCpuStartUs;
+    uint64_t allocations = atomic_load(&_parcAllocations) - allocationsBefore;
+    pthread_join(fetchThread, NULL);
+
+    CCNxVLCFetcherStats stats;
+    ccnxVLCFetcher_GetStats(player.fetcher, &stats);
+    double seconds = (elapsedUs > 0) ? elapsedUs / 1000000.0 : 1e-6;
+
+    qsort(latencies, blocks, sizeof(uint64_t), _compareLatency);
+    uint64_t p50 = (blocks > 0) ? latencies[(blocks - 1) / 2] : 0;
+    uint64_t p99 = (blocks > 0) ? latencies[(blocks - 1) * 99 / 100] : 0;
+
+    printf("played %"PRIu64" of %"PRIu64" chunks, %.2f MB in %.3f s: %.2f MB/s\n",
+           nextChunk, chunkCount, bytes / 1e6, seconds, bytes / 1e6 / seconds);
+    printf("interests: %"PRIu64" sent (%.0f/s), %"PRIu64" retransmitted, %"PRIu64" lost by the producer\n",
+           stats.interestsSent, stats.interestsSent / seconds, stats.retransmissions, producer->interestsDropped);
+    printf("block latency over %zu blocks: p50 %"PRIu64" us, p99 %"PRIu64" us\n", blocks, p50, p99);
+    printf("parcMemory allocations: %.2f per chunk\n", (nextChunk > 0) ? (double) allocations / nextChunk : 0.0);
+    printf("cpu per chunk at log level %d: reader %.3f us, whole process %.2f us\n", config.logLevel,
+           (nextChunk > 0) ? (double) readerCpuUs / nextChunk : 0.0,
+           (nextChunk > 0) ? (double) processCpuUs / nextChunk : 0.0);
+    printf("congestion: cwnd %.2f srtt %"PRIu64" us rto %"PRIu64" us, %"PRIu64" gaps, %"PRIu64" timeouts\n",
+           stats.congestion.cwnd, stats.congestion.srttUs, stats.congestion.rtoUs,
+           stats.congestion.gapEvents, stats.congestion.timeouts);
+    for (size_t i = 0; player.prefixSelector != NULL && i < player.prefixCount; i++) {
+        CCNxVLCPrefixStats prefixStats;
+        ccnxVLCPrefixSelector_GetStats(player.prefixSelector, i, &prefixStats);
+        printf("replica %zu (rtt %"PRIu64" us): %"PRIu64" interests, srtt %"PRIu64" us, loss %.1f%%, %s, "
+               "final share %.1f%%, %"PRIu64" failovers\n",
+               i, config.replicaRttUs[i], producer->replicaInterests[i], prefixStats.srttUs, prefixStats.loss * 100.0,
+               prefixStats.down ? "down" : "up", prefixStats.share * 100.0, prefixStats.failovers);
+    }
+
+    bool failed = player.fetchFailed || nextChunk < chunkCount;
+
+    free(latencies);
+    free(descriptors);
+    ccnxVLCChunkRing_Release(&player.readAhead);
+    ccnxVLCFetcher_Release(&player.fetcher);
+    if (trace != NULL) {
+        ccnxVLCTrace_Release(&trace);
+    }
+    if (player.prefixSelector != NULL) {
+        ccnxVLCPrefixSelector_Release(&player.prefixSelector);
+    }
+    for (size_t i = 0; i < player.prefixCount; i++) {
+        ccnxVLCNameTemplate_Release(&player.nameTemplates[i]);
+    }
+    pthread_cond_destroy(&player.changed);
+    pthread_mutex_destroy(&player.lock);
+    ccnxVLCDispatcherStream_Release(&stream);
+    ccnxVLCDispatcher_Release(&dispatcher);
+    if (_logFile != NULL) {
+        fclose(_logFile);
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
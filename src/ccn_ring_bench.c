@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+/*
+ * ccn_ring_bench: measures what it costs to hand a chunk from the fetch thread to _CCNxBlock,
+ * through the lock-free ring they share and through a mutex and condition variable queue
+ * like the one it replaced, which signalled the other side for every chunk.
+ *
+ * The ring is run twice. The "sleeping" runs wait and wake each other the way _fetchThread
+ * and _readBlock do, and are the ones to compare with the mutex and condition variable
+ * queue. The "spinning" runs retry with sched_yield() instead, which shows the cost of the
+ * ring alone but burns a core while either side waits.
+ *
+ * Usage: ccn_ring_bench [chunks [capacity]]
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ccnxVLCChunkRing.h"
+
+#define _DEFAULT_CHUNKS 10000000
+#define _DEFAULT_CAPACITY 64
+
+typedef struct {
+    uint64_t chunks;
+    size_t capacity;
+    size_t batch;
+
+    // The mutex and condition variable queue. The sleeping ring runs use the lock and the
+    // conditions as ccn.c uses p_sys->lock, dataReady and fetchWake.
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+    CCNxVLCChunkDescriptor *entries;
+    size_t head;
+    size_t count;
+
+    CCNxVLCChunkRing *ring;
+    atomic_bool producerWaiting;   // The producer is waiting on notFull, like fetchWaiting
+    bool consumerWaiting;          // The consumer is waiting on notEmpty, like blockWaiting
+} _Bench;
+
+static uint64_t
+_nowNanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+static void *
+_lockedProducer(void *data)
+{
+    _Bench *bench = data;
+
+    for (uint64_t chunk = 0; chunk < bench->chunks; chunk++) {
+        pthread_mutex_lock(&bench->lock);
+        while (bench->count == bench->capacity) {
+            pthread_cond_wait(&bench->notFull, &bench->lock);
+        }
+        CCNxVLCChunkDescriptor *entry = &bench->entries[(bench->head + bench->count) % bench->capacity];
+        entry->chunkNumber = chunk;
+        entry->contentObject = NULL;
+        bench->count++;
+        pthread_cond_signal(&bench->notEmpty);
+        pthread_mutex_unlock(&bench->lock);
+    }
+    return NULL;
+}
+
+static uint64_t
+_lockedConsumer(_Bench *bench)
+{
+    uint64_t received = 0;
+
+    while (received < bench->chunks) {
+        pthread_mutex_lock(&bench->lock);
+        while (bench->count == 0) {
+            pthread_cond_wait(&bench->notEmpty, &bench->lock);
+        }
+        if (bench->entries[bench->head].chunkNumber == received) {
+            received++;
+        }
+        bench->head = (bench->head + 1) % bench->capacity;
+        bench->count--;
+        pthread_cond_signal(&bench->notFull);
+        pthread_mutex_unlock(&bench->lock);
+    }
+    return received;
+}
+
+static bool
+_isRingFull(_Bench *bench)
+{
+    return ccnxVLCChunkRing_GetCount(bench->ring) >= bench->capacity;
+}
+
+/**
+ * The producer side of _fetchThread: the lock is held except while "fetching" a chunk, and
+ * the consumer is only signalled if it is waiting.
+ */
+static void *
+_sleepingRingProducer(void *data)
+{
+    _Bench *bench = data;
+    uint64_t chunk = 0;
+
+    pthread_mutex_lock(&bench->lock);
+    while (chunk < bench->chunks) {
+        if (_isRingFull(bench)) {
+            atomic_store(&bench->producerWaiting, true);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (_isRingFull(bench)) {
+                pthread_cond_wait(&bench->notFull, &bench->lock);
+            }
+            atomic_store(&bench->producerWaiting, false);
+            continue;
+        }
+        pthread_mutex_unlock(&bench->lock);
+
+        CCNxVLCChunkDescriptor descriptor = { .chunkNumber = chunk, .contentObject = NULL };
+
+        pthread_mutex_lock(&bench->lock);
+        ccnxVLCChunkRing_Enqueue(bench->ring, &descriptor);
+        chunk++;
+        if (bench->consumerWaiting) {
+            pthread_cond_signal(&bench->notEmpty);
+        }
+    }
+    pthread_mutex_unlock(&bench->lock);
+    return NULL;
+}
+
+/**
+ * The consumer side of _readBlock: chunks are taken without the lock, which is only taken
+ * to wait for an empty ring to fill, or to wake a waiting producer, as _signalRoom() does.
+ */
+static uint64_t
+_sleepingRingConsumer(_Bench *bench)
+{
+    CCNxVLCChunkDescriptor *descriptors = calloc(bench->batch, sizeof(CCNxVLCChunkDescriptor));
+    uint64_t received = 0;
+
+    while (received < bench->chunks) {
+        size_t count = ccnxVLCChunkRing_DequeueRun(bench->ring, received, descriptors, bench->batch);
+        if (count == 0) {
+            pthread_mutex_lock(&bench->lock);
+            while (ccnxVLCChunkRing_Peek(bench->ring) == NULL) {
+                bench->consumerWaiting = true;
+                pthread_cond_wait(&bench->notEmpty, &bench->lock);
+                bench->consumerWaiting = false;
+            }
+            pthread_mutex_unlock(&bench->lock);
+            count = ccnxVLCChunkRing_DequeueRun(bench->ring, received, descriptors, bench->batch);
+        }
+        received += count;
+
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load(&bench->producerWaiting)) {
+            pthread_mutex_lock(&bench->lock);
+            pthread_cond_signal(&bench->notFull);
+            pthread_mutex_unlock(&bench->lock);
+        }
+    }
+    free(descriptors);
+    return received;
+}
+
+static void *
+_spinningRingProducer(void *data)
+{
+    _Bench *bench = data;
+
+    for (uint64_t chunk = 0; chunk < bench->chunks; chunk++) {
+        CCNxVLCChunkDescriptor descriptor = { .chunkNumber = chunk, .contentObject = NULL };
+        while (!ccnxVLCChunkRing_Enqueue(bench->ring, &descriptor)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static uint64_t
+_spinningRingConsumer(_Bench *bench)
+{
+    CCNxVLCChunkDescriptor *descriptors = calloc(bench->batch, sizeof(CCNxVLCChunkDescriptor));
+    uint64_t received = 0;
+
+    while (received < bench->chunks) {
+        size_t count = ccnxVLCChunkRing_DequeueRun(bench->ring, received, descriptors, bench->batch);
+        if (count == 0) {
+            sched_yield();
+        }
+        received += count;
+    }
+    free(descriptors);
+    return received;
+}
+
+/**
+ * Run `producer` on a thread of its own and `consumer` on this one, and print the time taken
+ * per chunk.
+ */
+static void
+_run(const char *label, _Bench *bench, void *(*producer)(void *), uint64_t (*consumer)(_Bench *))
+{
+    pthread_t thread;
+    uint64_t start = _nowNanoseconds();
+
+    if (pthread_create(&thread, NULL, producer, bench) != 0) {
+        fprintf(stderr, "%s: could not start the producer\n", label);
+        exit(EXIT_FAILURE);
+    }
+    uint64_t received = consumer(bench);
+    pthread_join(thread, NULL);
+
+    uint64_t elapsed = _nowNanoseconds() - start;
+    printf("%-32s %8.1f ns/chunk %10.2f Mchunks/s%s\n", label, (double) elapsed / bench->chunks,
+           bench->chunks * 1000.0 / elapsed, (received == bench->chunks) ? "" : "  (chunks out of order!)");
+}
+
+int
+main(int argc, char *argv[])
+{
+    _Bench bench = { 0 };
+
+    bench.chunks = (argc > 1) ? strtoull(argv[1], NULL, 10) : _DEFAULT_CHUNKS;
+    bench.capacity = (argc > 2) ? strtoul(argv[2], NULL, 10) : _DEFAULT_CAPACITY;
+    if (bench.chunks == 0 || bench.capacity == 0) {
+        fprintf(stderr, "usage: %s [chunks [capacity]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    printf("%"PRIu64" chunks, queue of %zu\n", bench.chunks, bench.capacity);
+
+    pthread_mutex_init(&bench.lock, NULL);
+    pthread_cond_init(&bench.notEmpty, NULL);
+    pthread_cond_init(&bench.notFull, NULL);
+    atomic_init(&bench.producerWaiting, false);
+    bench.entries = calloc(bench.capacity, sizeof(CCNxVLCChunkDescriptor));
+    _run("mutex and condvar", &bench, _lockedProducer, _lockedConsumer);
+    free(bench.entries);
+
+    size_t batches[] = { 1, 16, 64 };
+    for (size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        char label[40];
+
+        bench.batch = batches[i];
+        bench.ring = ccnxVLCChunkRing_Create(bench.capacity);
+        snprintf(label, sizeof(label), "ring, sleeping, batches of %zu", batches[i]);
+        _run(label, &bench, _sleepingRingProducer, _sleepingRingConsumer);
+        ccnxVLCChunkRing_Release(&bench.ring);
+
+        bench.ring = ccnxVLCChunkRing_Create(bench.capacity);
+        snprintf(label, sizeof(label), "ring, spinning, batches of %zu", batches[i]);
+        _run(label, &bench, _spinningRingProducer, _spinningRingConsumer);
+        ccnxVLCChunkRing_Release(&bench.ring);
+    }
+
+    pthread_cond_destroy(&bench.notFull);
+    pthread_cond_destroy(&bench.notEmpty);
+    pthread_mutex_destroy(&bench.lock);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,443 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCChunkCache.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <parc/algol/parc_Buffer.h>
+
+#define _MIN_BUCKETS 64
+
+typedef struct _chunk_cache_entry {
+    CCNxName *name;
+    uint32_t hash;
+    CCNxContentObject *contentObject;
+    size_t size;
+
+    struct _chunk_cache_entry *hashNext;  // The next entry in the same hash bucket
+    struct _chunk_cache_entry *lruPrev;   // The next more recently used entry
+    struct _chunk_cache_entry *lruNext;   // The next less recently used entry
+} _ChunkCacheEntry;
+
+struct ccnx_vlc_chunk_cache {
+    pthread_mutex_t lock;                 // Guards everything below
+
+    _ChunkCacheEntry **buckets;
+    size_t bucketCount;                   // Always a power of two
+
+    _ChunkCacheEntry *lruHead;            // Most recently used
+    _ChunkCacheEntry *lruTail;            // Least recently used, evicted first
+
+    CCNxVLCChunkCacheStats stats;         // Including the capacity and reference count
+
+    size_t *sharedRequests;               // The capacity each holder of the shared cache asked for
+    size_t sharedRequestCount;            // Guarded by _referenceLock, not by lock
+};
+
+// The process-wide cache handed out by ccnxVLCChunkCache_AcquireShared(). _referenceLock guards
+// it and the reference count of every cache, so that the shared cache cannot be handed out
+// again while its last holder is freeing it.
+static CCNxVLCChunkCache *_sharedCache = NULL;
+static pthread_mutex_t _referenceLock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t
+_bucketIndex(size_t bucketCount, uint32_t hash)
+{
+    // Fibonacci hashing, in case the name hash is weak in its low bits.
+    return (size_t) (((uint64_t) hash * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (bucketCount - 1);
+}
+
+static size_t
+_payloadSize(const CCNxContentObject *contentObject)
+{
+    PARCBuffer *payload = ccnxContentObject_GetPayload(contentObject);
+    return (payload == NULL) ? 0 : parcBuffer_Remaining(payload);
+}
+
+static void
+_lruUnlink(CCNxVLCChunkCache *cache, _ChunkCacheEntry *entry)
+{
+    if (entry->lruPrev != NULL) {
+        entry->lruPrev->lruNext = entry->lruNext;
+    } else {
+        cache->lruHead = entry->lruNext;
+    }
+    if (entry->lruNext != NULL) {
+        entry->lruNext->lruPrev = entry->lruPrev;
+    } else {
+        cache->lruTail = entry->lruPrev;
+    }
+    entry->lruPrev = entry->lruNext = NULL;
+}
+
+static void
+_lruPushFront(CCNxVLCChunkCache *cache, _ChunkCacheEntry *entry)
+{
+    entry->lruPrev = NULL;
+    entry->lruNext = cache->lruHead;
+    if (cache->lruHead != NULL) {
+        cache->lruHead->lruPrev = entry;
+    } else {
+        cache->lruTail = entry;
+    }
+    cache->lruHead = entry;
+}
+
+static _ChunkCacheEntry **
+_findLink(const CCNxVLCChunkCache *cache, const CCNxName *name, uint32_t hash)
+{
+    _ChunkCacheEntry **link = &cache->buckets[_bucketIndex(cache->bucketCount, hash)];
+    while (*link != NULL && ((*link)->hash != hash || !ccnxName_Equals((*link)->name, name))) {
+        link = &(*link)->hashNext;
+    }
+    return link;
+}
+
+static void
+_removeEntry(CCNxVLCChunkCache *cache, _ChunkCacheEntry **link)
+{
+    _ChunkCacheEntry *entry = *link;
+
+    *link = entry->hashNext;
+    _lruUnlink(cache, entry);
+
+    cache->stats.entries--;
+    cache->stats.bytes -= entry->size;
+
+    ccnxName_Release(&entry->name);
+    ccnxContentObject_Release(&entry->contentObject);
+    free(entry);
+}
+
+static void
+_evictLeastRecentlyUsed(CCNxVLCChunkCache *cache)
+{
+    _ChunkCacheEntry *victim = cache->lruTail;
+    _removeEntry(cache, _findLink(cache, victim->name, victim->hash));
+}
+
+/**
+ * Double the number of buckets once the table is more than fully loaded. If the larger table
+ * cannot be allocated we keep the old one; lookups just get a little slower.
+ */
+static void
+_growIfNeeded(CCNxVLCChunkCache *cache)
+{
+    if (cache->stats.entries <= cache->bucketCount) {
+        return;
+    }
+
+    size_t newCount = cache->bucketCount * 2;
+    _ChunkCacheEntry **newBuckets = calloc(newCount, sizeof(_ChunkCacheEntry *));
+    if (newBuckets == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < cache->bucketCount; i++) {
+        _ChunkCacheEntry *entry = cache->buckets[i];
+        while (entry != NULL) {
+            _ChunkCacheEntry *next = entry->hashNext;
+            size_t index = _bucketIndex(newCount, entry->hash);
+            entry->hashNext = newBuckets[index];
+            newBuckets[index] = entry;
+            entry = next;
+        }
+    }
+
+    free(cache->buckets);
+    cache->buckets = newBuckets;
+    cache->bucketCount = newCount;
+}
+
+static void
+_destroy(CCNxVLCChunkCache *cache)
+{
+    while (cache->lruTail != NULL) {
+        _evictLeastRecentlyUsed(cache);
+    }
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->sharedRequests);
+    free(cache->buckets);
+    free(cache);
+}
+
+/**
+ * Set the capacity, evicting the least recently used chunks until the cache fits in it.
+ */
+static void
+_setCapacity(CCNxVLCChunkCache *cache, size_t capacityBytes)
+{
+    pthread_mutex_lock(&cache->lock);
+    cache->stats.capacityBytes = capacityBytes;
+    while (cache->stats.bytes > capacityBytes && cache->lruTail != NULL) {
+        _evictLeastRecentlyUsed(cache);
+        cache->stats.evictions++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/**
+ * Record that a holder of the shared cache asked for `capacityBytes`. Called with
+ * _referenceLock held.
+ */
+static bool
+_addSharedRequest(CCNxVLCChunkCache *cache, size_t capacityBytes)
+{
+    size_t *requests = realloc(cache->sharedRequests, (cache->sharedRequestCount + 1) * sizeof(size_t));
+    if (requests == NULL) {
+        return false;
+    }
+    requests[cache->sharedRequestCount++] = capacityBytes;
+    cache->sharedRequests = requests;
+    return true;
+}
+
+/**
+ * Forget one request for `capacityBytes`, and return the largest of those left, or 0 if
+ * there are none. Called with _referenceLock held.
+ */
+static size_t
+_removeSharedRequest(CCNxVLCChunkCache *cache, size_t capacityBytes)
+{
+    for (size_t i = 0; i < cache->sharedRequestCount; i++) {
+        if (cache->sharedRequests[i] == capacityBytes) {
+            cache->sharedRequests[i] = cache->sharedRequests[--cache->sharedRequestCount];
+            break;
+        }
+    }
+
+    size_t result = 0;
+    for (size_t i = 0; i < cache->sharedRequestCount; i++) {
+        if (cache->sharedRequests[i] > result) {
+            result = cache->sharedRequests[i];
+        }
+    }
+    return result;
+}
+
+CCNxVLCChunkCache *
+ccnxVLCChunkCache_Create(size_t capacityBytes)
+{
+    CCNxVLCChunkCache *result = calloc(1, sizeof(CCNxVLCChunkCache));
+    if (result != NULL) {
+        result->stats.capacityBytes = capacityBytes;
+        result->stats.references = 1;
+        result->bucketCount = _MIN_BUCKETS;
+        result->buckets = calloc(result->bucketCount, sizeof(_ChunkCacheEntry *));
+        if (result->buckets == NULL) {
+            free(result);
+            return NULL;
+        }
+        pthread_mutex_init(&result->lock, NULL);
+    }
+    return result;
+}
+
+CCNxVLCChunkCache *
+ccnxVLCChunkCache_AcquireShared(size_t capacityBytes)
+{
+    pthread_mutex_lock(&_referenceLock);
+
+    CCNxVLCChunkCache *result = _sharedCache;
+    if (result == NULL) {
+        result = ccnxVLCChunkCache_Create(capacityBytes);
+        if (result != NULL && !_addSharedRequest(result, capacityBytes)) {
+            _destroy(result);
+            result = NULL;
+        }
+        _sharedCache = result;
+    } else if (_addSharedRequest(result, capacityBytes)) {
+        result->stats.references++;
+        if (capacityBytes > result->stats.capacityBytes) {
+            _setCapacity(result, capacityBytes);
+        }
+    } else {
+        result = NULL;
+    }
+
+    pthread_mutex_unlock(&_referenceLock);
+    return result;
+}
+
+void
+ccnxVLCChunkCache_ReleaseShared(CCNxVLCChunkCache **cacheP, size_t capacityBytes)
+{
+    CCNxVLCChunkCache *cache = *cacheP;
+
+    pthread_mutex_lock(&_referenceLock);
+    size_t remainingCapacity = _removeSharedRequest(cache, capacityBytes);
+    bool last = (--cache->stats.references == 0);
+    if (last) {
+        _sharedCache = NULL;
+    } else if (remainingCapacity < cache->stats.capacityBytes) {
+        _setCapacity(cache, remainingCapacity);
+    }
+    pthread_mutex_unlock(&_referenceLock);
+
+    if (last) {
+        _destroy(cache);
+    }
+
+    *cacheP = NULL;
+}
+
+void
+ccnxVLCChunkCache_Release(CCNxVLCChunkCache **cacheP)
+{
+    CCNxVLCChunkCache *cache = *cacheP;
+
+    pthread_mutex_lock(&_referenceLock);
+    bool last = (--cache->stats.references == 0);
+    if (last && cache == _sharedCache) {
+        _sharedCache = NULL;
+    }
+    pthread_mutex_unlock(&_referenceLock);
+
+    if (last) {
+        _destroy(cache);
+    }
+
+    *cacheP = NULL;
+}
+
+void
+ccnxVLCChunkCache_Put(CCNxVLCChunkCache *cache, CCNxContentObject *contentObject)
+{
+    CCNxName *name = ccnxContentObject_GetName(contentObject);
+    if (name == NULL) {
+        return;
+    }
+    uint32_t hash = ccnxName_HashCode(name);
+    size_t size = _payloadSize(contentObject);
+
+    _ChunkCacheEntry *entry = calloc(1, sizeof(_ChunkCacheEntry));
+    if (entry == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+
+    if (size > cache->stats.capacityBytes) {
+        pthread_mutex_unlock(&cache->lock);
+        free(entry);
+        return;
+    }
+
+    _ChunkCacheEntry **link = _findLink(cache, name, hash);
+    if (*link != NULL) {
+        _removeEntry(cache, link);
+    }
+
+    while (cache->stats.bytes + size > cache->stats.capacityBytes && cache->lruTail != NULL) {
+        _evictLeastRecentlyUsed(cache);
+        cache->stats.evictions++;
+    }
+
+    entry->name = ccnxName_Acquire(name);
+    entry->hash = hash;
+    entry->contentObject = ccnxContentObject_Acquire(contentObject);
+    entry->size = size;
+
+    size_t index = _bucketIndex(cache->bucketCount, hash);
+    entry->hashNext = cache->buckets[index];
+    cache->buckets[index] = entry;
+    _lruPushFront(cache, entry);
+
+    cache->stats.entries++;
+    cache->stats.bytes += size;
+    cache->stats.insertions++;
+
+    _growIfNeeded(cache);
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+CCNxContentObject *
+ccnxVLCChunkCache_Get(CCNxVLCChunkCache *cache, const CCNxName *name)
+{
+    CCNxContentObject *result = NULL;
+    uint32_t hash = ccnxName_HashCode(name);
+
+    pthread_mutex_lock(&cache->lock);
+
+    _ChunkCacheEntry *entry = *_findLink(cache, name, hash);
+    if (entry == NULL) {
+        cache->stats.misses++;
+    } else {
+        cache->stats.hits++;
+        _lruUnlink(cache, entry);
+        _lruPushFront(cache, entry);
+
+        // Our own reference keeps the ContentObject valid for the caller even if another
+        // stream evicts the entry straight after we unlock.
+        result = ccnxContentObject_Acquire(entry->contentObject);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+    return result;
+}
+
+void
+ccnxVLCChunkCache_GetStats(CCNxVLCChunkCache *cache, CCNxVLCChunkCacheStats *stats)
+{
+    pthread_mutex_lock(&_referenceLock);
+    pthread_mutex_lock(&cache->lock);
+    *stats = cache->stats;
+    pthread_mutex_unlock(&cache->lock);
+    pthread_mutex_unlock(&_referenceLock);
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCChunkCache_h
+#define ccnxVLCChunkCache_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <ccnx/common/ccnx_Name.h>
+#include <ccnx/common/ccnx_ContentObject.h>
+
+struct ccnx_vlc_chunk_cache;
+typedef struct ccnx_vlc_chunk_cache CCNxVLCChunkCache;
+
+/**
+ * Counters describing the use of a CCNxVLCChunkCache.
+ */
+typedef struct ccnx_vlc_chunk_cache_stats {
+    uint64_t hits;          // Lookups that found the chunk
+    uint64_t misses;        // Lookups that did not
+    uint64_t insertions;    // Chunks added
+    uint64_t evictions;     // Chunks removed to stay within the capacity
+    size_t   entries;       // Chunks currently held
+    size_t   bytes;         // Payload bytes currently held
+    size_t   capacityBytes; // The most payload the cache will hold
+    unsigned references;    // Holders of the cache, e.g. streams sharing it
+} CCNxVLCChunkCacheStats;
+
+/**
+ * Create a cache of ContentObjects, keyed by their full name, holding at most `capacityBytes`
+ * bytes of payload. When full, the least recently used chunks are evicted. The cache is
+ * thread-safe. The returned instance must eventually be released by calling
+ * ccnxVLCChunkCache_Release().
+ *
+ * @param [in] capacityBytes The largest total payload size to hold.
+ *
+ * @return A new CCNxVLCChunkCache instance, or NULL if memory could not be allocated.
+ */
+CCNxVLCChunkCache *ccnxVLCChunkCache_Create(size_t capacityBytes);
+
+/**
+ * Return the process-wide cache, creating it on first use, so that every stream of the
+ * process shares the chunks any of them has retrieved. The cap is global: the capacity is
+ * the largest `capacityBytes` asked for by the current holders, so it is raised here if
+ * this request is larger, and lowered again when that holder releases the cache. Each call
+ * must be balanced by a call to ccnxVLCChunkCache_ReleaseShared() with the same
+ * `capacityBytes`; the cache is freed when its last holder releases it.
+ *
+ * @param [in] capacityBytes The largest total payload size the caller wants held.
+ *
+ * @return A new reference to the shared CCNxVLCChunkCache, or NULL if memory could not be allocated.
+ */
+CCNxVLCChunkCache *ccnxVLCChunkCache_AcquireShared(size_t capacityBytes);
+
+/**
+ * Release a reference to the cache. The last release frees the cache and drops its references
+ * to the ContentObjects it holds. References from ccnxVLCChunkCache_AcquireShared() are
+ * released with ccnxVLCChunkCache_ReleaseShared() instead.
+ *
+ * @param [in,out] cacheP A pointer to the cache to release. It is set to NULL.
+ */
+void ccnxVLCChunkCache_Release(CCNxVLCChunkCache **cacheP);
+
+/**
+ * Release a reference returned by ccnxVLCChunkCache_AcquireShared(). The capacity drops to
+ * the largest one the remaining holders asked for, evicting the least recently used chunks
+ * to fit. The last release frees the cache.
+ *
+ * @param [in,out] cacheP A pointer to the shared cache to release. It is set to NULL.
+ * @param [in] capacityBytes The capacity passed to ccnxVLCChunkCache_AcquireShared().
+ */
+void ccnxVLCChunkCache_ReleaseShared(CCNxVLCChunkCache **cacheP, size_t capacityBytes);
+
+/**
+ * Add a ContentObject, keyed by its name, replacing any existing entry for that name. The
+ * cache acquires its own reference. A chunk larger than the whole cache is not stored.
+ *
+ * @param [in] cache The cache.
+ * @param [in] contentObject The ContentObject to store.
+ */
+void ccnxVLCChunkCache_Put(CCNxVLCChunkCache *cache, CCNxContentObject *contentObject);
+
+/**
+ * Look up a chunk by its full name, marking it as most recently used if present.
+ *
+ * @param [in] cache The cache.
+ * @param [in] name The name of the chunk, as it appears in the ContentObject.
+ *
+ * @return A new reference to the chunk's ContentObject, which the caller must release by
+ *         calling ccnxContentObject_Release(), or NULL if the chunk is not cached.
+ */
+CCNxContentObject *ccnxVLCChunkCache_Get(CCNxVLCChunkCache *cache, const CCNxName *name);
+
+/**
+ * Copy the cache's counters into `stats`.
+ *
+ * @param [in] cache The cache.
+ * @param [out] stats The structure to fill in.
+ */
+void ccnxVLCChunkCache_GetStats(CCNxVLCChunkCache *cache, CCNxVLCChunkCacheStats *stats);
+
+#endif // ccnxVLCChunkCache_h
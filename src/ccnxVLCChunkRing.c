@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCChunkRing.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+// Each side writes only to its own cache line, so the producer's stores don't keep taking
+// the line holding the consumer's index away from the consumer, and vice versa.
+#define _CACHE_LINE_SIZE 64
+
+struct ccnx_vlc_chunk_ring {
+    // Fixed once created, and only read by either side.
+    CCNxVLCChunkDescriptor *entries;
+    size_t mask;                   // capacity - 1; indices grow without bound and are masked
+    char fixedPadding[_CACHE_LINE_SIZE - sizeof(CCNxVLCChunkDescriptor *) - sizeof(size_t)];
+
+    // The consumer's line. `tailSeen` is its last look at `tail`, so it only reads the
+    // producer's line when the descriptors it already knows about run out.
+    atomic_size_t head;
+    size_t tailSeen;
+    char consumerPadding[_CACHE_LINE_SIZE - sizeof(atomic_size_t) - sizeof(size_t)];
+
+    // The producer's line, likewise.
+    atomic_size_t tail;
+    size_t headSeen;
+    char producerPadding[_CACHE_LINE_SIZE - sizeof(atomic_size_t) - sizeof(size_t)];
+};
+
+CCNxVLCChunkRing *
+ccnxVLCChunkRing_Create(size_t minimumCapacity)
+{
+    size_t capacity = 1;
+    while (capacity < minimumCapacity) {
+        capacity <<= 1;
+    }
+
+    void *memory = NULL;
+    if (posix_memalign(&memory, _CACHE_LINE_SIZE, sizeof(CCNxVLCChunkRing)) != 0) {
+        return NULL;
+    }
+    CCNxVLCChunkRing *result = memory;
+
+    result->entries = calloc(capacity, sizeof(CCNxVLCChunkDescriptor));
+    if (result->entries == NULL) {
+        free(result);
+        return NULL;
+    }
+    result->mask = capacity - 1;
+    atomic_init(&result->head, 0);
+    result->tailSeen = 0;
+    atomic_init(&result->tail, 0);
+    result->headSeen = 0;
+
+    return result;
+}
+
+void
+ccnxVLCChunkRing_Release(CCNxVLCChunkRing **ringP)
+{
+    CCNxVLCChunkRing *ring = *ringP;
+
+    CCNxVLCChunkDescriptor descriptor;
+    while (ccnxVLCChunkRing_Dequeue(ring, &descriptor)) {
+        if (descriptor.contentObject != NULL) {
+            ccnxContentObject_Release(&descriptor.contentObject);
+        }
+    }
+    free(ring->entries);
+    free(ring);
+
+    *ringP = NULL;
+}
+
+size_t
+ccnxVLCChunkRing_GetCapacity(const CCNxVLCChunkRing *ring)
+{
+    return ring->mask + 1;
+}
+
+size_t
+ccnxVLCChunkRing_GetCount(const CCNxVLCChunkRing *ring)
+{
+    // Read the head first: a tail read after it is at least as recent, so the count can't
+    // come out negative.
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    return tail - head;
+}
+
+bool
+ccnxVLCChunkRing_Enqueue(CCNxVLCChunkRing *ring, const CCNxVLCChunkDescriptor *descriptor)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if (tail - ring->headSeen > ring->mask) {
+        ring->headSeen = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail - ring->headSeen > ring->mask) {
+            return false;
+        }
+    }
+
+    ring->entries[tail & ring->mask] = *descriptor;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+const CCNxVLCChunkDescriptor *
+ccnxVLCChunkRing_Peek(CCNxVLCChunkRing *ring)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if (head == ring->tailSeen) {
+        ring->tailSeen = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head == ring->tailSeen) {
+            return NULL;
+        }
+    }
+    return &ring->entries[head & ring->mask];
+}
+
+bool
+ccnxVLCChunkRing_Dequeue(CCNxVLCChunkRing *ring, CCNxVLCChunkDescriptor *descriptor)
+{
+    const CCNxVLCChunkDescriptor *entry = ccnxVLCChunkRing_Peek(ring);
+    if (entry == NULL) {
+        return false;
+    }
+    return ccnxVLCChunkRing_DequeueRun(ring, entry->chunkNumber, descriptor, 1) == 1;
+}
+
+size_t
+ccnxVLCChunkRing_DequeueRun(CCNxVLCChunkRing *ring, uint64_t firstChunkNumber,
+                            CCNxVLCChunkDescriptor descriptors[], size_t maxCount)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if (ring->tailSeen - head < maxCount) {
+        ring->tailSeen = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    }
+    size_t available = ring->tailSeen - head;
+
+    size_t count = 0;
+    while (count < maxCount && count < available) {
+        CCNxVLCChunkDescriptor *entry = &ring->entries[(head + count) & ring->mask];
+        if (entry->chunkNumber != firstChunkNumber + count) {
+            break;
+        }
+        descriptors[count] = *entry;
+        entry->contentObject = NULL;
+        count++;
+    }
+
+    if (count > 0) {
+        atomic_store_explicit(&ring->head, head + count, memory_order_release);
+    }
+    return count;
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCChunkRing_h
+#define ccnxVLCChunkRing_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <ccnx/common/ccnx_ContentObject.h>
+
+struct ccnx_vlc_chunk_ring;
+typedef struct ccnx_vlc_chunk_ring CCNxVLCChunkRing;
+
+/**
+ * A chunk handed from the producer of a ring to its consumer.
+ */
+typedef struct ccnx_vlc_chunk_descriptor {
+    uint64_t chunkNumber;
+    CCNxContentObject *contentObject;
+} CCNxVLCChunkDescriptor;
+
+/**
+ * Create a bounded, lock-free ring of chunk descriptors for exactly one producer thread and
+ * one consumer thread. Neither side ever blocks or takes a lock; a side that needs to wait
+ * for the other (for room, or for a chunk) must arrange that itself.
+ *
+ * The ring owns the ContentObjects of the descriptors in it.
+ *
+ * @param [in] minimumCapacity The least number of descriptors the ring must hold. It is
+ *                             rounded up to a power of two.
+ *
+ * @return A new CCNxVLCChunkRing instance, or NULL if memory could not be allocated. It must
+ *         eventually be released by calling ccnxVLCChunkRing_Release().
+ */
+CCNxVLCChunkRing *ccnxVLCChunkRing_Create(size_t minimumCapacity);
+
+/**
+ * Release the ring and the ContentObjects still in it. Neither side may be using it.
+ *
+ * @param [in,out] ringP A pointer to the ring to release. It is set to NULL.
+ */
+void ccnxVLCChunkRing_Release(CCNxVLCChunkRing **ringP);
+
+/**
+ * Return the number of descriptors the ring can hold.
+ *
+ * @param [in] ring The ring instance.
+ *
+ * @return The capacity of the ring, a power of two.
+ */
+size_t ccnxVLCChunkRing_GetCapacity(const CCNxVLCChunkRing *ring);
+
+/**
+ * Return the number of descriptors in the ring. Called by either side, the result may be
+ * stale by the time it is used, but only in the direction of the other side's progress: the
+ * producer may see the ring fuller than it is, and the consumer emptier.
+ *
+ * @param [in] ring The ring instance.
+ *
+ * @return The number of descriptors in the ring.
+ */
+size_t ccnxVLCChunkRing_GetCount(const CCNxVLCChunkRing *ring);
+
+/**
+ * Add a descriptor at the tail of the ring. Only called by the producer. On success the ring
+ * takes over the caller's reference to the ContentObject.
+ *
+ * @param [in] ring The ring instance.
+ * @param [in] descriptor The descriptor to add.
+ *
+ * @return true if the descriptor was added, false if the ring is full.
+ */
+bool ccnxVLCChunkRing_Enqueue(CCNxVLCChunkRing *ring, const CCNxVLCChunkDescriptor *descriptor);
+
+/**
+ * Return the descriptor at the head of the ring, without removing it. Only called by the
+ * consumer. The descriptor stays valid until the consumer removes it.
+ *
+ * @param [in] ring The ring instance.
+ *
+ * @return The oldest descriptor in the ring, or NULL if the ring is empty.
+ */
+const CCNxVLCChunkDescriptor *ccnxVLCChunkRing_Peek(CCNxVLCChunkRing *ring);
+
+/**
+ * Remove the descriptor at the head of the ring. Only called by the consumer. The caller
+ * takes over the ring's reference to the ContentObject.
+ *
+ * @param [in] ring The ring instance.
+ * @param [out] descriptor Set to the removed descriptor.
+ *
+ * @return true if a descriptor was removed, false if the ring is empty.
+ */
+bool ccnxVLCChunkRing_Dequeue(CCNxVLCChunkRing *ring, CCNxVLCChunkDescriptor *descriptor);
+
+/**
+ * Remove up to `maxCount` descriptors of consecutive chunks, starting at `firstChunkNumber`,
+ * from the head of the ring, stopping at the first descriptor that doesn't continue the run.
+ * The space they took is handed back to the producer all at once. Only called by the
+ * consumer. The caller takes over the ring's references to the ContentObjects.
+ *
+ * @param [in] ring The ring instance.
+ * @param [in] firstChunkNumber The chunk the head of the ring must hold for anything to be removed.
+ * @param [out] descriptors Set to the removed descriptors, in order.
+ * @param [in] maxCount The most descriptors to remove.
+ *
+ * @return The number of descriptors removed.
+ */
+size_t ccnxVLCChunkRing_DequeueRun(CCNxVLCChunkRing *ring, uint64_t firstChunkNumber,
+                                   CCNxVLCChunkDescriptor descriptors[], size_t maxCount);
+
+#endif // ccnxVLCChunkRing_h
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCChunkedFlow.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include <ccnx/api/ccnx_Portal/ccnx_PortalRTA.h>
+#include <ccnx/common/ccnx_Name.h>
+
+#include "ccnxVLCUtils.h"
+
+// The longest we let the Portal take to accept the Interest that starts the flow.
+#define _SEND_TIMEOUT_US 1000000
+
+struct ccnx_vlc_chunked_flow {
+    CCNxPortal *portal;
+    uint64_t nextChunk;            // The chunk we hand out next
+    uint64_t waitedUs;             // Time spent waiting in GetChunk since the last chunk arrived
+    uint64_t stallTimeoutUs;
+
+    bool finalChunkKnown;
+    uint64_t finalChunkNumber;
+
+    CCNxVLCChunkedFlowStats stats;
+};
+
+CCNxVLCChunkedFlow *
+ccnxVLCChunkedFlow_Create(const CCNxPortalFactory *portalFactory, const CCNxInterest *interest,
+                          uint64_t stallTimeoutUs)
+{
+    CCNxVLCChunkedFlow *result = calloc(1, sizeof(CCNxVLCChunkedFlow));
+    if (result == NULL) {
+        return NULL;
+    }
+
+    result->portal = ccnxPortalFactory_CreatePortal(portalFactory, ccnxPortalRTA_Chunked);
+    if (result->portal == NULL) {
+        free(result);
+        return NULL;
+    }
+
+    CCNxMetaMessage *message = ccnxMetaMessage_CreateFromInterest(interest);
+    bool sent = ccnxPortal_Send(result->portal, message, CCNxStackTimeout_MicroSeconds(_SEND_TIMEOUT_US));
+    ccnxMetaMessage_Release(&message);
+    if (!sent) {
+        ccnxPortal_Release(&result->portal);
+        free(result);
+        return NULL;
+    }
+
+    result->nextChunk = ccnxVLCUtils_GetChunkNumberFromName(ccnxInterest_GetName(interest));
+    result->stallTimeoutUs = stallTimeoutUs;
+    result->stats.startChunk = result->nextChunk;
+
+    return result;
+}
+
+void
+ccnxVLCChunkedFlow_Release(CCNxVLCChunkedFlow **flowP)
+{
+    CCNxVLCChunkedFlow *flow = *flowP;
+
+    ccnxPortal_Release(&flow->portal);
+    free(flow);
+
+    *flowP = NULL;
+}
+
+uint64_t
+ccnxVLCChunkedFlow_GetNextChunkNumber(const CCNxVLCChunkedFlow *flow)
+{
+    return flow->nextChunk;
+}
+
+CCNxVLCFetcherResult
+ccnxVLCChunkedFlow_GetChunk(CCNxVLCChunkedFlow *flow, uint64_t chunkNumber, uint64_t timeoutUs,
+                            CCNxContentObject **contentObjectP)
+{
+    if (chunkNumber < flow->nextChunk) {
+        return CCNxVLCFetcherResult_Error;
+    }
+
+    // Only time spent waiting here counts towards a stall, not time the caller spent paused.
+    uint64_t startUs = ccnxVLCUtils_NowMicroseconds();
+    uint64_t deadlineUs = startUs + timeoutUs;
+
+    while (true) {
+        if (flow->finalChunkKnown && chunkNumber > flow->finalChunkNumber) {
+            return CCNxVLCFetcherResult_EndOfContent;
+        }
+
+        uint64_t nowUs = ccnxVLCUtils_NowMicroseconds();
+        if (flow->waitedUs + (nowUs - startUs) > flow->stallTimeoutUs) {
+            return CCNxVLCFetcherResult_Error;
+        }
+        if (nowUs >= deadlineUs) {
+            flow->waitedUs += nowUs - startUs;
+            return CCNxVLCFetcherResult_Timeout;
+        }
+
+        CCNxMetaMessage *message = ccnxPortal_Receive(flow->portal, CCNxStackTimeout_MicroSeconds(deadlineUs - nowUs));
+        if (message == NULL) {
+            if (ccnxPortal_IsEOF(flow->portal)) {
+                return CCNxVLCFetcherResult_Error;
+            }
+            continue;
+        }
+        if (!ccnxMetaMessage_IsContentObject(message)) {
+            ccnxMetaMessage_Release(&message);
+            continue;
+        }
+
+        CCNxContentObject *contentObject = ccnxContentObject_Acquire(ccnxMetaMessage_GetContentObject(message));
+        ccnxMetaMessage_Release(&message);
+
+        if (ccnxContentObject_HasFinalChunkNumber(contentObject)) {
+            flow->finalChunkKnown = true;
+            flow->finalChunkNumber = ccnxContentObject_GetFinalChunkNumber(contentObject);
+        }
+
+        uint64_t arrivedChunk = ccnxVLCUtils_GetChunkNumberFromName(ccnxContentObject_GetName(contentObject));
+        if (arrivedChunk < chunkNumber) {
+            flow->stats.contentObjectsDiscarded++;
+            ccnxContentObject_Release(&contentObject);
+            continue;
+        }
+        if (arrivedChunk > chunkNumber) {
+            // The flow controller gave up on our chunk. We can't get it back from this flow.
+            flow->stats.contentObjectsDiscarded++;
+            ccnxContentObject_Release(&contentObject);
+            return CCNxVLCFetcherResult_Error;
+        }
+
+        flow->waitedUs = 0;
+        flow->nextChunk = chunkNumber + 1;
+        flow->stats.contentObjectsReceived++;
+        *contentObjectP = contentObject;
+        return CCNxVLCFetcherResult_Success;
+    }
+}
+
+void
+ccnxVLCChunkedFlow_GetStats(const CCNxVLCChunkedFlow *flow, CCNxVLCChunkedFlowStats *stats)
+{
+    *stats = flow->stats;
+}
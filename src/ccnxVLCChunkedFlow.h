@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCChunkedFlow_h
+#define ccnxVLCChunkedFlow_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <ccnx/api/ccnx_Portal/ccnx_Portal.h>
+#include <ccnx/common/ccnx_ContentObject.h>
+#include <ccnx/common/ccnx_Interest.h>
+
+#include "ccnxVLCFetcher.h"
+
+struct ccnx_vlc_chunked_flow;
+typedef struct ccnx_vlc_chunked_flow CCNxVLCChunkedFlow;
+
+/**
+ * Counters describing the work done by a chunked flow.
+ */
+typedef struct ccnx_vlc_chunked_flow_stats {
+    uint64_t startChunk;              // The chunk the flow was started at
+    uint64_t contentObjectsReceived;  // Chunks handed to the caller, in order
+    uint64_t contentObjectsDiscarded; // Duplicates, and chunks before the one we were waiting for
+} CCNxVLCChunkedFlowStats;
+
+/**
+ * Start a flow of consecutive chunks from the transport. A Portal of its own is created in
+ * chunked mode, where the transport's flow controller issues the Interests and delivers the
+ * chunks in order, and `interest` is sent on it. The flow controller starts at the chunk
+ * numbered by the final segment of the Interest's name, so that segment must be the chunk.
+ *
+ * The flow can only move forwards. To read from somewhere else, release it and start a new
+ * one at the new chunk.
+ *
+ * @param [in] portalFactory The factory used to create the Portal.
+ * @param [in] interest The Interest for the first chunk of the flow.
+ * @param [in] stallTimeoutUs How long the flow may go without delivering a chunk before it
+ *                            is considered to have failed.
+ *
+ * @return A new CCNxVLCChunkedFlow instance, or NULL if the Portal could not be created or the
+ *         Interest sent. It must eventually be released by calling ccnxVLCChunkedFlow_Release().
+ */
+CCNxVLCChunkedFlow *ccnxVLCChunkedFlow_Create(const CCNxPortalFactory *portalFactory, const CCNxInterest *interest,
+                                              uint64_t stallTimeoutUs);
+
+/**
+ * Release the flow, closing its Portal and stopping the transport's flow controller.
+ *
+ * @param [in,out] flowP A pointer to the flow to release. It is set to NULL.
+ */
+void ccnxVLCChunkedFlow_Release(CCNxVLCChunkedFlow **flowP);
+
+/**
+ * Return the number of the chunk the flow will deliver next.
+ *
+ * @param [in] flow The flow instance.
+ *
+ * @return The first chunk ccnxVLCChunkedFlow_GetChunk() may be asked for.
+ */
+uint64_t ccnxVLCChunkedFlow_GetNextChunkNumber(const CCNxVLCChunkedFlow *flow);
+
+/**
+ * Wait up to `timeoutUs` for a chunk at or after the next chunk of the flow. Chunks arriving
+ * before it, such as duplicates or chunks the caller found elsewhere, are discarded. If the
+ * transport skips past it, or delivers nothing for longer than the stall timeout, the flow has
+ * failed and the chunk must be retrieved some other way.
+ *
+ * On success the caller owns the returned ContentObject and must release it by calling
+ * ccnxContentObject_Release().
+ *
+ * @param [in] flow The flow instance.
+ * @param [in] chunkNumber The number of the desired chunk. It must not be before the value
+ *                         returned by ccnxVLCChunkedFlow_GetNextChunkNumber().
+ * @param [in] timeoutUs The longest time to wait, in microseconds.
+ * @param [out] contentObjectP Set to the ContentObject for `chunkNumber` on success.
+ *
+ * @return CCNxVLCFetcherResult_Success if `*contentObjectP` was set,
+ *         CCNxVLCFetcherResult_Timeout if the chunk may yet arrive,
+ *         CCNxVLCFetcherResult_EndOfContent if the chunk is past the final chunk, and
+ *         CCNxVLCFetcherResult_Error if the flow has failed.
+ */
+CCNxVLCFetcherResult ccnxVLCChunkedFlow_GetChunk(CCNxVLCChunkedFlow *flow, uint64_t chunkNumber, uint64_t timeoutUs,
+                                                 CCNxContentObject **contentObjectP);
+
+/**
+ * Copy the flow's counters into `stats`.
+ *
+ * @param [in] flow The flow instance.
+ * @param [out] stats The structure to fill in.
+ */
+void ccnxVLCChunkedFlow_GetStats(const CCNxVLCChunkedFlow *flow, CCNxVLCChunkedFlowStats *stats);
+
+#endif // ccnxVLCChunkedFlow_h
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCCongestion.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Vegas-style thresholds for the delay mode, expressed as Interests queued in the network.
+#define _DELAY_ALPHA 2.0
+#define _DELAY_BETA  4.0
+
+// The window never drops below this after a loss, so we keep probing the link.
+#define _MIN_SSTHRESH 2.0
+
+// Retransmission timeout bounds. The initial value is used until we have an RTT sample.
+#define _INITIAL_RTO_US 1000000
+#define _MIN_RTO_US      200000
+#define _MAX_RTO_US    10000000
+
+struct ccnx_vlc_congestion {
+    CCNxVLCCongestionMode mode;
+    double maxWindow;
+
+    CCNxVLCCongestionStats stats;
+
+    // No further decrease is applied until this time, so one loss burst halves the
+    // window once rather than once per lost chunk.
+    uint64_t recoveryEndUs;
+};
+
+static void
+_clamp(CCNxVLCCongestion *congestion)
+{
+    if (congestion->stats.cwnd < 1.0) {
+        congestion->stats.cwnd = 1.0;
+    } else if (congestion->stats.cwnd > congestion->maxWindow) {
+        congestion->stats.cwnd = congestion->maxWindow;
+    }
+}
+
+static uint64_t
+_boundRto(uint64_t rtoUs)
+{
+    if (rtoUs < _MIN_RTO_US) {
+        return _MIN_RTO_US;
+    }
+    if (rtoUs > _MAX_RTO_US) {
+        return _MAX_RTO_US;
+    }
+    return rtoUs;
+}
+
+static void
+_updateRtt(CCNxVLCCongestion *congestion, uint64_t rttUs)
+{
+    CCNxVLCCongestionStats *stats = &congestion->stats;
+
+    if (stats->rttSamples == 0) {
+        stats->srttUs = rttUs;
+        stats->rttvarUs = rttUs / 2;
+        stats->minRttUs = rttUs;
+    } else {
+        // RFC 6298: rttvar = 3/4 rttvar + 1/4 |srtt - sample|, then srtt = 7/8 srtt + 1/8 sample.
+        uint64_t deviation = (stats->srttUs > rttUs) ? stats->srttUs - rttUs : rttUs - stats->srttUs;
+        stats->rttvarUs = (3 * stats->rttvarUs + deviation) / 4;
+        stats->srttUs = (7 * stats->srttUs + rttUs) / 8;
+        if (rttUs < stats->minRttUs) {
+            stats->minRttUs = rttUs;
+        }
+    }
+    stats->rttSamples++;
+
+    // A fresh sample also ends any exponential backoff from earlier timeouts.
+    stats->rtoUs = _boundRto(stats->srttUs + 4 * stats->rttvarUs);
+}
+
+/**
+ * Halve the window, unless we have already done so within the last round trip.
+ */
+static bool
+_decrease(CCNxVLCCongestion *congestion, uint64_t nowUs)
+{
+    if (nowUs < congestion->recoveryEndUs) {
+        return false;
+    }
+
+    CCNxVLCCongestionStats *stats = &congestion->stats;
+    stats->ssthresh = stats->cwnd / 2.0;
+    if (stats->ssthresh < _MIN_SSTHRESH) {
+        stats->ssthresh = _MIN_SSTHRESH;
+    }
+    stats->cwnd = stats->ssthresh;
+    stats->decreases++;
+    congestion->recoveryEndUs = nowUs + stats->srttUs;
+
+    _clamp(congestion);
+    return true;
+}
+
+CCNxVLCCongestion *
+ccnxVLCCongestion_Create(CCNxVLCCongestionMode mode, size_t initialWindow, size_t maxWindow)
+{
+    CCNxVLCCongestion *result = calloc(1, sizeof(CCNxVLCCongestion));
+    if (result != NULL) {
+        result->mode = mode;
+        result->maxWindow = (double) maxWindow;
+        result->stats.cwnd = (mode == CCNxVLCCongestionMode_Fixed) ? (double) maxWindow : (double) initialWindow;
+        result->stats.ssthresh = (double) maxWindow;
+        result->stats.rtoUs = _INITIAL_RTO_US;
+        _clamp(result);
+    }
+    return result;
+}
+
+void
+ccnxVLCCongestion_Release(CCNxVLCCongestion **congestionP)
+{
+    free(*congestionP);
+    *congestionP = NULL;
+}
+
+int
+ccnxVLCCongestion_ParseMode(const char *name, CCNxVLCCongestionMode *mode)
+{
+    if (name == NULL) {
+        return -1;
+    }
+    if (strcmp(name, "fixed") == 0) {
+        *mode = CCNxVLCCongestionMode_Fixed;
+    } else if (strcmp(name, "aimd") == 0) {
+        *mode = CCNxVLCCongestionMode_AIMD;
+    } else if (strcmp(name, "delay") == 0) {
+        *mode = CCNxVLCCongestionMode_Delay;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+void
+ccnxVLCCongestion_OnContent(CCNxVLCCongestion *congestion, uint64_t rttUs)
+{
+    CCNxVLCCongestionStats *stats = &congestion->stats;
+
+    if (rttUs > 0) {
+        _updateRtt(congestion, rttUs);
+    }
+
+    if (congestion->mode == CCNxVLCCongestionMode_Fixed) {
+        return;
+    }
+
+    // Vegas estimate of how many of our Interests are sitting in queues:
+    //   diff = cwnd * (1 - minRtt / rtt)
+    double queued = 0.0;
+    bool delayValid = (congestion->mode == CCNxVLCCongestionMode_Delay) && rttUs > 0 && stats->minRttUs > 0;
+    if (delayValid) {
+        queued = stats->cwnd * (1.0 - (double) stats->minRttUs / (double) rttUs);
+    }
+
+    if (stats->cwnd < stats->ssthresh) {
+        if (delayValid && queued > 1.0) {
+            // Queues are building; leave slow start before we cause a loss.
+            stats->ssthresh = stats->cwnd;
+        } else {
+            stats->cwnd += 1.0;
+        }
+    } else if (delayValid && queued > _DELAY_BETA) {
+        stats->cwnd -= 1.0 / stats->cwnd;
+    } else if (!delayValid || queued < _DELAY_ALPHA) {
+        stats->cwnd += 1.0 / stats->cwnd;
+    }
+
+    _clamp(congestion);
+}
+
+void
+ccnxVLCCongestion_OnGap(CCNxVLCCongestion *congestion, uint64_t nowUs)
+{
+    congestion->stats.gapEvents++;
+    if (congestion->mode != CCNxVLCCongestionMode_Fixed) {
+        _decrease(congestion, nowUs);
+    }
+}
+
+void
+ccnxVLCCongestion_OnTimeout(CCNxVLCCongestion *congestion, uint64_t nowUs)
+{
+    congestion->stats.timeouts++;
+    congestion->stats.rtoUs = _boundRto(congestion->stats.rtoUs * 2);
+    if (congestion->mode != CCNxVLCCongestionMode_Fixed && _decrease(congestion, nowUs)) {
+        congestion->stats.cwnd = 1.0;
+    }
+}
+
+uint64_t
+ccnxVLCCongestion_GetRto(const CCNxVLCCongestion *congestion)
+{
+    return congestion->stats.rtoUs;
+}
+
+size_t
+ccnxVLCCongestion_GetWindow(const CCNxVLCCongestion *congestion)
+{
+    return (size_t) congestion->stats.cwnd;
+}
+
+void
+ccnxVLCCongestion_GetStats(const CCNxVLCCongestion *congestion, CCNxVLCCongestionStats *stats)
+{
+    *stats = congestion->stats;
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCCongestion_h
+#define ccnxVLCCongestion_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct ccnx_vlc_congestion;
+typedef struct ccnx_vlc_congestion CCNxVLCCongestion;
+
+/**
+ * How the congestion window reacts to the ContentObjects we receive.
+ */
+typedef enum {
+    CCNxVLCCongestionMode_Fixed,   // The window is always the maximum window
+    CCNxVLCCongestionMode_AIMD,    // Slow start, then additive increase / multiplicative decrease
+    CCNxVLCCongestionMode_Delay    // As AIMD, but also backs off as the RTT rises above its minimum
+} CCNxVLCCongestionMode;
+
+/**
+ * A snapshot of the state of a CCNxVLCCongestion instance.
+ */
+typedef struct ccnx_vlc_congestion_stats {
+    double   cwnd;          // The congestion window, in Interests
+    double   ssthresh;      // The slow start threshold, in Interests
+    uint64_t srttUs;        // Smoothed RTT estimate, in microseconds (0 until the first sample)
+    uint64_t rttvarUs;      // Smoothed RTT variation, in microseconds
+    uint64_t rtoUs;         // Current retransmission timeout, in microseconds
+    uint64_t minRttUs;      // Smallest RTT seen, in microseconds (0 until the first sample)
+    uint64_t rttSamples;    // Number of RTT samples taken
+    uint64_t gapEvents;     // Number of times a chunk was overtaken by later chunks
+    uint64_t timeouts;      // Number of Interest timeouts reported
+    uint64_t decreases;     // Number of times the window was reduced
+} CCNxVLCCongestionStats;
+
+/**
+ * Create a congestion controller. The window starts at `initialWindow` and never exceeds
+ * `maxWindow`. The returned instance must eventually be released by calling
+ * ccnxVLCCongestion_Release().
+ *
+ * @param [in] mode The congestion control algorithm to use.
+ * @param [in] initialWindow The initial window, in Interests. Must be > 0.
+ * @param [in] maxWindow The largest window allowed, in Interests. Must be >= `initialWindow`.
+ *
+ * @return A new CCNxVLCCongestion instance, or NULL if memory could not be allocated.
+ */
+CCNxVLCCongestion *ccnxVLCCongestion_Create(CCNxVLCCongestionMode mode, size_t initialWindow, size_t maxWindow);
+
+/**
+ * Release the congestion controller.
+ *
+ * @param [in,out] congestionP A pointer to the instance to release. It is set to NULL.
+ */
+void ccnxVLCCongestion_Release(CCNxVLCCongestion **congestionP);
+
+/**
+ * Parse the name of a congestion control mode ("fixed", "aimd" or "delay").
+ *
+ * @param [in] name The name of the mode.
+ * @param [out] mode Set to the corresponding mode if the name is recognised.
+ *
+ * @return 0 if `name` was recognised, -1 otherwise.
+ */
+int ccnxVLCCongestion_ParseMode(const char *name, CCNxVLCCongestionMode *mode);
+
+/**
+ * Report a timely ContentObject and the round trip time of the Interest that fetched it.
+ * This grows the window, or in delay mode may shrink it if the RTT is rising.
+ *
+ * @param [in] congestion The congestion controller.
+ * @param [in] rttUs The RTT of the Interest, in microseconds, or 0 if it is not a valid sample
+ *                   (e.g. the Interest was retransmitted, so we can't tell which copy was answered).
+ */
+void ccnxVLCCongestion_OnContent(CCNxVLCCongestion *congestion, uint64_t rttUs);
+
+/**
+ * Report that a chunk has been overtaken by enough later chunks that it is probably lost.
+ * The window is halved, at most once per round trip.
+ *
+ * @param [in] congestion The congestion controller.
+ * @param [in] nowUs The current time, in microseconds.
+ */
+void ccnxVLCCongestion_OnGap(CCNxVLCCongestion *congestion, uint64_t nowUs);
+
+/**
+ * Report that an Interest timed out. The slow start threshold is halved and the window
+ * collapses to a single Interest. The retransmission timeout is doubled until the next
+ * valid RTT sample.
+ *
+ * @param [in] congestion The congestion controller.
+ * @param [in] nowUs The current time, in microseconds.
+ */
+void ccnxVLCCongestion_OnTimeout(CCNxVLCCongestion *congestion, uint64_t nowUs);
+
+/**
+ * Return how long to wait for a ContentObject before retransmitting its Interest. This is
+ * srtt + 4 * rttvar (Jacobson/Karels, as in RFC 6298), bounded to a sane range, and starts
+ * at one second before the first RTT sample.
+ *
+ * @param [in] congestion The congestion controller.
+ *
+ * @return The retransmission timeout, in microseconds.
+ */
+uint64_t ccnxVLCCongestion_GetRto(const CCNxVLCCongestion *congestion);
+
+/**
+ * Return the number of Interests that may currently be outstanding.
+ *
+ * @param [in] congestion The congestion controller.
+ *
+ * @return The current window, between 1 and the maximum window.
+ */
+size_t ccnxVLCCongestion_GetWindow(const CCNxVLCCongestion *congestion);
+
+/**
+ * Copy the current state of the congestion controller into `stats`.
+ *
+ * @param [in] congestion The congestion controller.
+ * @param [out] stats The structure to fill in.
+ */
+void ccnxVLCCongestion_GetStats(const CCNxVLCCongestion *congestion, CCNxVLCCongestionStats *stats);
+
+#endif // ccnxVLCCongestion_h
@@ -0,0 +1,552 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCDiskCache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define _MAGIC "CCNXVLC1"
+
+#define _INDEX_SUFFIX ".idx"
+#define _DATA_SUFFIX ".data"
+
+// Files are named after a 64-bit hash of the title, in hexadecimal.
+#define _BASENAME_LENGTH 16
+
+// Chunks written but not yet marked present, before the data file is synced to disk and
+// they are all marked at once.
+#define _SYNC_BATCH_CHUNKS 64
+
+/**
+ * The start of an index file. It is followed by the title, which tells hash collisions
+ * apart, and then by the bitmap of the chunks present, one bit per chunk.
+ */
+typedef struct _disk_cache_header {
+    char magic[8];
+    uint64_t chunkSize;
+    uint64_t chunkCount;
+    uint64_t contentSize;
+    uint64_t titleLength;
+} _DiskCacheHeader;
+
+struct ccnx_vlc_disk_cache {
+    pthread_mutex_t lock;       // Guards the pending chunks and the counters
+
+    int dataFd;
+    const uint8_t *data;        // The data file, mapped read-only
+    size_t dataSize;
+
+    _DiskCacheHeader *header;   // The index file, mapped read-write so bitmap updates persist
+    size_t indexSize;
+    _Atomic uint8_t *bitmap;    // Shared with every instance mapping the entry, in any process
+
+    uint64_t pendingChunks[_SYNC_BATCH_CHUNKS];  // Written, but not yet synced and marked present
+    size_t pendingCount;
+
+    CCNxVLCDiskCacheStats stats;
+};
+
+static uint64_t
+_hashTitle(const char *title)
+{
+    // 64-bit FNV-1a
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    for (const char *c = title; *c != '\0'; c++) {
+        hash = (hash ^ (uint8_t) *c) * UINT64_C(0x100000001b3);
+    }
+    return hash;
+}
+
+/**
+ * Return the path of a cache file, which the caller must free.
+ */
+static char *
+_createPath(const char *directory, const char *basename, const char *suffix)
+{
+    size_t length = strlen(directory) + 1 + strlen(basename) + strlen(suffix) + 1;
+    char *result = malloc(length);
+    if (result != NULL) {
+        snprintf(result, length, "%s/%s%s", directory, basename, suffix);
+    }
+    return result;
+}
+
+static void
+_formatBasename(const char *title, char basename[_BASENAME_LENGTH + 1])
+{
+    snprintf(basename, _BASENAME_LENGTH + 1, "%016"PRIx64, _hashTitle(title));
+}
+
+static size_t
+_indexSize(uint64_t titleLength, uint64_t chunkCount)
+{
+    return sizeof(_DiskCacheHeader) + (size_t) titleLength + (size_t) ((chunkCount + 7) / 8);
+}
+
+static void
+_removeTitle(const char *directory, const char *basename)
+{
+    char *indexPath = _createPath(directory, basename, _INDEX_SUFFIX);
+    char *dataPath = _createPath(directory, basename, _DATA_SUFFIX);
+    if (indexPath != NULL) {
+        // The index goes first: without it, the data file is never used.
+        unlink(indexPath);
+    }
+    if (dataPath != NULL) {
+        unlink(dataPath);
+    }
+    free(indexPath);
+    free(dataPath);
+}
+
+typedef struct _cached_title {
+    char basename[_BASENAME_LENGTH + 1];
+    time_t lastUsed;
+    uint64_t bytes;
+} _CachedTitle;
+
+static int
+_compareLastUsed(const void *a, const void *b)
+{
+    time_t lastUsedA = ((const _CachedTitle *) a)->lastUsed;
+    time_t lastUsedB = ((const _CachedTitle *) b)->lastUsed;
+    return (lastUsedA > lastUsedB) - (lastUsedA < lastUsedB);
+}
+
+/**
+ * List the titles in `directory`, apart from `keep`, with the disk space their files take.
+ * Returns the number of titles, and the array in `titlesP`, which the caller must free.
+ */
+static size_t
+_listTitles(const char *directory, const char *keep, _CachedTitle **titlesP, uint64_t *totalBytesP)
+{
+    _CachedTitle *titles = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    uint64_t totalBytes = 0;
+
+    DIR *dir = opendir(directory);
+    if (dir != NULL) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            size_t nameLength = strlen(entry->d_name);
+            if (nameLength != _BASENAME_LENGTH + strlen(_INDEX_SUFFIX)
+                || strcmp(entry->d_name + _BASENAME_LENGTH, _INDEX_SUFFIX) != 0
+                || strncmp(entry->d_name, keep, _BASENAME_LENGTH) == 0) {
+                continue;
+            }
+
+            if (count == capacity) {
+                size_t newCapacity = (capacity == 0) ? 16 : capacity * 2;
+                _CachedTitle *newTitles = realloc(titles, newCapacity * sizeof(_CachedTitle));
+                if (newTitles == NULL) {
+                    break;
+                }
+                titles = newTitles;
+                capacity = newCapacity;
+            }
+
+            _CachedTitle *title = &titles[count];
+            memcpy(title->basename, entry->d_name, _BASENAME_LENGTH);
+            title->basename[_BASENAME_LENGTH] = '\0';
+
+            struct stat indexStat;
+            struct stat dataStat;
+            char *indexPath = _createPath(directory, title->basename, _INDEX_SUFFIX);
+            char *dataPath = _createPath(directory, title->basename, _DATA_SUFFIX);
+            bool found = indexPath != NULL && dataPath != NULL && stat(indexPath, &indexStat) == 0;
+            if (found) {
+                // Count the blocks actually allocated: the data files are sparse.
+                title->lastUsed = indexStat.st_mtime;
+                title->bytes = (uint64_t) indexStat.st_blocks * 512;
+                if (stat(dataPath, &dataStat) == 0) {
+                    title->bytes += (uint64_t) dataStat.st_blocks * 512;
+                }
+                totalBytes += title->bytes;
+                count++;
+            }
+            free(indexPath);
+            free(dataPath);
+        }
+        closedir(dir);
+    }
+
+    *titlesP = titles;
+    *totalBytesP = totalBytes;
+    return count;
+}
+
+/**
+ * Delete the least recently used titles, other than `keep`, until the others take at most
+ * `budgetBytes`. Returns the number of titles deleted.
+ */
+static uint64_t
+_evictTitles(const char *directory, const char *keep, uint64_t budgetBytes)
+{
+    _CachedTitle *titles;
+    uint64_t totalBytes;
+    size_t count = _listTitles(directory, keep, &titles, &totalBytes);
+
+    qsort(titles, count, sizeof(_CachedTitle), _compareLastUsed);
+
+    uint64_t evicted = 0;
+    for (size_t i = 0; i < count && totalBytes > budgetBytes; i++) {
+        _removeTitle(directory, titles[i].basename);
+        totalBytes -= titles[i].bytes;
+        evicted++;
+    }
+
+    free(titles);
+    return evicted;
+}
+
+/**
+ * Sync the data file, then mark the pending chunks present. A chunk's bit must not reach the
+ * index before its bytes reach the data file, or a later run, after a crash, could read a
+ * hole as the chunk. If the sync fails the chunks are left unmarked, to be fetched again.
+ * Called with the lock held, or once no other thread uses the instance.
+ */
+static void
+_syncPendingChunks(CCNxVLCDiskCache *diskCache)
+{
+    if (diskCache->pendingCount > 0 && fdatasync(diskCache->dataFd) == 0) {
+        for (size_t i = 0; i < diskCache->pendingCount; i++) {
+            uint64_t chunkNumber = diskCache->pendingChunks[i];
+            atomic_fetch_or(&diskCache->bitmap[chunkNumber / 8], (uint8_t) (1 << (chunkNumber % 8)));
+        }
+    }
+    diskCache->pendingCount = 0;
+}
+
+static bool
+_isPresent(const CCNxVLCDiskCache *diskCache, uint64_t chunkNumber)
+{
+    return (atomic_load(&diskCache->bitmap[chunkNumber / 8]) & (1 << (chunkNumber % 8))) != 0;
+}
+
+static void
+_destroy(CCNxVLCDiskCache *diskCache)
+{
+    _syncPendingChunks(diskCache);
+    if (diskCache->header != NULL) {
+        munmap(diskCache->header, diskCache->indexSize);
+    }
+    if (diskCache->data != NULL) {
+        munmap((void *) diskCache->data, diskCache->dataSize);
+    }
+    if (diskCache->dataFd >= 0) {
+        close(diskCache->dataFd);
+    }
+    pthread_mutex_destroy(&diskCache->lock);
+    free(diskCache);
+}
+
+/**
+ * Map the index and data files of an entry whose index is open as `indexFd`. If `title` is
+ * not NULL, the index must have been written for it.
+ */
+static CCNxVLCDiskCache *
+_mapEntry(int indexFd, const char *dataPath, const char *title)
+{
+    struct stat indexStat;
+    if (fstat(indexFd, &indexStat) != 0 || (size_t) indexStat.st_size < sizeof(_DiskCacheHeader)) {
+        return NULL;
+    }
+
+    CCNxVLCDiskCache *result = calloc(1, sizeof(CCNxVLCDiskCache));
+    if (result == NULL) {
+        return NULL;
+    }
+    result->dataFd = -1;
+    pthread_mutex_init(&result->lock, NULL);
+
+    void *index = mmap(NULL, (size_t) indexStat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, indexFd, 0);
+    if (index == MAP_FAILED) {
+        _destroy(result);
+        return NULL;
+    }
+    result->header = index;
+    result->indexSize = (size_t) indexStat.st_size;
+
+    const _DiskCacheHeader *header = result->header;
+    if (memcmp(header->magic, _MAGIC, sizeof(header->magic)) != 0
+        || header->contentSize == 0 || header->chunkCount == 0
+        || header->titleLength > result->indexSize
+        || _indexSize(header->titleLength, header->chunkCount) != result->indexSize) {
+        _destroy(result);
+        return NULL;
+    }
+
+    const char *storedTitle = (const char *) (header + 1);
+    if (title != NULL
+        && (strlen(title) != header->titleLength || memcmp(storedTitle, title, header->titleLength) != 0)) {
+        _destroy(result);
+        return NULL;
+    }
+    result->bitmap = (_Atomic uint8_t *) (storedTitle + header->titleLength);
+    result->stats.chunkCount = header->chunkCount;
+
+    struct stat dataStat;
+    result->dataFd = open(dataPath, O_RDWR);
+    if (result->dataFd < 0 || fstat(result->dataFd, &dataStat) != 0
+        || (uint64_t) dataStat.st_size != header->contentSize) {
+        _destroy(result);
+        return NULL;
+    }
+
+    void *data = mmap(NULL, (size_t) header->contentSize, PROT_READ, MAP_SHARED, result->dataFd, 0);
+    if (data == MAP_FAILED) {
+        _destroy(result);
+        return NULL;
+    }
+    result->data = data;
+    result->dataSize = (size_t) header->contentSize;
+
+    return result;
+}
+
+CCNxVLCDiskCache *
+ccnxVLCDiskCache_Open(const char *directory, const char *title)
+{
+    char basename[_BASENAME_LENGTH + 1];
+    _formatBasename(title, basename);
+
+    char *indexPath = _createPath(directory, basename, _INDEX_SUFFIX);
+    char *dataPath = _createPath(directory, basename, _DATA_SUFFIX);
+    CCNxVLCDiskCache *result = NULL;
+
+    if (indexPath != NULL && dataPath != NULL) {
+        int indexFd = open(indexPath, O_RDWR);
+        if (indexFd >= 0) {
+            result = _mapEntry(indexFd, dataPath, title);
+            if (result != NULL) {
+                // The modification time of the index orders titles for eviction.
+                futimens(indexFd, NULL);
+            }
+            close(indexFd);
+        }
+    }
+
+    free(indexPath);
+    free(dataPath);
+    return result;
+}
+
+CCNxVLCDiskCache *
+ccnxVLCDiskCache_Create(const char *directory, const char *title, uint64_t quotaBytes,
+                        uint64_t chunkSize, uint64_t chunkCount, uint64_t contentSize)
+{
+    size_t titleLength = strlen(title);
+    size_t indexSize = _indexSize(titleLength, chunkCount);
+    if (contentSize == 0 || chunkCount == 0 || contentSize + indexSize > quotaBytes) {
+        return NULL;
+    }
+
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        return NULL;
+    }
+
+    char basename[_BASENAME_LENGTH + 1];
+    _formatBasename(title, basename);
+
+    uint64_t evicted = _evictTitles(directory, basename, quotaBytes - contentSize - indexSize);
+
+    // Replace, rather than truncate, the files of an older entry for this title: another
+    // stream may still have them mapped.
+    _removeTitle(directory, basename);
+
+    char *indexPath = _createPath(directory, basename, _INDEX_SUFFIX);
+    char *dataPath = _createPath(directory, basename, _DATA_SUFFIX);
+    CCNxVLCDiskCache *result = NULL;
+
+    if (indexPath != NULL && dataPath != NULL) {
+        // The data file is sparse: it takes no space until chunks are written to it.
+        int dataFd = open(dataPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        bool dataReady = dataFd >= 0 && ftruncate(dataFd, (off_t) contentSize) == 0;
+        if (dataFd >= 0) {
+            close(dataFd);
+        }
+
+        int indexFd = dataReady ? open(indexPath, O_RDWR | O_CREAT | O_TRUNC, 0644) : -1;
+        if (indexFd >= 0) {
+            _DiskCacheHeader header;
+            memcpy(header.magic, _MAGIC, sizeof(header.magic));
+            header.chunkSize = chunkSize;
+            header.chunkCount = chunkCount;
+            header.contentSize = contentSize;
+            header.titleLength = titleLength;
+
+            // The bitmap is the zero-filled tail that ftruncate adds.
+            if (pwrite(indexFd, &header, sizeof(header), 0) == (ssize_t) sizeof(header)
+                && pwrite(indexFd, title, titleLength, sizeof(header)) == (ssize_t) titleLength
+                && ftruncate(indexFd, (off_t) indexSize) == 0) {
+                result = _mapEntry(indexFd, dataPath, title);
+            }
+            close(indexFd);
+        }
+
+        if (result == NULL) {
+            _removeTitle(directory, basename);
+        } else {
+            result->stats.titlesEvicted = evicted;
+        }
+    }
+
+    free(indexPath);
+    free(dataPath);
+    return result;
+}
+
+void
+ccnxVLCDiskCache_Release(CCNxVLCDiskCache **diskCacheP)
+{
+    _destroy(*diskCacheP);
+    *diskCacheP = NULL;
+}
+
+uint64_t
+ccnxVLCDiskCache_GetChunkSize(const CCNxVLCDiskCache *diskCache)
+{
+    return diskCache->header->chunkSize;
+}
+
+uint64_t
+ccnxVLCDiskCache_GetChunkCount(const CCNxVLCDiskCache *diskCache)
+{
+    return diskCache->header->chunkCount;
+}
+
+uint64_t
+ccnxVLCDiskCache_GetContentSize(const CCNxVLCDiskCache *diskCache)
+{
+    return diskCache->header->contentSize;
+}
+
+bool
+ccnxVLCDiskCache_PutChunk(CCNxVLCDiskCache *diskCache, uint64_t chunkNumber, uint64_t offset,
+                          const uint8_t *data, size_t length)
+{
+    if (chunkNumber >= diskCache->header->chunkCount || offset > diskCache->header->contentSize
+        || length > diskCache->header->contentSize - offset) {
+        return false;
+    }
+
+    size_t written = 0;
+    while (written < length) {
+        ssize_t result = pwrite(diskCache->dataFd, data + written, length - written, (off_t) (offset + written));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        written += (size_t) result;
+    }
+
+    // The bit is only set once the data is synced, see _syncPendingChunks. Other instances
+    // for the same title may set bits in the same byte at any time, hence the atomic OR.
+    pthread_mutex_lock(&diskCache->lock);
+    diskCache->pendingChunks[diskCache->pendingCount++] = chunkNumber;
+    if (diskCache->pendingCount == _SYNC_BATCH_CHUNKS) {
+        _syncPendingChunks(diskCache);
+    }
+    diskCache->stats.chunksWritten++;
+    pthread_mutex_unlock(&diskCache->lock);
+
+    return true;
+}
+
+bool
+ccnxVLCDiskCache_HasChunk(CCNxVLCDiskCache *diskCache, uint64_t chunkNumber)
+{
+    if (chunkNumber >= diskCache->header->chunkCount) {
+        return false;
+    }
+
+    return _isPresent(diskCache, chunkNumber);
+}
+
+const uint8_t *
+ccnxVLCDiskCache_GetData(const CCNxVLCDiskCache *diskCache)
+{
+    return diskCache->data;
+}
+
+void
+ccnxVLCDiskCache_GetStats(CCNxVLCDiskCache *diskCache, CCNxVLCDiskCacheStats *stats)
+{
+    pthread_mutex_lock(&diskCache->lock);
+
+    *stats = diskCache->stats;
+    stats->chunksPresent = 0;
+    for (uint64_t i = 0; i < diskCache->header->chunkCount; i++) {
+        if (_isPresent(diskCache, i)) {
+            stats->chunksPresent++;
+        }
+    }
+
+    pthread_mutex_unlock(&diskCache->lock);
+}
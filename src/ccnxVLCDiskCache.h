@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCDiskCache_h
+#define ccnxVLCDiskCache_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+struct ccnx_vlc_disk_cache;
+typedef struct ccnx_vlc_disk_cache CCNxVLCDiskCache;
+
+/**
+ * Counters describing the use of a CCNxVLCDiskCache.
+ */
+typedef struct ccnx_vlc_disk_cache_stats {
+    uint64_t chunkCount;     // Chunks in the title
+    uint64_t chunksPresent;  // Chunks stored on disk, by us or an earlier run
+    uint64_t chunksWritten;  // Chunks we stored
+    uint64_t titlesEvicted;  // Other titles deleted to make room for this one
+} CCNxVLCDiskCacheStats;
+
+/**
+ * Open the disk cache entry of a title stored by an earlier run. The title's chunks are kept
+ * in `directory` in a sparse file laid out like the content, so that any byte range of it can
+ * be read straight from a memory mapping, next to an index holding the chunk size, the
+ * content size and a bitmap of the chunks present. Both files are named after a hash of
+ * `title`. Opening an entry marks it as recently used.
+ *
+ * The returned instance is thread-safe, and must eventually be released by calling
+ * ccnxVLCDiskCache_Release().
+ *
+ * @param [in] directory The directory holding the cache.
+ * @param [in] title What identifies the content, e.g. the name of its first chunk.
+ *
+ * @return A CCNxVLCDiskCache instance, or NULL if the title is not cached or its entry is damaged.
+ */
+CCNxVLCDiskCache *ccnxVLCDiskCache_Open(const char *directory, const char *title);
+
+/**
+ * Create an empty disk cache entry for a title, replacing any existing one. To keep the whole
+ * cache within `quotaBytes`, the least recently used other titles are deleted first. A
+ * stream still reading a deleted title keeps its mapping, but its chunks are gone for the
+ * next run.
+ *
+ * The returned instance must eventually be released by calling ccnxVLCDiskCache_Release().
+ *
+ * @param [in] directory The directory holding the cache. It is created if it doesn't exist.
+ * @param [in] title What identifies the content, e.g. the name of its first chunk.
+ * @param [in] quotaBytes The most disk space all titles in `directory` may take together.
+ * @param [in] chunkSize The size of every chunk but the final one, or of the first chunk
+ *             if chunks vary in size.
+ * @param [in] chunkCount The number of chunks, one more than the final chunk number.
+ * @param [in] contentSize The size of the content in bytes.
+ *
+ * @return A new CCNxVLCDiskCache instance, or NULL if the title does not fit in the quota or
+ *         the files could not be created.
+ */
+CCNxVLCDiskCache *ccnxVLCDiskCache_Create(const char *directory, const char *title, uint64_t quotaBytes,
+                                          uint64_t chunkSize, uint64_t chunkCount, uint64_t contentSize);
+
+/**
+ * Release the disk cache, unmapping and closing its files. The chunks stored stay on disk.
+ *
+ * @param [in,out] diskCacheP A pointer to the disk cache to release. It is set to NULL.
+ */
+void ccnxVLCDiskCache_Release(CCNxVLCDiskCache **diskCacheP);
+
+/**
+ * Return the chunk size given when the entry was created.
+ *
+ * @param [in] diskCache The disk cache.
+ *
+ * @return The size of every chunk but the final one, in bytes.
+ */
+uint64_t ccnxVLCDiskCache_GetChunkSize(const CCNxVLCDiskCache *diskCache);
+
+/**
+ * Return the number of chunks given when the entry was created.
+ *
+ * @param [in] diskCache The disk cache.
+ *
+ * @return The number of chunks, one more than the final chunk number.
+ */
+uint64_t ccnxVLCDiskCache_GetChunkCount(const CCNxVLCDiskCache *diskCache);
+
+/**
+ * Return the content size given when the entry was created.
+ *
+ * @param [in] diskCache The disk cache.
+ *
+ * @return The size of the content in bytes.
+ */
+uint64_t ccnxVLCDiskCache_GetContentSize(const CCNxVLCDiskCache *diskCache);
+
+/**
+ * Store a chunk at its position in the content. It is marked present once the data file has
+ * been synced, which is done for a batch of chunks at a time and when the disk cache is
+ * released, so ccnxVLCDiskCache_HasChunk() may not report it straight away.
+ *
+ * @param [in] diskCache The disk cache.
+ * @param [in] chunkNumber The chunk number.
+ * @param [in] offset The byte offset of the chunk in the content.
+ * @param [in] data The payload of the chunk.
+ * @param [in] length The length of the payload; the chunk must end within the content.
+ *
+ * @return true if the chunk was stored, false if it doesn't fit the content or the write failed.
+ */
+bool ccnxVLCDiskCache_PutChunk(CCNxVLCDiskCache *diskCache, uint64_t chunkNumber, uint64_t offset,
+                               const uint8_t *data, size_t length);
+
+/**
+ * Return whether a chunk is stored, by this stream or any other user of the same directory.
+ *
+ * @param [in] diskCache The disk cache.
+ * @param [in] chunkNumber The chunk number.
+ *
+ * @return true if the bytes of the chunk can be read from ccnxVLCDiskCache_GetData().
+ */
+bool ccnxVLCDiskCache_HasChunk(CCNxVLCDiskCache *diskCache, uint64_t chunkNumber);
+
+/**
+ * Return the mapping of the content, ccnxVLCDiskCache_GetContentSize() bytes long. Only the
+ * bytes of chunks for which ccnxVLCDiskCache_HasChunk() returns true are meaningful. The
+ * mapping is read-only, and valid until the disk cache is released.
+ *
+ * @param [in] diskCache The disk cache.
+ *
+ * @return A pointer to the first byte of the content.
+ */
+const uint8_t *ccnxVLCDiskCache_GetData(const CCNxVLCDiskCache *diskCache);
+
+/**
+ * Copy the disk cache's counters into `stats`.
+ *
+ * @param [in] diskCache The disk cache.
+ * @param [out] stats The structure to fill in.
+ */
+void ccnxVLCDiskCache_GetStats(CCNxVLCDiskCache *diskCache, CCNxVLCDiskCacheStats *stats);
+
+#endif // ccnxVLCDiskCache_h
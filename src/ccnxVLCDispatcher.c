@@ -0,0 +1,548 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCDispatcher.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ccnx/api/ccnx_Portal/ccnx_PortalRTA.h>
+#include <ccnx/common/ccnx_Name.h>
+
+#include "ccnxVLCUtils.h"
+
+// Fixed, as each stream only has its fetch window of Interests outstanding.
+#define _PENDING_BUCKETS 1024
+
+// How often the receive thread checks whether it should stop, and sweeps expired names.
+#define _POLL_INTERVAL_MS 100
+#define _SWEEP_INTERVAL_US 1000000
+
+// How long a name stays registered after its last Interest if nothing answers it. By then
+// the stream that sent it has long given up on it, e.g. after seeking away.
+#define _PENDING_LIFETIME_US 30000000
+
+/**
+ * A name some stream sent an Interest for and has not yet received.
+ */
+typedef struct _pending_entry {
+    CCNxName *name;
+    uint32_t hash;
+    CCNxVLCDispatcherStream *stream;
+    uint64_t lastSentUs;
+
+    struct _pending_entry *next;      // The next entry in the same bucket
+} _PendingEntry;
+
+struct ccnx_vlc_dispatcher {
+    unsigned references;              // Guarded by _sharedLock
+
+    const CCNxVLCPortalInterface *portalInterface;
+    void *portal;
+    pthread_mutex_t portalLock;       // Serializes use of the Portal
+    pthread_t receiveThread;
+
+    pthread_mutex_t lock;             // Guards everything below, and every stream's queue
+    bool closing;                     // The receive thread should exit
+    bool failed;                      // The Portal failed; nothing more will arrive
+
+    _PendingEntry *pending[_PENDING_BUCKETS];
+    CCNxVLCDispatcherStream *streams; // Every attached stream
+
+    CCNxVLCDispatcherStats stats;
+};
+
+struct ccnx_vlc_dispatcher_stream {
+    CCNxVLCDispatcher *dispatcher;
+    pthread_cond_t arrived;           // Signalled, under the dispatcher's lock, when the queue grows
+
+    // ContentObjects received for this stream, oldest first.
+    CCNxContentObject **queue;
+    size_t queueCapacity;
+    size_t queueHead;
+    size_t queueCount;
+
+    CCNxVLCDispatcherStream *next;    // The next attached stream
+};
+
+static CCNxVLCDispatcher *_sharedDispatcher = NULL;
+static pthread_mutex_t _sharedLock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t
+_bucketIndex(uint32_t hash)
+{
+    return (size_t) (((uint64_t) hash * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (_PENDING_BUCKETS - 1);
+}
+
+static void
+_removePending(CCNxVLCDispatcher *dispatcher, _PendingEntry **link)
+{
+    _PendingEntry *entry = *link;
+    *link = entry->next;
+
+    ccnxName_Release(&entry->name);
+    free(entry);
+    dispatcher->stats.pending--;
+}
+
+/**
+ * Append a ContentObject to a stream's queue, growing it if needed. Must be called with the
+ * dispatcher's lock held.
+ */
+static bool
+_enqueue(CCNxVLCDispatcherStream *stream, CCNxContentObject *contentObject)
+{
+    if (stream->queueCount == stream->queueCapacity) {
+        size_t newCapacity = (stream->queueCapacity == 0) ? 16 : stream->queueCapacity * 2;
+        CCNxContentObject **newQueue = malloc(newCapacity * sizeof(CCNxContentObject *));
+        if (newQueue == NULL) {
+            return false;
+        }
+        for (size_t i = 0; i < stream->queueCount; i++) {
+            newQueue[i] = stream->queue[(stream->queueHead + i) % stream->queueCapacity];
+        }
+        free(stream->queue);
+        stream->queue = newQueue;
+        stream->queueCapacity = newCapacity;
+        stream->queueHead = 0;
+    }
+
+    stream->queue[(stream->queueHead + stream->queueCount) % stream->queueCapacity] =
+        ccnxContentObject_Acquire(contentObject);
+    stream->queueCount++;
+    pthread_cond_signal(&stream->arrived);
+    return true;
+}
+
+/**
+ * Queue a ContentObject to every stream waiting for its name.
+ */
+static void
+_dispatch(CCNxVLCDispatcher *dispatcher, CCNxContentObject *contentObject)
+{
+    const CCNxName *name = ccnxContentObject_GetName(contentObject);
+    uint32_t hash = ccnxName_HashCode(name);
+    bool matched = false;
+
+    pthread_mutex_lock(&dispatcher->lock);
+
+    dispatcher->stats.contentObjectsReceived++;
+
+    _PendingEntry **link = &dispatcher->pending[_bucketIndex(hash)];
+    while (*link != NULL) {
+        _PendingEntry *entry = *link;
+        if (entry->hash == hash && ccnxName_Equals(entry->name, name)) {
+            if (_enqueue(entry->stream, contentObject)) {
+                dispatcher->stats.deliveries++;
+            }
+            matched = true;
+            _removePending(dispatcher, link);
+        } else {
+            link = &entry->next;
+        }
+    }
+    if (!matched) {
+        dispatcher->stats.unmatched++;
+    }
+
+    pthread_mutex_unlock(&dispatcher->lock);
+}
+
+/**
+ * Forget the names that have gone unanswered for too long. Must be called with the
+ * dispatcher's lock held.
+ */
+static void
+_sweepPending(CCNxVLCDispatcher *dispatcher, uint64_t nowUs)
+{
+    for (size_t i = 0; i < _PENDING_BUCKETS; i++) {
+        _PendingEntry **link = &dispatcher->pending[i];
+        while (*link != NULL) {
+            if (nowUs - (*link)->lastSentUs > _PENDING_LIFETIME_US) {
+                _removePending(dispatcher, link);
+            } else {
+                link = &(*link)->next;
+            }
+        }
+    }
+}
+
+/**
+ * Read every message available on the Portal and dispatch it.
+ *
+ * @return false if the Portal has failed.
+ */
+static bool
+_drainPortal(CCNxVLCDispatcher *dispatcher)
+{
+    while (true) {
+        pthread_mutex_lock(&dispatcher->portalLock);
+        CCNxMetaMessage *message = dispatcher->portalInterface->receive(dispatcher->portal, CCNxStackTimeout_Immediate);
+        bool eof = (message == NULL && dispatcher->portalInterface->isEOF(dispatcher->portal));
+        pthread_mutex_unlock(&dispatcher->portalLock);
+
+        if (message == NULL) {
+            return !eof;
+        }
+        if (ccnxMetaMessage_IsContentObject(message)) {
+            _dispatch(dispatcher, ccnxMetaMessage_GetContentObject(message));
+        }
+        ccnxMetaMessage_Release(&message);
+    }
+}
+
+/**
+ * Wait for the Portal to become readable, without holding the Portal, so that streams can
+ * send Interests in the meantime, and hand out what arrives.
+ */
+static void *
+_receiveThread(void *data)
+{
+    CCNxVLCDispatcher *dispatcher = data;
+    struct pollfd portalFd = { .fd = dispatcher->portalInterface->getFileId(dispatcher->portal), .events = POLLIN };
+    uint64_t lastSweepUs = ccnxVLCUtils_NowMicroseconds();
+    bool portalOk = true;
+
+    pthread_mutex_lock(&dispatcher->lock);
+    while (!dispatcher->closing && portalOk) {
+        pthread_mutex_unlock(&dispatcher->lock);
+
+        int ready = poll(&portalFd, 1, _POLL_INTERVAL_MS);
+        if (ready > 0) {
+            portalOk = _drainPortal(dispatcher) && (portalFd.revents & (POLLERR | POLLHUP | POLLNVAL)) == 0;
+        } else if (ready < 0 && errno != EINTR) {
+            portalOk = false;
+        }
+
+        pthread_mutex_lock(&dispatcher->lock);
+        uint64_t nowUs = ccnxVLCUtils_NowMicroseconds();
+        if (nowUs - lastSweepUs > _SWEEP_INTERVAL_US) {
+            _sweepPending(dispatcher, nowUs);
+            lastSweepUs = nowUs;
+        }
+    }
+
+    if (!portalOk) {
+        // Wake every stream, so that it sees the failure rather than waiting out its timeout.
+        dispatcher->failed = true;
+        for (CCNxVLCDispatcherStream *stream = dispatcher->streams; stream != NULL; stream = stream->next) {
+            pthread_cond_signal(&stream->arrived);
+        }
+    }
+    pthread_mutex_unlock(&dispatcher->lock);
+
+    return NULL;
+}
+
+static void
+_destroy(CCNxVLCDispatcher *dispatcher)
+{
+    pthread_mutex_lock(&dispatcher->lock);
+    dispatcher->closing = true;
+    pthread_mutex_unlock(&dispatcher->lock);
+    pthread_join(dispatcher->receiveThread, NULL);
+
+    // Every stream holds a reference, so all of them are gone and their names with them.
+    _sweepPending(dispatcher, UINT64_MAX);
+
+    pthread_mutex_destroy(&dispatcher->lock);
+    pthread_mutex_destroy(&dispatcher->portalLock);
+    dispatcher->portalInterface->release(&dispatcher->portal);
+    free(dispatcher);
+}
+
+CCNxVLCDispatcher *
+ccnxVLCDispatcher_Create(const CCNxVLCPortalInterface *portalInterface, void *portal)
+{
+    CCNxVLCDispatcher *result = calloc(1, sizeof(CCNxVLCDispatcher));
+    if (result == NULL) {
+        portalInterface->release(&portal);
+        return NULL;
+    }
+
+    result->portalInterface = portalInterface;
+    result->portal = portal;
+    result->references = 1;
+    pthread_mutex_init(&result->portalLock, NULL);
+    pthread_mutex_init(&result->lock, NULL);
+
+    if (pthread_create(&result->receiveThread, NULL, _receiveThread, result) != 0) {
+        pthread_mutex_destroy(&result->lock);
+        pthread_mutex_destroy(&result->portalLock);
+        portalInterface->release(&result->portal);
+        free(result);
+        return NULL;
+    }
+    return result;
+}
+
+CCNxVLCDispatcher *
+ccnxVLCDispatcher_AcquireShared(const CCNxPortalFactory *portalFactory)
+{
+    pthread_mutex_lock(&_sharedLock);
+
+    CCNxVLCDispatcher *result = _sharedDispatcher;
+    if (result != NULL) {
+        pthread_mutex_lock(&result->lock);
+        bool failed = result->failed;
+        pthread_mutex_unlock(&result->lock);
+
+        // A failed dispatcher is left to the streams still holding it.
+        if (failed) {
+            result = _sharedDispatcher = NULL;
+        }
+    }
+
+    if (result == NULL) {
+        CCNxPortal *portal = ccnxPortalFactory_CreatePortal(portalFactory, ccnxPortalRTA_Message);
+        if (portal != NULL) {
+            result = _sharedDispatcher = ccnxVLCDispatcher_Create(CCNxVLCPortalInterface_CCNxPortal, portal);
+        }
+    } else {
+        result->references++;
+    }
+
+    pthread_mutex_unlock(&_sharedLock);
+    return result;
+}
+
+void
+ccnxVLCDispatcher_Release(CCNxVLCDispatcher **dispatcherP)
+{
+    CCNxVLCDispatcher *dispatcher = *dispatcherP;
+
+    pthread_mutex_lock(&_sharedLock);
+    bool last = (--dispatcher->references == 0);
+    if (last && dispatcher == _sharedDispatcher) {
+        _sharedDispatcher = NULL;
+    }
+    pthread_mutex_unlock(&_sharedLock);
+
+    if (last) {
+        _destroy(dispatcher);
+    }
+
+    *dispatcherP = NULL;
+}
+
+void
+ccnxVLCDispatcher_GetStats(CCNxVLCDispatcher *dispatcher, CCNxVLCDispatcherStats *stats)
+{
+    pthread_mutex_lock(&dispatcher->lock);
+    *stats = dispatcher->stats;
+    pthread_mutex_unlock(&dispatcher->lock);
+}
+
+CCNxVLCDispatcherStream *
+ccnxVLCDispatcher_CreateStream(CCNxVLCDispatcher *dispatcher)
+{
+    CCNxVLCDispatcherStream *result = calloc(1, sizeof(CCNxVLCDispatcherStream));
+    if (result == NULL) {
+        return NULL;
+    }
+
+    // Receive() waits against the monotonic clock, like the rest of our timing.
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&result->arrived, &attributes);
+    pthread_condattr_destroy(&attributes);
+
+    pthread_mutex_lock(&_sharedLock);
+    dispatcher->references++;
+    pthread_mutex_unlock(&_sharedLock);
+    result->dispatcher = dispatcher;
+
+    pthread_mutex_lock(&dispatcher->lock);
+    result->next = dispatcher->streams;
+    dispatcher->streams = result;
+    dispatcher->stats.streams++;
+    pthread_mutex_unlock(&dispatcher->lock);
+
+    return result;
+}
+
+void
+ccnxVLCDispatcherStream_Release(CCNxVLCDispatcherStream **streamP)
+{
+    CCNxVLCDispatcherStream *stream = *streamP;
+    CCNxVLCDispatcher *dispatcher = stream->dispatcher;
+
+    pthread_mutex_lock(&dispatcher->lock);
+
+    CCNxVLCDispatcherStream **link = &dispatcher->streams;
+    while (*link != stream) {
+        link = &(*link)->next;
+    }
+    *link = stream->next;
+    dispatcher->stats.streams--;
+
+    for (size_t i = 0; i < _PENDING_BUCKETS; i++) {
+        _PendingEntry **entryLink = &dispatcher->pending[i];
+        while (*entryLink != NULL) {
+            if ((*entryLink)->stream == stream) {
+                _removePending(dispatcher, entryLink);
+            } else {
+                entryLink = &(*entryLink)->next;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&dispatcher->lock);
+
+    while (stream->queueCount > 0) {
+        ccnxContentObject_Release(&stream->queue[stream->queueHead]);
+        stream->queueHead = (stream->queueHead + 1) % stream->queueCapacity;
+        stream->queueCount--;
+    }
+    free(stream->queue);
+    pthread_cond_destroy(&stream->arrived);
+    free(stream);
+
+    ccnxVLCDispatcher_Release(&dispatcher);
+    *streamP = NULL;
+}
+
+bool
+ccnxVLCDispatcherStream_Send(CCNxVLCDispatcherStream *stream, const CCNxInterest *interest, uint64_t timeoutUs)
+{
+    CCNxVLCDispatcher *dispatcher = stream->dispatcher;
+    const CCNxName *name = ccnxInterest_GetName(interest);
+    uint32_t hash = ccnxName_HashCode(name);
+
+    // Register the name before sending, so that even the quickest answer finds it.
+    pthread_mutex_lock(&dispatcher->lock);
+
+    bool failed = dispatcher->failed;
+    _PendingEntry **link = &dispatcher->pending[_bucketIndex(hash)];
+    while (*link != NULL
+           && ((*link)->stream != stream || (*link)->hash != hash || !ccnxName_Equals((*link)->name, name))) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL && !failed) {
+        _PendingEntry *entry = calloc(1, sizeof(_PendingEntry));
+        if (entry != NULL) {
+            entry->name = ccnxName_Acquire(name);
+            entry->hash = hash;
+            entry->stream = stream;
+            *link = entry;
+            dispatcher->stats.pending++;
+        }
+    }
+    if (*link != NULL) {
+        (*link)->lastSentUs = ccnxVLCUtils_NowMicroseconds();
+    }
+
+    pthread_mutex_unlock(&dispatcher->lock);
+
+    if (failed) {
+        return false;
+    }
+
+    pthread_mutex_lock(&dispatcher->portalLock);
+    bool sent = dispatcher->portalInterface->send(dispatcher->portal, interest, CCNxStackTimeout_MicroSeconds(timeoutUs));
+    pthread_mutex_unlock(&dispatcher->portalLock);
+
+    if (sent) {
+        pthread_mutex_lock(&dispatcher->lock);
+        dispatcher->stats.interestsSent++;
+        pthread_mutex_unlock(&dispatcher->lock);
+    }
+    return sent;
+}
+
+CCNxContentObject *
+ccnxVLCDispatcherStream_Receive(CCNxVLCDispatcherStream *stream, uint64_t timeoutUs)
+{
+    CCNxVLCDispatcher *dispatcher = stream->dispatcher;
+    CCNxContentObject *result = NULL;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += (time_t) (timeoutUs / 1000000);
+    deadline.tv_nsec += (long) (timeoutUs % 1000000) * 1000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&dispatcher->lock);
+
+    while (stream->queueCount == 0 && !dispatcher->failed) {
+        if (pthread_cond_timedwait(&stream->arrived, &dispatcher->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (stream->queueCount > 0) {
+        result = stream->queue[stream->queueHead];
+        stream->queueHead = (stream->queueHead + 1) % stream->queueCapacity;
+        stream->queueCount--;
+    }
+
+    pthread_mutex_unlock(&dispatcher->lock);
+    return result;
+}
+
+bool
+ccnxVLCDispatcherStream_IsFailed(CCNxVLCDispatcherStream *stream)
+{
+    pthread_mutex_lock(&stream->dispatcher->lock);
+    bool result = stream->dispatcher->failed;
+    pthread_mutex_unlock(&stream->dispatcher->lock);
+    return result;
+}
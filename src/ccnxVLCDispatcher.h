@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCDispatcher_h
+#define ccnxVLCDispatcher_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <ccnx/api/ccnx_Portal/ccnx_Portal.h>
+#include <ccnx/common/ccnx_ContentObject.h>
+#include <ccnx/common/ccnx_Interest.h>
+
+#include "ccnxVLCPortal.h"
+
+struct ccnx_vlc_dispatcher;
+typedef struct ccnx_vlc_dispatcher CCNxVLCDispatcher;
+
+struct ccnx_vlc_dispatcher_stream;
+typedef struct ccnx_vlc_dispatcher_stream CCNxVLCDispatcherStream;
+
+/**
+ * Counters describing the use of a CCNxVLCDispatcher.
+ */
+typedef struct ccnx_vlc_dispatcher_stats {
+    unsigned streams;                // Streams currently attached
+    size_t   pending;                // Names some stream is waiting for
+    uint64_t interestsSent;          // Interests sent on behalf of all streams
+    uint64_t contentObjectsReceived; // ContentObjects read from the Portal
+    uint64_t deliveries;             // ContentObjects queued to a stream, one per stream waiting
+    uint64_t unmatched;              // ContentObjects no stream was waiting for
+} CCNxVLCDispatcherStats;
+
+/**
+ * Create a dispatcher of its own over `portal`, rather than the shared one, for example to
+ * run the fetch path against a mock producer. It takes ownership of `portal`.
+ *
+ * @param [in] portalInterface The operations of `portal`.
+ * @param [in] portal The instance to send Interests on and receive ContentObjects from.
+ *
+ * @return A new CCNxVLCDispatcher instance, or NULL if it could not be started, in which case
+ *         `portal` has been released. It must eventually be released by calling
+ *         ccnxVLCDispatcher_Release().
+ */
+CCNxVLCDispatcher *ccnxVLCDispatcher_Create(const CCNxVLCPortalInterface *portalInterface, void *portal);
+
+/**
+ * Return the dispatcher shared by the whole process, creating it on first use with a Portal
+ * from `portalFactory`. The dispatcher owns that single Portal and a thread that reads
+ * it, and hands each ContentObject to every stream that sent an Interest for its name, so
+ * that any number of streams can have Interests outstanding at once over one transport
+ * stack. If the shared dispatcher's Portal has failed, a new one replaces it.
+ *
+ * This function is thread-safe. Each call must be balanced by a call to
+ * ccnxVLCDispatcher_Release().
+ *
+ * @param [in] portalFactory The factory used to create the Portal, if one is needed.
+ *
+ * @return A new reference to the shared CCNxVLCDispatcher, or NULL if it could not be started.
+ */
+CCNxVLCDispatcher *ccnxVLCDispatcher_AcquireShared(const CCNxPortalFactory *portalFactory);
+
+/**
+ * Release a reference to the dispatcher. The last release, once every stream is released
+ * too, stops its thread and releases its Portal.
+ *
+ * @param [in,out] dispatcherP A pointer to the dispatcher to release. It is set to NULL.
+ */
+void ccnxVLCDispatcher_Release(CCNxVLCDispatcher **dispatcherP);
+
+/**
+ * Copy the dispatcher's counters into `stats`.
+ *
+ * @param [in] dispatcher The dispatcher.
+ * @param [out] stats The structure to fill in.
+ */
+void ccnxVLCDispatcher_GetStats(CCNxVLCDispatcher *dispatcher, CCNxVLCDispatcherStats *stats);
+
+/**
+ * Attach a new stream to the dispatcher: a queue of the ContentObjects answering the
+ * Interests sent through it. The stream holds a reference to the dispatcher. It may be used
+ * by one thread at a time, and must eventually be released by calling
+ * ccnxVLCDispatcherStream_Release().
+ *
+ * @param [in] dispatcher The dispatcher.
+ *
+ * @return A new CCNxVLCDispatcherStream instance, or NULL if memory could not be allocated.
+ */
+CCNxVLCDispatcherStream *ccnxVLCDispatcher_CreateStream(CCNxVLCDispatcher *dispatcher);
+
+/**
+ * Detach the stream, dropping the ContentObjects queued for it and forgetting the names it
+ * was waiting for.
+ *
+ * @param [in,out] streamP A pointer to the stream to release. It is set to NULL.
+ */
+void ccnxVLCDispatcherStream_Release(CCNxVLCDispatcherStream **streamP);
+
+/**
+ * Send an Interest on the shared Portal, and have the ContentObject answering it queued to
+ * this stream.
+ *
+ * @param [in] stream The stream.
+ * @param [in] interest The Interest to send.
+ * @param [in] timeoutUs The longest to wait for the Portal to accept the Interest.
+ *
+ * @return true if the Interest was sent, false if the Portal failed or timed out.
+ */
+bool ccnxVLCDispatcherStream_Send(CCNxVLCDispatcherStream *stream, const CCNxInterest *interest, uint64_t timeoutUs);
+
+/**
+ * Take the next ContentObject queued to this stream, waiting up to `timeoutUs` for one.
+ *
+ * @param [in] stream The stream.
+ * @param [in] timeoutUs The longest to wait, in microseconds.
+ *
+ * @return A ContentObject, which the caller must release by calling ccnxContentObject_Release(),
+ *         or NULL if none arrived in time or the Portal has failed.
+ */
+CCNxContentObject *ccnxVLCDispatcherStream_Receive(CCNxVLCDispatcherStream *stream, uint64_t timeoutUs);
+
+/**
+ * Return whether the shared Portal has failed, after which nothing more will arrive.
+ *
+ * @param [in] stream The stream.
+ *
+ * @return true if the Portal has failed.
+ */
+bool ccnxVLCDispatcherStream_IsFailed(CCNxVLCDispatcherStream *stream);
+
+#endif // ccnxVLCDispatcher_h
@@ -0,0 +1,597 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCFetcher.h"
+#include "ccnxVLCUtils.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include <ccnx/common/ccnx_Name.h>
+
+// A pending chunk overtaken by this many later chunks is treated as lost by the congestion
+// controller, in the same way TCP treats three duplicate ACKs.
+#define _GAP_THRESHOLD 3
+
+// The longest we let the Portal take to accept an Interest before giving up on it.
+#define _SEND_TIMEOUT_US 1000000
+
+typedef enum {
+    _CCNxVLCFetcherSlot_Empty,     // Nothing requested for this slot
+    _CCNxVLCFetcherSlot_Pending,   // An Interest is outstanding for `chunkNumber`
+    _CCNxVLCFetcherSlot_Received,  // `contentObject` holds the data for `chunkNumber`
+    _CCNxVLCFetcherSlot_Failed     // `chunkNumber` timed out more than the retry limit allows
+} _CCNxVLCFetcherSlotState;
+
+typedef struct {
+    _CCNxVLCFetcherSlotState state;
+    uint64_t chunkNumber;
+    CCNxContentObject *contentObject;
+    uint64_t sendTimeUs;           // When the Interest for `chunkNumber` was sent
+    unsigned overtakenCount;       // How many later chunks arrived while this one was pending
+    unsigned retries;              // How many times the Interest has been retransmitted
+    size_t prefix;                 // The prefix the latest Interest was sent to
+} _CCNxVLCFetcherSlot;
+
+struct ccnx_vlc_fetcher {
+    CCNxVLCDispatcherStream *stream;
+    CCNxVLCFetcherInterestFactory *interestFactory;
+    void *context;
+
+    // The window covers chunks [windowStart, windowStart + windowSize). The slot for a chunk
+    // is at index (chunkNumber % windowSize), so every chunk in the window has its own slot.
+    size_t windowSize;
+    uint64_t windowStart;
+    _CCNxVLCFetcherSlot *slots;
+
+    // While ccnxVLCFetcher_GetChunkSet() runs, the chunks it is fetching. NULL otherwise.
+    _CCNxVLCFetcherSlot *setSlots;
+    size_t setCount;
+
+    CCNxVLCCongestion *congestion;
+    CCNxVLCFetcherStats stats;
+    CCNxVLCHistogram *rttHistogram;    // Where valid RTT samples are recorded, or NULL
+    CCNxVLCTraceBuffer *trace;         // Where chunk lifetimes are recorded, or NULL
+    CCNxVLCPrefixSelector *prefixSelector; // Chooses the prefix of each Interest, or NULL to always use prefix 0
+    unsigned maxRetries;
+
+    bool finalChunkKnown;
+    uint64_t finalChunkNumber;
+};
+
+static _CCNxVLCFetcherSlot *
+_slotForChunk(CCNxVLCFetcher *fetcher, uint64_t chunkNumber)
+{
+    return &fetcher->slots[chunkNumber % fetcher->windowSize];
+}
+
+static bool
+_isInWindow(const CCNxVLCFetcher *fetcher, uint64_t chunkNumber)
+{
+    return chunkNumber >= fetcher->windowStart && chunkNumber - fetcher->windowStart < fetcher->windowSize;
+}
+
+/**
+ * Return the slot waiting for `chunkNumber`, or NULL if we aren't waiting for it.
+ */
+static _CCNxVLCFetcherSlot *
+_pendingSlotForChunk(CCNxVLCFetcher *fetcher, uint64_t chunkNumber)
+{
+    if (fetcher->setSlots != NULL) {
+        for (size_t i = 0; i < fetcher->setCount; i++) {
+            _CCNxVLCFetcherSlot *slot = &fetcher->setSlots[i];
+            if (slot->state == _CCNxVLCFetcherSlot_Pending && slot->chunkNumber == chunkNumber) {
+                return slot;
+            }
+        }
+        return NULL;
+    }
+
+    _CCNxVLCFetcherSlot *slot = _slotForChunk(fetcher, chunkNumber);
+    if (_isInWindow(fetcher, chunkNumber)
+        && slot->state == _CCNxVLCFetcherSlot_Pending && slot->chunkNumber == chunkNumber) {
+        return slot;
+    }
+    return NULL;
+}
+
+static void
+_clearSlot(CCNxVLCFetcher *fetcher, _CCNxVLCFetcherSlot *slot)
+{
+    if (slot->state == _CCNxVLCFetcherSlot_Pending) {
+        fetcher->stats.outstanding--;
+        ccnxVLCTraceBuffer_MarkChunk(fetcher->trace, "abandoned", slot->chunkNumber);
+        ccnxVLCTraceBuffer_EndChunk(fetcher->trace, "interest", slot->chunkNumber);
+    }
+    if (slot->contentObject != NULL) {
+        ccnxContentObject_Release(&slot->contentObject);
+    }
+    slot->state = _CCNxVLCFetcherSlot_Empty;
+}
+
+/**
+ * Move the window so that it starts at `chunkNumber`, discarding any slot whose chunk is no
+ * longer covered. A pending Interest that is discarded here is simply forgotten; its
+ * ContentObject will be dropped on arrival.
+ */
+static void
+_moveWindow(CCNxVLCFetcher *fetcher, uint64_t chunkNumber)
+{
+    fetcher->windowStart = chunkNumber;
+
+    for (size_t i = 0; i < fetcher->windowSize; i++) {
+        _CCNxVLCFetcherSlot *slot = &fetcher->slots[i];
+        if (slot->state != _CCNxVLCFetcherSlot_Empty && !_isInWindow(fetcher, slot->chunkNumber)) {
+            _clearSlot(fetcher, slot);
+        }
+    }
+}
+
+/**
+ * Give up on the chunk in `slot`: ccnxVLCFetcher_GetChunk() reports it as failed.
+ */
+static void
+_failSlot(CCNxVLCFetcher *fetcher, _CCNxVLCFetcherSlot *slot)
+{
+    fetcher->stats.failures++;
+    ccnxVLCTraceBuffer_MarkChunk(fetcher->trace, "failed", slot->chunkNumber);
+    if (slot->state == _CCNxVLCFetcherSlot_Pending) {
+        fetcher->stats.outstanding--;
+        ccnxVLCTraceBuffer_EndChunk(fetcher->trace, "interest", slot->chunkNumber);
+    }
+    slot->state = _CCNxVLCFetcherSlot_Failed;
+}
+
+/**
+ * Send the Interest for the chunk in `slot`, with a lifetime matching our retransmission
+ * timeout so the forwarder does not hold on to it long after we have given up.
+ * If no Interest can be made for the chunk, the slot fails; only a failure of the
+ * portal returns false.
+ */
+static bool
+_sendInterest(CCNxVLCFetcher *fetcher, _CCNxVLCFetcherSlot *slot)
+{
+    slot->prefix = (fetcher->prefixSelector != NULL)
+                   ? ccnxVLCPrefixSelector_Choose(fetcher->prefixSelector, ccnxVLCUtils_NowMicroseconds())
+                   : 0;
+
+    CCNxInterest *interest = fetcher->interestFactory(fetcher->context, slot->prefix, slot->chunkNumber);
+    if (interest == NULL) {
+        _failSlot(fetcher, slot);
+        return true;
+    }
+    ccnxInterest_SetLifetime(interest, (uint32_t) (ccnxVLCCongestion_GetRto(fetcher->congestion) / 1000));
+
+    bool sent = ccnxVLCDispatcherStream_Send(fetcher->stream, interest, _SEND_TIMEOUT_US);
+    ccnxInterest_Release(&interest);
+
+    if (sent) {
+        slot->sendTimeUs = ccnxVLCUtils_NowMicroseconds();
+        fetcher->stats.interestsSent++;
+    }
+    return sent;
+}
+
+/**
+ * Retransmit every pending Interest in `slots` that has been outstanding for longer than the
+ * retransmission timeout, or mark its chunk as failed once it has used up its retries.
+ */
+static bool
+_retransmitExpired(CCNxVLCFetcher *fetcher, _CCNxVLCFetcherSlot *slots, size_t slotCount, uint64_t nowUs)
+{
+    uint64_t rtoUs = ccnxVLCCongestion_GetRto(fetcher->congestion);
+    bool timedOut = false;
+
+    for (size_t i = 0; i < slotCount; i++) {
+        _CCNxVLCFetcherSlot *slot = &slots[i];
+        if (slot->state != _CCNxVLCFetcherSlot_Pending || nowUs - slot->sendTimeUs < rtoUs) {
+            continue;
+        }
+
+        timedOut = true;
+        if (fetcher->prefixSelector != NULL) {
+            ccnxVLCPrefixSelector_OnTimeout(fetcher->prefixSelector, slot->prefix, nowUs);
+        }
+        if (slot->retries >= fetcher->maxRetries) {
+            _failSlot(fetcher, slot);
+            continue;
+        }
+
+        slot->retries++;
+        slot->overtakenCount = 0;
+        if (!_sendInterest(fetcher, slot)) {
+            return false;
+        }
+        if (slot->state == _CCNxVLCFetcherSlot_Failed) {
+            continue;
+        }
+        fetcher->stats.retransmissions++;
+        ccnxVLCTraceBuffer_MarkChunk(fetcher->trace, "retransmit", slot->chunkNumber);
+    }
+
+    if (timedOut) {
+        ccnxVLCCongestion_OnTimeout(fetcher->congestion, nowUs);
+    }
+    return true;
+}
+
+/**
+ * Return how long we may wait for a message before the oldest pending Interest in `slots` expires.
+ */
+static uint64_t
+_timeUntilNextExpiry(const CCNxVLCFetcher *fetcher, const _CCNxVLCFetcherSlot *slots, size_t slotCount,
+                     uint64_t nowUs, uint64_t limitUs)
+{
+    uint64_t rtoUs = ccnxVLCCongestion_GetRto(fetcher->congestion);
+    uint64_t result = limitUs;
+
+    for (size_t i = 0; i < slotCount; i++) {
+        const _CCNxVLCFetcherSlot *slot = &slots[i];
+        if (slot->state == _CCNxVLCFetcherSlot_Pending) {
+            uint64_t expiryUs = slot->sendTimeUs + rtoUs;
+            uint64_t remainingUs = (expiryUs > nowUs) ? expiryUs - nowUs : 0;
+            if (remainingUs < result) {
+                result = remainingUs;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * Send the first Interest for `chunkNumber` from `slot`.
+ */
+static bool
+_requestChunk(CCNxVLCFetcher *fetcher, _CCNxVLCFetcherSlot *slot, uint64_t chunkNumber)
+{
+    slot->chunkNumber = chunkNumber;
+    slot->overtakenCount = 0;
+    slot->retries = 0;
+    if (!_sendInterest(fetcher, slot)) {
+        return false;
+    }
+    if (slot->state == _CCNxVLCFetcherSlot_Failed) {
+        return true;
+    }
+
+    slot->state = _CCNxVLCFetcherSlot_Pending;
+    fetcher->stats.outstanding++;
+    ccnxVLCTraceBuffer_BeginChunk(fetcher->trace, "interest", chunkNumber);
+    return true;
+}
+
+/**
+ * Issue Interests, in chunk order, for chunks in the window that are neither outstanding nor
+ * received, until the congestion window is full.
+ */
+static bool
+_fillWindow(CCNxVLCFetcher *fetcher)
+{
+    size_t congestionWindow = ccnxVLCCongestion_GetWindow(fetcher->congestion);
+
+    for (size_t i = 0; i < fetcher->windowSize && fetcher->stats.outstanding < congestionWindow; i++) {
+        uint64_t chunkNumber = fetcher->windowStart + i;
+        if (fetcher->finalChunkKnown && chunkNumber > fetcher->finalChunkNumber) {
+            break;
+        }
+
+        _CCNxVLCFetcherSlot *slot = _slotForChunk(fetcher, chunkNumber);
+        if (slot->state != _CCNxVLCFetcherSlot_Empty) {
+            continue;
+        }
+
+        if (!_requestChunk(fetcher, slot, chunkNumber)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Count the arrival of `arrivedSlot` against every older pending chunk it overtook, and tell
+ * the congestion controller about any chunk that has now been overtaken too often.
+ * Only used for the window: the chunks of a set are not requested in order.
+ */
+static void
+_detectGaps(CCNxVLCFetcher *fetcher, const _CCNxVLCFetcherSlot *arrivedSlot, uint64_t nowUs)
+{
+    for (size_t i = 0; i < fetcher->windowSize; i++) {
+        _CCNxVLCFetcherSlot *slot = &fetcher->slots[i];
+        if (slot->state == _CCNxVLCFetcherSlot_Pending
+            && slot->chunkNumber < arrivedSlot->chunkNumber
+            && slot->sendTimeUs <= arrivedSlot->sendTimeUs) {
+            if (++slot->overtakenCount == _GAP_THRESHOLD) {
+                ccnxVLCCongestion_OnGap(fetcher->congestion, nowUs);
+            }
+        }
+    }
+}
+
+/**
+ * Wait up to `timeoutUs` for one message from the Portal and, if it is a ContentObject for a
+ * chunk we are waiting on, store it in that chunk's slot.
+ */
+static CCNxVLCFetcherResult
+_receive(CCNxVLCFetcher *fetcher, uint64_t timeoutUs)
+{
+    CCNxContentObject *contentObject = ccnxVLCDispatcherStream_Receive(fetcher->stream, timeoutUs);
+    if (contentObject == NULL) {
+        return ccnxVLCDispatcherStream_IsFailed(fetcher->stream) ? CCNxVLCFetcherResult_Error : CCNxVLCFetcherResult_Timeout;
+    }
+
+    uint64_t chunkNumber = ccnxVLCUtils_GetChunkNumberFromName(ccnxContentObject_GetName(contentObject));
+
+    if (ccnxContentObject_HasFinalChunkNumber(contentObject)) {
+        fetcher->finalChunkKnown = true;
+        fetcher->finalChunkNumber = ccnxContentObject_GetFinalChunkNumber(contentObject);
+    }
+
+    _CCNxVLCFetcherSlot *slot = _pendingSlotForChunk(fetcher, chunkNumber);
+    if (slot != NULL) {
+        uint64_t nowUs = ccnxVLCUtils_NowMicroseconds();
+
+        slot->contentObject = contentObject;
+        slot->state = _CCNxVLCFetcherSlot_Received;
+        fetcher->stats.outstanding--;
+        fetcher->stats.contentObjectsReceived++;
+        ccnxVLCTraceBuffer_EndChunk(fetcher->trace, "interest", chunkNumber);
+
+        // Karn's algorithm: after a retransmission we can't tell which Interest was
+        // answered, so the RTT is not a valid sample.
+        uint64_t rttUs = (slot->retries == 0) ? nowUs - slot->sendTimeUs : 0;
+        ccnxVLCCongestion_OnContent(fetcher->congestion, rttUs);
+        if (fetcher->rttHistogram != NULL && slot->retries == 0) {
+            ccnxVLCHistogram_Record(fetcher->rttHistogram, rttUs);
+        }
+        if (fetcher->prefixSelector != NULL) {
+            // After a retransmission the answer may have come from an earlier prefix, but
+            // crediting the latest one is what lets a prefix that is down come back up.
+            ccnxVLCPrefixSelector_OnContent(fetcher->prefixSelector, slot->prefix, rttUs);
+        }
+        if (fetcher->setSlots == NULL) {
+            _detectGaps(fetcher, slot, nowUs);
+        }
+        return CCNxVLCFetcherResult_Success;
+    }
+    // A duplicate, or a chunk we stopped waiting for when the window moved.
+    fetcher->stats.contentObjectsDiscarded++;
+    ccnxContentObject_Release(&contentObject);
+    return CCNxVLCFetcherResult_Success;
+}
+
+CCNxVLCFetcher *
+ccnxVLCFetcher_Create(CCNxVLCDispatcherStream *stream, size_t windowSize, CCNxVLCCongestionMode congestionMode,
+                      unsigned maxRetries, CCNxVLCFetcherInterestFactory *interestFactory, void *context)
+{
+    CCNxVLCFetcher *result = calloc(1, sizeof(CCNxVLCFetcher));
+    if (result != NULL) {
+        size_t initialWindow = windowSize < 2 ? windowSize : 2;
+
+        result->slots = calloc(windowSize, sizeof(_CCNxVLCFetcherSlot));
+        result->congestion = ccnxVLCCongestion_Create(congestionMode, initialWindow, windowSize);
+        if (result->slots == NULL || result->congestion == NULL) {
+            if (result->congestion != NULL) {
+                ccnxVLCCongestion_Release(&result->congestion);
+            }
+            free(result->slots);
+            free(result);
+            return NULL;
+        }
+        result->stream = stream;
+        result->interestFactory = interestFactory;
+        result->context = context;
+        result->windowSize = windowSize;
+        result->maxRetries = maxRetries;
+    }
+    return result;
+}
+
+void
+ccnxVLCFetcher_Release(CCNxVLCFetcher **fetcherP)
+{
+    CCNxVLCFetcher *fetcher = *fetcherP;
+
+    for (size_t i = 0; i < fetcher->windowSize; i++) {
+        _clearSlot(fetcher, &fetcher->slots[i]);
+    }
+    ccnxVLCCongestion_Release(&fetcher->congestion);
+    free(fetcher->slots);
+    free(fetcher);
+
+    *fetcherP = NULL;
+}
+
+CCNxVLCFetcherResult
+ccnxVLCFetcher_GetChunk(CCNxVLCFetcher *fetcher, uint64_t chunkNumber, uint64_t timeoutUs,
+                        CCNxContentObject **contentObjectP)
+{
+    if (fetcher->finalChunkKnown && chunkNumber > fetcher->finalChunkNumber) {
+        return CCNxVLCFetcherResult_EndOfContent;
+    }
+
+    if (chunkNumber != fetcher->windowStart) {
+        _moveWindow(fetcher, chunkNumber);
+    }
+
+    uint64_t deadlineUs = ccnxVLCUtils_NowMicroseconds() + timeoutUs;
+
+    // Every arrival frees room in the congestion window (and may grow it), so top the
+    // window up after each message while we wait.
+    _CCNxVLCFetcherSlot *slot = _slotForChunk(fetcher, chunkNumber);
+    while (true) {
+        uint64_t nowUs = ccnxVLCUtils_NowMicroseconds();
+        if (!_retransmitExpired(fetcher, fetcher->slots, fetcher->windowSize, nowUs) || !_fillWindow(fetcher)) {
+            return CCNxVLCFetcherResult_Error;
+        }
+        if (slot->state == _CCNxVLCFetcherSlot_Received) {
+            break;
+        }
+        if (slot->state == _CCNxVLCFetcherSlot_Failed && slot->chunkNumber == chunkNumber) {
+            // Forget the failure, so that asking for this chunk again starts afresh.
+            _clearSlot(fetcher, slot);
+            return CCNxVLCFetcherResult_Failed;
+        }
+        if (fetcher->finalChunkKnown && chunkNumber > fetcher->finalChunkNumber) {
+            return CCNxVLCFetcherResult_EndOfContent;
+        }
+
+        if (nowUs >= deadlineUs) {
+            return CCNxVLCFetcherResult_Timeout;
+        }
+
+        uint64_t waitUs = _timeUntilNextExpiry(fetcher, fetcher->slots, fetcher->windowSize, nowUs, deadlineUs - nowUs);
+        CCNxVLCFetcherResult result = _receive(fetcher, waitUs);
+        if (result == CCNxVLCFetcherResult_Error) {
+            return result;
+        }
+    }
+
+    *contentObjectP = slot->contentObject;
+    slot->contentObject = NULL;
+    slot->state = _CCNxVLCFetcherSlot_Empty;
+
+    // The consumer reads sequentially, so the window slides along behind it.
+    fetcher->windowStart = chunkNumber + 1;
+
+    return CCNxVLCFetcherResult_Success;
+}
+
+size_t
+ccnxVLCFetcher_GetChunkSet(CCNxVLCFetcher *fetcher, size_t count, const uint64_t chunkNumbers[],
+                           CCNxContentObject *contentObjects[])
+{
+    for (size_t i = 0; i < count; i++) {
+        contentObjects[i] = NULL;
+    }
+
+    _CCNxVLCFetcherSlot *slots = calloc(count, sizeof(_CCNxVLCFetcherSlot));
+    if (slots == NULL) {
+        return 0;
+    }
+
+    // Abandon the window. The next ccnxVLCFetcher_GetChunk() refills it.
+    for (size_t i = 0; i < fetcher->windowSize; i++) {
+        _clearSlot(fetcher, &fetcher->slots[i]);
+    }
+    fetcher->setSlots = slots;
+    fetcher->setCount = count;
+
+    bool portalFailed = false;
+    for (size_t i = 0; i < count && !portalFailed; i++) {
+        if (fetcher->finalChunkKnown && chunkNumbers[i] > fetcher->finalChunkNumber) {
+            continue;
+        }
+        portalFailed = !_requestChunk(fetcher, &slots[i], chunkNumbers[i]);
+    }
+
+    while (!portalFailed) {
+        uint64_t nowUs = ccnxVLCUtils_NowMicroseconds();
+        if (!_retransmitExpired(fetcher, slots, count, nowUs)) {
+            break;
+        }
+
+        bool waiting = false;
+        for (size_t i = 0; i < count && !waiting; i++) {
+            waiting = (slots[i].state == _CCNxVLCFetcherSlot_Pending);
+        }
+        if (!waiting) {
+            break;
+        }
+
+        uint64_t waitUs = _timeUntilNextExpiry(fetcher, slots, count, nowUs, ccnxVLCCongestion_GetRto(fetcher->congestion));
+        portalFailed = (_receive(fetcher, waitUs) == CCNxVLCFetcherResult_Error);
+    }
+
+    size_t result = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (slots[i].state == _CCNxVLCFetcherSlot_Received) {
+            contentObjects[i] = slots[i].contentObject;
+            slots[i].contentObject = NULL;
+            result++;
+        }
+        _clearSlot(fetcher, &slots[i]);
+    }
+
+    fetcher->setSlots = NULL;
+    fetcher->setCount = 0;
+    free(slots);
+
+    return result;
+}
+
+void
+ccnxVLCFetcher_GetStats(const CCNxVLCFetcher *fetcher, CCNxVLCFetcherStats *stats)
+{
+    *stats = fetcher->stats;
+    ccnxVLCCongestion_GetStats(fetcher->congestion, &stats->congestion);
+}
+
+void
+ccnxVLCFetcher_SetRttHistogram(CCNxVLCFetcher *fetcher, CCNxVLCHistogram *histogram)
+{
+    fetcher->rttHistogram = histogram;
+}
+
+void
+ccnxVLCFetcher_SetTraceBuffer(CCNxVLCFetcher *fetcher, CCNxVLCTraceBuffer *buffer)
+{
+    fetcher->trace = buffer;
+}
+
+void
+ccnxVLCFetcher_SetPrefixSelector(CCNxVLCFetcher *fetcher, CCNxVLCPrefixSelector *selector)
+{
+    fetcher->prefixSelector = selector;
+}
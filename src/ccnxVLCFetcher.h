@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCFetcher_h
+#define ccnxVLCFetcher_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <ccnx/common/ccnx_Interest.h>
+#include <ccnx/common/ccnx_ContentObject.h>
+
+#include "ccnxVLCCongestion.h"
+#include "ccnxVLCDispatcher.h"
+#include "ccnxVLCHistogram.h"
+#include "ccnxVLCPrefixSelector.h"
+#include "ccnxVLCTrace.h"
+
+struct ccnx_vlc_fetcher;
+typedef struct ccnx_vlc_fetcher CCNxVLCFetcher;
+
+/**
+ * The outcome of ccnxVLCFetcher_GetChunk().
+ */
+typedef enum {
+    CCNxVLCFetcherResult_Success,       // The ContentObject was returned
+    CCNxVLCFetcherResult_Timeout,       // The chunk did not arrive in time; call again to keep waiting
+    CCNxVLCFetcherResult_EndOfContent,  // The chunk is past the final chunk of the content
+    CCNxVLCFetcherResult_Failed,        // The chunk's Interest timed out more than the retry limit allows
+    CCNxVLCFetcherResult_Error          // The Portal failed
+} CCNxVLCFetcherResult;
+
+/**
+ * Counters describing the work done by a fetcher, plus the state of its congestion controller.
+ */
+typedef struct ccnx_vlc_fetcher_stats {
+    uint64_t interestsSent;            // Interests written to the Portal
+    uint64_t contentObjectsReceived;   // ContentObjects stored for a chunk we were waiting on
+    uint64_t contentObjectsDiscarded;  // Duplicate or no-longer-wanted ContentObjects
+    uint64_t retransmissions;          // Interests re-sent after the retransmission timeout
+    uint64_t failures;                 // Chunks given up on after the retry limit
+    size_t   outstanding;              // Interests currently in flight
+    CCNxVLCCongestionStats congestion;
+} CCNxVLCFetcherStats;
+
+/**
+ * A function that creates the CCNxInterest used to retrieve the given chunk. The returned
+ * instance is released by the fetcher once it has been sent.
+ *
+ * @param [in] context The context pointer supplied to ccnxVLCFetcher_Create().
+ * @param [in] prefix The prefix to name the chunk under, as chosen by the fetcher's prefix
+ *                    selector; always 0 without one.
+ * @param [in] chunkNumber The number of the chunk to be retrieved.
+ *
+ * @return A new CCNxInterest for the specified chunk, or NULL if none can be made, in which
+ *         case the chunk fails as if it had used up its retries.
+ */
+typedef CCNxInterest *(CCNxVLCFetcherInterestFactory)(void *context, size_t prefix, uint64_t chunkNumber);
+
+/**
+ * Create a fetcher that requests the chunks following the one most recently asked for.
+ * The window covers `windowSize` chunks; within it, the number of Interests in flight is
+ * limited by a congestion controller running the given algorithm. ContentObjects are held,
+ * by chunk number, until they are requested in order. An Interest that is not answered within
+ * the retransmission timeout is re-sent, up to `maxRetries` times. The returned instance must
+ * eventually be released by calling ccnxVLCFetcher_Release().
+ *
+ * @param [in] stream The dispatcher stream used to send Interests and receive ContentObjects.
+ * @param [in] windowSize The number of chunks covered by the window, which is also the largest
+ *                        congestion window. Must be > 0.
+ * @param [in] congestionMode The congestion control algorithm that sizes the Interest window.
+ * @param [in] maxRetries How many times an Interest is retransmitted before its chunk fails.
+ * @param [in] interestFactory The function used to create the Interest for a chunk.
+ * @param [in] context A pointer passed back to `interestFactory`.
+ *
+ * @return A new CCNxVLCFetcher instance, or NULL if memory could not be allocated.
+ */
+CCNxVLCFetcher *ccnxVLCFetcher_Create(CCNxVLCDispatcherStream *stream, size_t windowSize, CCNxVLCCongestionMode congestionMode,
+                                      unsigned maxRetries, CCNxVLCFetcherInterestFactory *interestFactory, void *context);
+
+/**
+ * Release the fetcher and every ContentObject it still holds. The stream is not released.
+ *
+ * @param [in,out] fetcherP A pointer to the fetcher to release. It is set to NULL.
+ */
+void ccnxVLCFetcher_Release(CCNxVLCFetcher **fetcherP);
+
+/**
+ * Retrieve the ContentObject for the specified chunk, waiting up to `timeoutUs` for it to
+ * arrive. Before waiting, the window is moved so that it starts at `chunkNumber` and Interests
+ * are issued for chunks in the window that are not already outstanding. Chunks that fall
+ * outside the new window are discarded. After a timeout the window is left as it is, so
+ * calling again for the same chunk simply continues to wait.
+ *
+ * On success the caller owns the returned ContentObject and must release it by calling
+ * ccnxContentObject_Release().
+ *
+ * @param [in] fetcher The fetcher instance.
+ * @param [in] chunkNumber The number of the desired chunk.
+ * @param [in] timeoutUs The longest time to wait, in microseconds.
+ * @param [out] contentObjectP Set to the ContentObject for `chunkNumber` on success.
+ *
+ * @return CCNxVLCFetcherResult_Success if `*contentObjectP` was set, otherwise the reason it was not.
+ */
+CCNxVLCFetcherResult ccnxVLCFetcher_GetChunk(CCNxVLCFetcher *fetcher, uint64_t chunkNumber, uint64_t timeoutUs,
+                                             CCNxContentObject **contentObjectP);
+
+/**
+ * Retrieve a set of chunks that need not be consecutive, such as the first and last chunks of
+ * a file, with all of their Interests outstanding at once. Each is retransmitted on timeout
+ * like a chunk in the window, and the call returns once every chunk has arrived or failed.
+ * Chunks beyond the final chunk, if known, are not requested.
+ *
+ * Any Interests outstanding in the window are abandoned first. The window is refilled by the
+ * next call to ccnxVLCFetcher_GetChunk().
+ *
+ * The caller owns the returned ContentObjects and must release them by calling
+ * ccnxContentObject_Release().
+ *
+ * @param [in] fetcher The fetcher instance.
+ * @param [in] count The number of chunks in `chunkNumbers`.
+ * @param [in] chunkNumbers The numbers of the desired chunks. They must be distinct.
+ * @param [out] contentObjects Set to the ContentObject for each chunk of `chunkNumbers`,
+ *                             or to NULL for a chunk that could not be retrieved.
+ *
+ * @return The number of chunks retrieved.
+ */
+size_t ccnxVLCFetcher_GetChunkSet(CCNxVLCFetcher *fetcher, size_t count, const uint64_t chunkNumbers[],
+                                  CCNxContentObject *contentObjects[]);
+
+/**
+ * Copy the fetcher's counters and congestion control state into `stats`.
+ *
+ * @param [in] fetcher The fetcher instance.
+ * @param [out] stats The structure to fill in.
+ */
+void ccnxVLCFetcher_GetStats(const CCNxVLCFetcher *fetcher, CCNxVLCFetcherStats *stats);
+
+/**
+ * Record the RTT of every Interest answered from now on in `histogram`, in microseconds.
+ * As for congestion control, Interests that were retransmitted are left out, since we can't
+ * tell which transmission was answered.
+ *
+ * @param [in] fetcher The fetcher instance.
+ * @param [in] histogram The histogram to record into, or NULL to stop recording. It is not
+ *                       released with the fetcher, so must outlive it.
+ */
+void ccnxVLCFetcher_SetRttHistogram(CCNxVLCFetcher *fetcher, CCNxVLCHistogram *histogram);
+
+/**
+ * Record the lifetime of every chunk's Interest from now on in `buffer`: a span from the
+ * first transmission to the arrival of the ContentObject, marked at each retransmission, or
+ * ended early when the chunk fails or is abandoned. Only the thread using the fetcher may
+ * record into `buffer`.
+ *
+ * @param [in] fetcher The fetcher instance.
+ * @param [in] buffer The trace buffer to record into, or NULL to stop recording. It is owned
+ *                    by its trace, which must outlive the fetcher.
+ */
+void ccnxVLCFetcher_SetTraceBuffer(CCNxVLCFetcher *fetcher, CCNxVLCTraceBuffer *buffer);
+
+/**
+ * Have `selector` choose the prefix of every Interest sent from now on, each retransmission
+ * included, and tell it which were answered and which timed out. Since ContentObjects are
+ * matched to chunks by chunk number alone, a chunk may be answered under any prefix.
+ *
+ * @param [in] fetcher The fetcher instance.
+ * @param [in] selector The prefix selector, or NULL to send every Interest to prefix 0. It is
+ *                      not released with the fetcher, so must outlive it.
+ */
+void ccnxVLCFetcher_SetPrefixSelector(CCNxVLCFetcher *fetcher, CCNxVLCPrefixSelector *selector);
+
+#endif // ccnxVLCFetcher_h
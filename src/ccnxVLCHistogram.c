@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCHistogram.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+// Values below _EXACT_LIMIT each have their own bucket. Above it, each power of two is split
+// into _SUB_BUCKETS buckets of equal width.
+#define _SUB_BUCKET_BITS 3
+#define _SUB_BUCKETS (1 << _SUB_BUCKET_BITS)
+#define _EXACT_LIMIT (2 * _SUB_BUCKETS)
+#define _BUCKET_COUNT (_EXACT_LIMIT + (64 - _SUB_BUCKET_BITS - 1) * _SUB_BUCKETS)
+
+struct ccnx_vlc_histogram {
+    atomic_uint_least64_t buckets[_BUCKET_COUNT];
+    atomic_uint_least64_t sum;
+    atomic_uint_least64_t min;
+    atomic_uint_least64_t max;
+};
+
+static size_t
+_bucketForValue(uint64_t value)
+{
+    if (value < _EXACT_LIMIT) {
+        return (size_t) value;
+    }
+    unsigned exponent = 63 - __builtin_clzll(value);
+    size_t subBucket = (size_t) (value >> (exponent - _SUB_BUCKET_BITS)) & (_SUB_BUCKETS - 1);
+
+    return _EXACT_LIMIT + (exponent - _SUB_BUCKET_BITS - 1) * _SUB_BUCKETS + subBucket;
+}
+
+static uint64_t
+_lowestInBucket(size_t bucket)
+{
+    if (bucket < _EXACT_LIMIT) {
+        return bucket;
+    }
+    unsigned exponent = (unsigned) ((bucket - _EXACT_LIMIT) / _SUB_BUCKETS) + _SUB_BUCKET_BITS + 1;
+    uint64_t subBucket = (bucket - _EXACT_LIMIT) % _SUB_BUCKETS;
+
+    return (_SUB_BUCKETS + subBucket) << (exponent - _SUB_BUCKET_BITS);
+}
+
+static uint64_t
+_highestInBucket(size_t bucket)
+{
+    if (bucket < _EXACT_LIMIT) {
+        return bucket;
+    }
+    unsigned exponent = (unsigned) ((bucket - _EXACT_LIMIT) / _SUB_BUCKETS) + _SUB_BUCKET_BITS + 1;
+
+    return _lowestInBucket(bucket) + ((uint64_t) 1 << (exponent - _SUB_BUCKET_BITS)) - 1;
+}
+
+/**
+ * Copy the bucket counts into `counts`, returning their total.
+ */
+static uint64_t
+_snapshot(const CCNxVLCHistogram *histogram, uint64_t counts[_BUCKET_COUNT])
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < _BUCKET_COUNT; i++) {
+        counts[i] = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+        total += counts[i];
+    }
+    return total;
+}
+
+static uint64_t
+_quantileOfSnapshot(const uint64_t counts[_BUCKET_COUNT], uint64_t total, uint64_t max, double quantile)
+{
+    if (total == 0) {
+        return 0;
+    }
+
+    // The rank of the value we want, counting from 1, rounded up.
+    double exactRank = quantile * (double) total;
+    uint64_t rank = (uint64_t) exactRank;
+    if ((double) rank < exactRank || rank == 0) {
+        rank++;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < _BUCKET_COUNT; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t highest = _highestInBucket(i);
+            return (highest < max) ? highest : max;
+        }
+    }
+    return max;
+}
+
+CCNxVLCHistogram *
+ccnxVLCHistogram_Create(void)
+{
+    CCNxVLCHistogram *result = malloc(sizeof(CCNxVLCHistogram));
+    if (result != NULL) {
+        for (size_t i = 0; i < _BUCKET_COUNT; i++) {
+            atomic_init(&result->buckets[i], 0);
+        }
+        atomic_init(&result->sum, 0);
+        atomic_init(&result->min, UINT64_MAX);
+        atomic_init(&result->max, 0);
+    }
+    return result;
+}
+
+void
+ccnxVLCHistogram_Release(CCNxVLCHistogram **histogramP)
+{
+    free(*histogramP);
+
+    *histogramP = NULL;
+}
+
+void
+ccnxVLCHistogram_Record(CCNxVLCHistogram *histogram, uint64_t value)
+{
+    // Nothing is ordered against the counts, so relaxed operations are enough; they are plain
+    // locked adds on x86.
+    atomic_fetch_add_explicit(&histogram->buckets[_bucketForValue(value)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum, value, memory_order_relaxed);
+
+    // The extremes rarely change once a few values are in, so these almost never loop.
+    uint64_t min = atomic_load_explicit(&histogram->min, memory_order_relaxed);
+    while (value < min && !atomic_compare_exchange_weak_explicit(&histogram->min, &min, value,
+                                                                 memory_order_relaxed, memory_order_relaxed)) {
+    }
+    uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+    while (value > max && !atomic_compare_exchange_weak_explicit(&histogram->max, &max, value,
+                                                                 memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+uint64_t
+ccnxVLCHistogram_GetQuantile(const CCNxVLCHistogram *histogram, double quantile)
+{
+    uint64_t counts[_BUCKET_COUNT];
+    uint64_t total = _snapshot(histogram, counts);
+
+    return _quantileOfSnapshot(counts, total, atomic_load_explicit(&histogram->max, memory_order_relaxed), quantile);
+}
+
+/**
+ * Fill in `summary` from a snapshot of the counts.
+ */
+static void
+_summarizeSnapshot(const CCNxVLCHistogram *histogram, const uint64_t counts[_BUCKET_COUNT], uint64_t total,
+                   CCNxVLCHistogramSummary *summary)
+{
+    uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+    uint64_t sum = atomic_load_explicit(&histogram->sum, memory_order_relaxed);
+
+    summary->count = total;
+    summary->min = (total > 0) ? atomic_load_explicit(&histogram->min, memory_order_relaxed) : 0;
+    summary->max = (total > 0) ? max : 0;
+    summary->mean = (total > 0) ? (double) sum / (double) total : 0.0;
+    summary->p50 = _quantileOfSnapshot(counts, total, max, 0.50);
+    summary->p90 = _quantileOfSnapshot(counts, total, max, 0.90);
+    summary->p99 = _quantileOfSnapshot(counts, total, max, 0.99);
+    summary->p999 = _quantileOfSnapshot(counts, total, max, 0.999);
+}
+
+void
+ccnxVLCHistogram_GetSummary(const CCNxVLCHistogram *histogram, CCNxVLCHistogramSummary *summary)
+{
+    uint64_t counts[_BUCKET_COUNT];
+    uint64_t total = _snapshot(histogram, counts);
+
+    _summarizeSnapshot(histogram, counts, total, summary);
+}
+
+bool
+ccnxVLCHistogram_WriteJSON(const CCNxVLCHistogram *histogram, FILE *file)
+{
+    // Summarize the same counts we list, so the two agree.
+    uint64_t counts[_BUCKET_COUNT];
+    uint64_t total = _snapshot(histogram, counts);
+    CCNxVLCHistogramSummary summary;
+    _summarizeSnapshot(histogram, counts, total, &summary);
+
+    fprintf(file, "{\"count\":%"PRIu64",\"min\":%"PRIu64",\"max\":%"PRIu64",\"mean\":%.1f,"
+                  "\"p50\":%"PRIu64",\"p90\":%"PRIu64",\"p99\":%"PRIu64",\"p999\":%"PRIu64",\"buckets\":[",
+            summary.count, summary.min, summary.max, summary.mean,
+            summary.p50, summary.p90, summary.p99, summary.p999);
+
+    bool first = true;
+    for (size_t i = 0; i < _BUCKET_COUNT; i++) {
+        if (counts[i] > 0) {
+            fprintf(file, "%s[%"PRIu64",%"PRIu64",%"PRIu64"]", first ? "" : ",",
+                    _lowestInBucket(i), _highestInBucket(i), counts[i]);
+            first = false;
+        }
+    }
+    fprintf(file, "]}");
+
+    return !ferror(file);
+}
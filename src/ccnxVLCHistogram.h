@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCHistogram_h
+#define ccnxVLCHistogram_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+struct ccnx_vlc_histogram;
+typedef struct ccnx_vlc_histogram CCNxVLCHistogram;
+
+/**
+ * A snapshot of a histogram. A percentile is the upper bound of the bucket holding it, so it
+ * overstates the true value by at most an eighth, and is never beyond `max`.
+ */
+typedef struct ccnx_vlc_histogram_summary {
+    uint64_t count;                // Values recorded
+    uint64_t min;                  // The smallest value recorded, or 0 if none were
+    uint64_t max;                  // The largest value recorded, or 0 if none were
+    double   mean;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+} CCNxVLCHistogramSummary;
+
+/**
+ * Create an empty histogram of unsigned 64-bit values. Values below 16 are counted exactly;
+ * above that, each power of two is split into 8 buckets, so a bucket is never wider than an
+ * eighth of the values in it and the whole range fits in a few KiB.
+ *
+ * Recording takes no lock, so any number of threads may record into the histogram while
+ * others read it. A reader racing a writer may see a value counted in its bucket but not yet
+ * in the mean, or the reverse.
+ *
+ * @return A new CCNxVLCHistogram instance, or NULL if memory could not be allocated. It must
+ *         eventually be released by calling ccnxVLCHistogram_Release().
+ */
+CCNxVLCHistogram *ccnxVLCHistogram_Create(void);
+
+/**
+ * Release the histogram. No other thread may be using it.
+ *
+ * @param [in,out] histogramP A pointer to the histogram to release. It is set to NULL.
+ */
+void ccnxVLCHistogram_Release(CCNxVLCHistogram **histogramP);
+
+/**
+ * Count one value.
+ *
+ * @param [in] histogram The histogram instance.
+ * @param [in] value The value to count.
+ */
+void ccnxVLCHistogram_Record(CCNxVLCHistogram *histogram, uint64_t value);
+
+/**
+ * Return the value at or below which the fraction `quantile` of the recorded values lie.
+ *
+ * @param [in] histogram The histogram instance.
+ * @param [in] quantile Between 0.0 and 1.0, e.g. 0.99 for the 99th percentile.
+ *
+ * @return The upper bound of the bucket holding that value, or 0 if no values were recorded.
+ */
+uint64_t ccnxVLCHistogram_GetQuantile(const CCNxVLCHistogram *histogram, double quantile);
+
+/**
+ * Fill in `summary` from one pass over the histogram.
+ *
+ * @param [in] histogram The histogram instance.
+ * @param [out] summary The structure to fill in.
+ */
+void ccnxVLCHistogram_GetSummary(const CCNxVLCHistogram *histogram, CCNxVLCHistogramSummary *summary);
+
+/**
+ * Write the histogram to `file` as a JSON object holding the fields of its summary and a
+ * "buckets" array of [lowest, highest, count] for each bucket that is not empty.
+ *
+ * @param [in] histogram The histogram instance.
+ * @param [in] file Where to write.
+ *
+ * @return true if the object was written, false if writing failed.
+ */
+bool ccnxVLCHistogram_WriteJSON(const CCNxVLCHistogram *histogram, FILE *file);
+
+#endif // ccnxVLCHistogram_h
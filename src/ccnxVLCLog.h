@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCLog_h
+#define ccnxVLCLog_h
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * How much the per-block and per-chunk paths log, chosen at build time so that a release
+ * build pays nothing for them; each message costs a format and a lock in VLC's logger, and
+ * they run thousands of times a second.
+ *
+ *   CCNxVLCLogLevel_None   - none of them (the default)
+ *   CCNxVLCLogLevel_Blocks - a message per _CCNxBlock call and per seek
+ *   CCNxVLCLogLevel_Chunks - a message per chunk as well
+ *
+ * Build with -DCCNX_VLC_LOG_LEVEL=<level> (e.g. `make LOG_LEVEL=2`) to choose one, or
+ * define DEBUG in ccn.c for CCNxVLCLogLevel_Chunks.
+ */
+#define CCNxVLCLogLevel_None   0
+#define CCNxVLCLogLevel_Blocks 1
+#define CCNxVLCLogLevel_Chunks 2
+
+#ifndef CCNX_VLC_LOG_LEVEL
+# ifdef DEBUG
+#  define CCNX_VLC_LOG_LEVEL CCNxVLCLogLevel_Chunks
+# else
+#  define CCNX_VLC_LOG_LEVEL CCNxVLCLogLevel_None
+# endif
+#endif
+
+/**
+ * The state of one rate-limited message. A zero-initialized instance (e.g. a static one) is
+ * ready to use, and it may be shared by any number of threads.
+ */
+typedef struct ccnx_vlc_log_limit {
+    atomic_uint_least64_t nextUs;  // The message is suppressed until then
+    atomic_uint suppressed;        // How many times it has been since it was last let through
+} CCNxVLCLogLimit;
+
+/**
+ * Decide whether a message may be logged now, letting through at most one every
+ * `intervalUs`, and count it if not.
+ *
+ * @param [in] limit The state of the message.
+ * @param [in] nowUs The current time, in microseconds.
+ * @param [in] intervalUs The shortest time between two messages being let through.
+ * @param [out] suppressedP If the message may be logged, how many were suppressed before it.
+ *
+ * @return true if the message should be logged, false if it should be dropped.
+ */
+bool ccnxVLCLogLimit_Allow(CCNxVLCLogLimit *limit, uint64_t nowUs, uint64_t intervalUs, unsigned *suppressedP);
+
+#endif // ccnxVLCLog_h
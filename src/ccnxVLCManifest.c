@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCManifest.h"
+
+#include <stdlib.h>
+
+struct ccnx_vlc_manifest {
+    uint64_t chunkCount;
+
+    // chunkCount + 1 entries: the start of each chunk, then the size of the content.
+    uint64_t offsets[];
+};
+
+static uint64_t
+_readUint64(const uint8_t *data)
+{
+    uint64_t result = 0;
+    for (int i = 0; i < 8; i++) {
+        result = (result << 8) | data[i];
+    }
+    return result;
+}
+
+CCNxVLCManifest *
+ccnxVLCManifest_Create(const uint8_t *data, size_t length)
+{
+    if (length % 8 != 0 || length < 16) {
+        return NULL;
+    }
+
+    size_t valueCount = length / 8;
+    CCNxVLCManifest *result = malloc(sizeof(CCNxVLCManifest) + valueCount * sizeof(uint64_t));
+    if (result == NULL) {
+        return NULL;
+    }
+    result->chunkCount = valueCount - 1;
+
+    for (size_t i = 0; i < valueCount; i++) {
+        result->offsets[i] = _readUint64(&data[i * 8]);
+        if ((i == 0 && result->offsets[i] != 0) || (i > 0 && result->offsets[i] < result->offsets[i - 1])) {
+            free(result);
+            return NULL;
+        }
+    }
+
+    return result;
+}
+
+void
+ccnxVLCManifest_Release(CCNxVLCManifest **manifestP)
+{
+    free(*manifestP);
+    *manifestP = NULL;
+}
+
+uint64_t
+ccnxVLCManifest_GetChunkCount(const CCNxVLCManifest *manifest)
+{
+    return manifest->chunkCount;
+}
+
+uint64_t
+ccnxVLCManifest_GetContentSize(const CCNxVLCManifest *manifest)
+{
+    return manifest->offsets[manifest->chunkCount];
+}
+
+uint64_t
+ccnxVLCManifest_GetChunkForPosition(const CCNxVLCManifest *manifest, uint64_t position)
+{
+    if (position >= manifest->offsets[manifest->chunkCount]) {
+        return manifest->chunkCount;
+    }
+
+    // Find the last chunk starting at or before `position`. Empty chunks share their offset
+    // with the next one, so this skips them.
+    uint64_t low = 0;
+    uint64_t high = manifest->chunkCount - 1;
+    while (low < high) {
+        uint64_t middle = low + (high - low + 1) / 2;
+        if (manifest->offsets[middle] <= position) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+uint64_t
+ccnxVLCManifest_GetChunkOffset(const CCNxVLCManifest *manifest, uint64_t chunkNumber)
+{
+    if (chunkNumber > manifest->chunkCount) {
+        chunkNumber = manifest->chunkCount;
+    }
+    return manifest->offsets[chunkNumber];
+}
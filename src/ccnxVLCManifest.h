@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCManifest_h
+#define ccnxVLCManifest_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct ccnx_vlc_manifest;
+typedef struct ccnx_vlc_manifest CCNxVLCManifest;
+
+/**
+ * Parse a manifest listing where each chunk of a piece of content starts, so that content
+ * chunked on frame or GOP boundaries, with chunks of varying sizes, can be read at any
+ * position.
+ *
+ * The manifest is a sequence of 64-bit unsigned integers in network byte order: the byte
+ * offset at which each chunk starts, from chunk 0 (which starts at 0) to the final chunk,
+ * followed by the size of the content. The values must not decrease. A manifest of N + 1
+ * values describes N chunks.
+ *
+ * The returned instance must eventually be released by calling ccnxVLCManifest_Release().
+ *
+ * @param [in] data The manifest, e.g. the payloads of its chunks concatenated.
+ * @param [in] length The length of `data` in bytes.
+ *
+ * @return A new CCNxVLCManifest instance, or NULL if the manifest is malformed or memory
+ *         could not be allocated.
+ */
+CCNxVLCManifest *ccnxVLCManifest_Create(const uint8_t *data, size_t length);
+
+/**
+ * Release the manifest.
+ *
+ * @param [in,out] manifestP A pointer to the manifest to release. It is set to NULL.
+ */
+void ccnxVLCManifest_Release(CCNxVLCManifest **manifestP);
+
+/**
+ * Return the number of chunks the manifest describes.
+ *
+ * @param [in] manifest The manifest.
+ *
+ * @return The number of chunks, one more than the final chunk number.
+ */
+uint64_t ccnxVLCManifest_GetChunkCount(const CCNxVLCManifest *manifest);
+
+/**
+ * Return the size of the content.
+ *
+ * @param [in] manifest The manifest.
+ *
+ * @return The size of the content in bytes.
+ */
+uint64_t ccnxVLCManifest_GetContentSize(const CCNxVLCManifest *manifest);
+
+/**
+ * Return the number of the chunk holding the byte at `position`, found by binary search.
+ *
+ * @param [in] manifest The manifest.
+ * @param [in] position A byte offset in the content.
+ *
+ * @return The chunk number, or the number of chunks if `position` is past the end of the content.
+ */
+uint64_t ccnxVLCManifest_GetChunkForPosition(const CCNxVLCManifest *manifest, uint64_t position);
+
+/**
+ * Return the byte offset at which a chunk starts.
+ *
+ * @param [in] manifest The manifest.
+ * @param [in] chunkNumber A chunk number. The number of chunks gives the size of the content.
+ *
+ * @return The offset of the first byte of `chunkNumber`.
+ */
+uint64_t ccnxVLCManifest_GetChunkOffset(const CCNxVLCManifest *manifest, uint64_t chunkNumber);
+
+#endif // ccnxVLCManifest_h
@@ -0,0 +1,504 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCNameTemplate.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <parc/algol/parc_Buffer.h>
+
+#include <ccnx/common/ccnx_NameSegment.h>
+#include <ccnx/common/ccnx_NameSegmentNumber.h>
+
+typedef enum {
+    _SegmentKind_Fixed,            // Built once, when the template is created
+    _SegmentKind_Chunk,            // The chunk number, built for every name
+    _SegmentKind_Pattern           // Contains variables; rebuilt whenever one of them is set
+} _SegmentKind;
+
+typedef struct {
+    _SegmentKind kind;
+    char *pattern;                 // The text of a _SegmentKind_Pattern segment, e.g. "F{frame}"
+    CCNxNameSegment *segment;      // NULL for the chunk, or for a pattern with an unset variable
+} _Segment;
+
+typedef struct {
+    char *name;
+    char *value;                   // NULL until set
+} _Variable;
+
+struct ccnx_vlc_name_template {
+    _Segment *segments;            // Every segment of a name, in order, including those of the prefix
+    size_t segmentCount;
+    size_t segmentCapacity;
+
+    _Variable *variables;          // The variables used by the pattern segments
+    size_t variableCount;
+};
+
+static CCNxNameSegment *
+_createNameSegment(const char *text, size_t length)
+{
+    char *value = strndup(text, length);
+    if (value == NULL) {
+        return NULL;
+    }
+
+    PARCBuffer *buffer = parcBuffer_AllocateCString(value);
+    CCNxNameSegment *result = ccnxNameSegment_CreateTypeValue(CCNxNameLabelType_NAME, buffer);
+    parcBuffer_Release(&buffer);
+    free(value);
+
+    return result;
+}
+
+/**
+ * Append a segment to the template, which takes ownership of `pattern` and `segment`
+ * even if it fails.
+ */
+static int
+_addSegment(CCNxVLCNameTemplate *nameTemplate, _SegmentKind kind, char *pattern, CCNxNameSegment *segment)
+{
+    if (nameTemplate->segmentCount == nameTemplate->segmentCapacity) {
+        size_t capacity = nameTemplate->segmentCapacity == 0 ? 8 : nameTemplate->segmentCapacity * 2;
+        _Segment *segments = realloc(nameTemplate->segments, capacity * sizeof(_Segment));
+        if (segments == NULL) {
+            free(pattern);
+            if (segment != NULL) {
+                ccnxNameSegment_Release(&segment);
+            }
+            return -1;
+        }
+        nameTemplate->segments = segments;
+        nameTemplate->segmentCapacity = capacity;
+    }
+
+    _Segment *entry = &nameTemplate->segments[nameTemplate->segmentCount++];
+    entry->kind = kind;
+    entry->pattern = pattern;
+    entry->segment = segment;
+
+    return 0;
+}
+
+static int
+_addFixedSegment(CCNxVLCNameTemplate *nameTemplate, const char *text, size_t length)
+{
+    CCNxNameSegment *segment = _createNameSegment(text, length);
+    if (segment == NULL) {
+        return -1;
+    }
+    return _addSegment(nameTemplate, _SegmentKind_Fixed, NULL, segment);
+}
+
+/**
+ * Add a fixed segment for each non-empty component of `path`.
+ */
+static int
+_addPathSegments(CCNxVLCNameTemplate *nameTemplate, const char *path)
+{
+    const char *component = path;
+    while (*component != '\0') {
+        size_t length = strcspn(component, "/");
+        if (length > 0 && _addFixedSegment(nameTemplate, component, length) != 0) {
+            return -1;
+        }
+        component += length;
+        if (*component == '/') {
+            component++;
+        }
+    }
+    return 0;
+}
+
+static _Variable *
+_findVariable(const CCNxVLCNameTemplate *nameTemplate, const char *name, size_t length)
+{
+    for (size_t i = 0; i < nameTemplate->variableCount; i++) {
+        _Variable *variable = &nameTemplate->variables[i];
+        if (strlen(variable->name) == length && memcmp(variable->name, name, length) == 0) {
+            return variable;
+        }
+    }
+    return NULL;
+}
+
+static int
+_addVariable(CCNxVLCNameTemplate *nameTemplate, const char *name, size_t length)
+{
+    if (_findVariable(nameTemplate, name, length) != NULL) {
+        return 0;
+    }
+
+    _Variable *variables = realloc(nameTemplate->variables, (nameTemplate->variableCount + 1) * sizeof(_Variable));
+    if (variables == NULL) {
+        return -1;
+    }
+    nameTemplate->variables = variables;
+
+    char *copy = strndup(name, length);
+    if (copy == NULL) {
+        return -1;
+    }
+    nameTemplate->variables[nameTemplate->variableCount].name = copy;
+    nameTemplate->variables[nameTemplate->variableCount].value = NULL;
+    nameTemplate->variableCount++;
+
+    return 0;
+}
+
+/**
+ * Check the braces of a segment containing variables, and register the variables it uses.
+ * {path} and {chunk} may only be used as whole segments.
+ */
+static int
+_addPatternSegment(CCNxVLCNameTemplate *nameTemplate, const char *text, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '}') {
+            return -1;
+        }
+        if (text[i] == '{') {
+            size_t start = i + 1;
+            size_t end = start;
+            while (end < length && text[end] != '}' && text[end] != '{') {
+                end++;
+            }
+            if (end == length || text[end] != '}' || end == start) {
+                return -1;
+            }
+            size_t nameLength = end - start;
+            if ((nameLength == 4 && memcmp(&text[start], "path", 4) == 0)
+                || (nameLength == 5 && memcmp(&text[start], "chunk", 5) == 0)) {
+                return -1;
+            }
+            if (_addVariable(nameTemplate, &text[start], nameLength) != 0) {
+                return -1;
+            }
+            i = end;
+        }
+    }
+
+    char *pattern = strndup(text, length);
+    if (pattern == NULL) {
+        return -1;
+    }
+    return _addSegment(nameTemplate, _SegmentKind_Pattern, pattern, NULL);
+}
+
+/**
+ * Return true if `entry` is a pattern segment that refers to the variable `name`.
+ */
+static bool
+_usesVariable(const _Segment *entry, const char *name)
+{
+    if (entry->kind != _SegmentKind_Pattern) {
+        return false;
+    }
+
+    size_t length = strlen(name);
+    for (const char *p = strchr(entry->pattern, '{'); p != NULL; p = strchr(p + 1, '{')) {
+        const char *end = strchr(p, '}');
+        if ((size_t) (end - p - 1) == length && memcmp(p + 1, name, length) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Build the segment for `pattern` from the current values of its variables into
+ * `*segmentP`, which is set to NULL if one of them is unset.
+ */
+static int
+_createPatternSegment(const CCNxVLCNameTemplate *nameTemplate, const char *pattern, CCNxNameSegment **segmentP)
+{
+    *segmentP = NULL;
+
+    // First pass: check that every variable is set, and measure the result.
+    size_t length = 0;
+    for (const char *p = pattern; *p != '\0'; p++) {
+        if (*p == '{') {
+            const char *end = strchr(p, '}');
+            _Variable *variable = _findVariable(nameTemplate, p + 1, (size_t) (end - p - 1));
+            if (variable->value == NULL) {
+                return 0;
+            }
+            length += strlen(variable->value);
+            p = end;
+        } else {
+            length++;
+        }
+    }
+
+    char *text = malloc(length + 1);
+    if (text == NULL) {
+        return -1;
+    }
+
+    char *out = text;
+    for (const char *p = pattern; *p != '\0'; p++) {
+        if (*p == '{') {
+            const char *end = strchr(p, '}');
+            _Variable *variable = _findVariable(nameTemplate, p + 1, (size_t) (end - p - 1));
+            size_t valueLength = strlen(variable->value);
+            memcpy(out, variable->value, valueLength);
+            out += valueLength;
+            p = end;
+        } else {
+            *out++ = *p;
+        }
+    }
+
+    *segmentP = _createNameSegment(text, length);
+    free(text);
+
+    return *segmentP == NULL ? -1 : 0;
+}
+
+static int
+_parseSchema(CCNxVLCNameTemplate *nameTemplate, const char *schema, const char *path)
+{
+    unsigned chunkSegments = 0;
+
+    const char *part = schema;
+    while (*part != '\0') {
+        size_t length = strcspn(part, "/");
+        int failed = 0;
+
+        if (length == 0) {
+            // Leading, trailing or doubled '/'
+        } else if (length == 6 && memcmp(part, "{path}", 6) == 0) {
+            failed = _addPathSegments(nameTemplate, path);
+        } else if (length == 7 && memcmp(part, "{chunk}", 7) == 0) {
+            chunkSegments++;
+            failed = _addSegment(nameTemplate, _SegmentKind_Chunk, NULL, NULL);
+        } else if (memchr(part, '{', length) != NULL || memchr(part, '}', length) != NULL) {
+            failed = _addPatternSegment(nameTemplate, part, length);
+        } else {
+            failed = _addFixedSegment(nameTemplate, part, length);
+        }
+
+        if (failed) {
+            return -1;
+        }
+
+        part += length;
+        if (*part == '/') {
+            part++;
+        }
+    }
+
+    return chunkSegments == 1 ? 0 : -1;
+}
+
+CCNxVLCNameTemplate *
+ccnxVLCNameTemplate_Create(const CCNxName *prefix, const char *schema, const char *path)
+{
+    CCNxVLCNameTemplate *result = calloc(1, sizeof(CCNxVLCNameTemplate));
+    if (result == NULL) {
+        return NULL;
+    }
+
+    size_t prefixSegments = ccnxName_GetSegmentCount(prefix);
+    for (size_t i = 0; i < prefixSegments; i++) {
+        CCNxNameSegment *segment = ccnxNameSegment_Acquire(ccnxName_GetSegment(prefix, i));
+        if (_addSegment(result, _SegmentKind_Fixed, NULL, segment) != 0) {
+            ccnxVLCNameTemplate_Release(&result);
+            return NULL;
+        }
+    }
+
+    if (_parseSchema(result, schema, path) != 0) {
+        ccnxVLCNameTemplate_Release(&result);
+    }
+
+    return result;
+}
+
+void
+ccnxVLCNameTemplate_Release(CCNxVLCNameTemplate **templateP)
+{
+    CCNxVLCNameTemplate *nameTemplate = *templateP;
+
+    for (size_t i = 0; i < nameTemplate->segmentCount; i++) {
+        if (nameTemplate->segments[i].segment != NULL) {
+            ccnxNameSegment_Release(&nameTemplate->segments[i].segment);
+        }
+        free(nameTemplate->segments[i].pattern);
+    }
+    free(nameTemplate->segments);
+
+    for (size_t i = 0; i < nameTemplate->variableCount; i++) {
+        free(nameTemplate->variables[i].name);
+        free(nameTemplate->variables[i].value);
+    }
+    free(nameTemplate->variables);
+
+    free(nameTemplate);
+
+    *templateP = NULL;
+}
+
+int
+ccnxVLCNameTemplate_SetVariable(CCNxVLCNameTemplate *nameTemplate, const char *name, const char *value)
+{
+    _Variable *variable = _findVariable(nameTemplate, name, strlen(name));
+    if (variable == NULL) {
+        return 0;
+    }
+
+    if (variable->value != NULL && strcmp(variable->value, value) == 0) {
+        return 0;
+    }
+
+    char *copy = strdup(value);
+    if (copy == NULL) {
+        return -1;
+    }
+    char *previous = variable->value;
+    variable->value = copy;
+
+    // Build every segment that uses the variable before replacing any, so that a failure
+    // leaves the template as it was.
+    size_t count = 0;
+    for (size_t i = 0; i < nameTemplate->segmentCount; i++) {
+        if (_usesVariable(&nameTemplate->segments[i], name)) {
+            count++;
+        }
+    }
+    CCNxNameSegment **segments = calloc(count > 0 ? count : 1, sizeof(CCNxNameSegment *));
+    int result = (segments != NULL) ? 0 : -1;
+    for (size_t i = 0, built = 0; i < nameTemplate->segmentCount && result == 0; i++) {
+        _Segment *entry = &nameTemplate->segments[i];
+        if (_usesVariable(entry, name)) {
+            result = _createPatternSegment(nameTemplate, entry->pattern, &segments[built++]);
+        }
+    }
+
+    if (result != 0) {
+        for (size_t i = 0; segments != NULL && i < count; i++) {
+            if (segments[i] != NULL) {
+                ccnxNameSegment_Release(&segments[i]);
+            }
+        }
+        variable->value = previous;
+        free(copy);
+    } else {
+        for (size_t i = 0, built = 0; i < nameTemplate->segmentCount; i++) {
+            _Segment *entry = &nameTemplate->segments[i];
+            if (_usesVariable(entry, name)) {
+                if (entry->segment != NULL) {
+                    ccnxNameSegment_Release(&entry->segment);
+                }
+                entry->segment = segments[built++];
+            }
+        }
+        free(previous);
+    }
+    free(segments);
+
+    return result;
+}
+
+const char *
+ccnxVLCNameTemplate_GetUnsetVariable(const CCNxVLCNameTemplate *nameTemplate)
+{
+    for (size_t i = 0; i < nameTemplate->variableCount; i++) {
+        if (nameTemplate->variables[i].value == NULL) {
+            return nameTemplate->variables[i].name;
+        }
+    }
+    return NULL;
+}
+
+CCNxName *
+ccnxVLCNameTemplate_CreateName(const CCNxVLCNameTemplate *nameTemplate, uint64_t chunkNumber)
+{
+    CCNxName *result = ccnxName_Create();
+
+    // ccnxName_Append() acquires a reference, so the template's segments are shared, not copied.
+    for (size_t i = 0; i < nameTemplate->segmentCount; i++) {
+        const _Segment *entry = &nameTemplate->segments[i];
+        if (entry->kind == _SegmentKind_Chunk) {
+            CCNxNameSegment *chunkSegment = ccnxNameSegmentNumber_Create(CCNxNameLabelType_CHUNK, chunkNumber);
+            ccnxName_Append(result, chunkSegment);
+            ccnxNameSegment_Release(&chunkSegment);
+        } else if (entry->segment != NULL) {
+            ccnxName_Append(result, entry->segment);
+        } else {
+            ccnxName_Release(&result);
+            return NULL;
+        }
+    }
+
+    return result;
+}
+
+CCNxInterest *
+ccnxVLCNameTemplate_CreateInterest(const CCNxVLCNameTemplate *nameTemplate, uint64_t chunkNumber)
+{
+    CCNxName *name = ccnxVLCNameTemplate_CreateName(nameTemplate, chunkNumber);
+    if (name == NULL) {
+        return NULL;
+    }
+
+    CCNxInterest *result = ccnxInterest_CreateSimple(name);
+    ccnxName_Release(&name);
+
+    return result;
+}
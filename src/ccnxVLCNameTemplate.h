@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCNameTemplate_h
+#define ccnxVLCNameTemplate_h
+
+#include <stdint.h>
+
+#include <ccnx/common/ccnx_Name.h>
+#include <ccnx/common/ccnx_Interest.h>
+
+struct ccnx_vlc_name_template;
+typedef struct ccnx_vlc_name_template CCNxVLCNameTemplate;
+
+/**
+ * The schema used when none is configured. It matches the names served by our producers:
+ * the file's path, the chunk number, then the frame and the number of layers.
+ */
+#define CCNxVLCNameTemplate_DefaultSchema "/fetch/{path}/{chunk}/F{frame}/L{layers}"
+
+/**
+ * Create a template for the names of the chunks of one piece of content from a schema.
+ *
+ * The schema is a list of segments separated by '/'. A segment may be:
+ *   - `{path}`, replaced by one segment for each component of `path`;
+ *   - `{chunk}`, the chunk number, encoded as a CHUNK segment. It must appear exactly once;
+ *   - text containing variables such as `F{frame}`, filled in by ccnxVLCNameTemplate_SetVariable();
+ *   - plain text.
+ * All segments except the chunk number are built here, or when a variable changes, and are
+ * shared by every name created from the template.
+ *
+ * The template is not thread-safe. The returned instance must eventually be released by
+ * calling ccnxVLCNameTemplate_Release().
+ *
+ * Example:
+ * @code
+ * {
+ *     CCNxVLCNameTemplate *nameTemplate =
+ *         ccnxVLCNameTemplate_Create(prefix, CCNxVLCNameTemplate_DefaultSchema, "movies/big_buck_bunny.mp4");
+ *     ccnxVLCNameTemplate_SetVariable(nameTemplate, "frame", "50");
+ *     ccnxVLCNameTemplate_SetVariable(nameTemplate, "layers", "4");
+ *     CCNxInterest *interest = ccnxVLCNameTemplate_CreateInterest(nameTemplate, 12);
+ * }
+ * @endcode
+ *
+ * @param [in] prefix The name preceding the segments of the schema. The template keeps references to its segments.
+ * @param [in] schema The schema, as described above.
+ * @param [in] path The path of the content. Components are separated by '/'.
+ *
+ * @return A new CCNxVLCNameTemplate instance, or NULL if the schema is invalid or memory could not be allocated.
+ */
+CCNxVLCNameTemplate *ccnxVLCNameTemplate_Create(const CCNxName *prefix, const char *schema, const char *path);
+
+/**
+ * Release the template and the segments it holds.
+ *
+ * @param [in,out] templateP A pointer to the template to release. It is set to NULL.
+ */
+void ccnxVLCNameTemplate_Release(CCNxVLCNameTemplate **templateP);
+
+/**
+ * Set the value of a variable used by the schema, and rebuild the segments that use it.
+ * Setting a variable the schema does not use has no effect. If a segment can't be rebuilt,
+ * the template is left unchanged, with the variable's previous value.
+ *
+ * @param [in] nameTemplate The template.
+ * @param [in] name The name of the variable, without braces.
+ * @param [in] value The text to put in place of the variable.
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int ccnxVLCNameTemplate_SetVariable(CCNxVLCNameTemplate *nameTemplate, const char *name, const char *value);
+
+/**
+ * Return the name of a variable used by the schema that has not been set, if any.
+ * Names cannot be created until every variable has been set.
+ *
+ * @param [in] nameTemplate The template.
+ *
+ * @return The name of a variable without a value, or NULL if all of them have one.
+ */
+const char *ccnxVLCNameTemplate_GetUnsetVariable(const CCNxVLCNameTemplate *nameTemplate);
+
+/**
+ * Create the name of the given chunk. The only segment built is the chunk number.
+ * The returned name must be released by calling ccnxName_Release().
+ *
+ * @param [in] nameTemplate The template.
+ * @param [in] chunkNumber The chunk number to put in the name.
+ *
+ * @return A new CCNxName for `chunkNumber`, or NULL if a variable has not been set.
+ */
+CCNxName *ccnxVLCNameTemplate_CreateName(const CCNxVLCNameTemplate *nameTemplate, uint64_t chunkNumber);
+
+/**
+ * Create an Interest for the given chunk, as ccnxInterest_CreateSimple() on the name returned
+ * by ccnxVLCNameTemplate_CreateName(). The returned Interest must be released by calling
+ * ccnxInterest_Release().
+ *
+ * @param [in] nameTemplate The template.
+ * @param [in] chunkNumber The chunk number to request.
+ *
+ * @return A new CCNxInterest for `chunkNumber`, or NULL if a variable has not been set.
+ */
+CCNxInterest *ccnxVLCNameTemplate_CreateInterest(const CCNxVLCNameTemplate *nameTemplate, uint64_t chunkNumber);
+
+#endif // ccnxVLCNameTemplate_h
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCPortal_h
+#define ccnxVLCPortal_h
+
+#include <stdbool.h>
+
+#include <ccnx/api/ccnx_Portal/ccnx_Portal.h>
+
+/**
+ * The operations the dispatcher needs from a Portal, so that the fetch path can run over
+ * something other than a CCNx transport stack, such as the in-process producer of
+ * ccn_access_bench. Every operation takes the instance the interface was paired with.
+ * The dispatcher serializes calls to send and receive.
+ */
+typedef struct ccnx_vlc_portal_interface {
+    /**
+     * Send a message, waiting up to `timeout` for it to be accepted.
+     * Returns false if it was not.
+     */
+    bool (*send)(void *instance, const CCNxMetaMessage *message, const CCNxStackTimeout *timeout);
+
+    /**
+     * Return the next message received, waiting up to `timeout` for one, or NULL if none
+     * arrived. The caller must release the message.
+     */
+    CCNxMetaMessage *(*receive)(void *instance, const CCNxStackTimeout *timeout);
+
+    /**
+     * Return a file descriptor that polls readable while a message is waiting to be received.
+     */
+    int (*getFileId)(const void *instance);
+
+    /**
+     * Return true if nothing more will ever be received.
+     */
+    bool (*isEOF)(const void *instance);
+
+    /**
+     * Release the instance, setting `*instanceP` to NULL.
+     */
+    void (*release)(void **instanceP);
+} CCNxVLCPortalInterface;
+
+/**
+ * The CCNxVLCPortalInterface of a CCNxPortal.
+ */
+extern const CCNxVLCPortalInterface *CCNxVLCPortalInterface_CCNxPortal;
+
+#endif // ccnxVLCPortal_h
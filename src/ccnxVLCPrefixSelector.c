@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCPrefixSelector.h"
+
+#include <stdlib.h>
+
+// Weight of the newest sample in the smoothed RTT and loss, as for TCP's SRTT.
+#define _RTT_WEIGHT  0.125
+#define _LOSS_WEIGHT 0.125
+
+// The least weight a prefix that is up is credited with, relative to the best one,
+// so that it keeps getting enough Interests for us to notice it improving.
+#define _MIN_RELATIVE_WEIGHT 0.05
+
+// How many Interests in a row must time out before a prefix is considered down, and how long
+// we wait before probing it, doubled after each unanswered probe up to a limit.
+#define _DOWN_AFTER_TIMEOUTS 3
+#define _FIRST_PROBE_US 1000000
+#define _MAX_PROBE_US   16000000
+
+typedef struct {
+    CCNxVLCPrefixStats stats;      // share is only filled in by ccnxVLCPrefixSelector_GetStats()
+    double credit;                 // Smooth weighted round robin: the prefix with the most is chosen next
+    unsigned consecutiveTimeouts;
+    uint64_t probeAtUs;            // While down, when it may next be probed
+    uint64_t probeIntervalUs;      // While down, the wait before the probe after that
+    bool probing;                  // While down, a probe is outstanding
+} _CCNxVLCPrefix;
+
+struct ccnx_vlc_prefix_selector {
+    size_t count;
+    _CCNxVLCPrefix prefixes[];
+};
+
+/**
+ * Return the RTT assumed for prefixes without a sample yet: the best one measured, so that
+ * they get tried as if they were as good as the best, or 0 if none has been measured.
+ */
+static uint64_t
+_unmeasuredRtt(const CCNxVLCPrefixSelector *selector)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < selector->count; i++) {
+        uint64_t srttUs = selector->prefixes[i].stats.srttUs;
+        if (srttUs > 0 && (result == 0 || srttUs < result)) {
+            result = srttUs;
+        }
+    }
+    return result;
+}
+
+/**
+ * Return the weight of `prefix`, its delivery rate divided by its RTT again to favour the
+ * fastest, or 0 if it is down.
+ */
+static double
+_estimateWeight(const _CCNxVLCPrefix *prefix, uint64_t unmeasuredRttUs)
+{
+    if (prefix->stats.down) {
+        return 0.0;
+    }
+    uint64_t rttUs = (prefix->stats.srttUs > 0) ? prefix->stats.srttUs : unmeasuredRttUs;
+
+    // With no RTT measured anywhere, all prefixes are alike.
+    double rtt = (rttUs > 0) ? (double) rttUs : 1.0;
+    return (1.0 - prefix->stats.loss) / (rtt * rtt);
+}
+
+/**
+ * Fill in `weights` with the weight each prefix is credited with, floored at _MIN_RELATIVE_WEIGHT
+ * of the best, and return their sum, which is 0 if every prefix is down.
+ */
+static double
+_creditedWeights(const CCNxVLCPrefixSelector *selector, double weights[])
+{
+    uint64_t unmeasuredRttUs = _unmeasuredRtt(selector);
+    double best = 0.0;
+    for (size_t i = 0; i < selector->count; i++) {
+        weights[i] = _estimateWeight(&selector->prefixes[i], unmeasuredRttUs);
+        if (weights[i] > best) {
+            best = weights[i];
+        }
+    }
+
+    double total = 0.0;
+    for (size_t i = 0; i < selector->count; i++) {
+        if (!selector->prefixes[i].stats.down && weights[i] < best * _MIN_RELATIVE_WEIGHT) {
+            weights[i] = best * _MIN_RELATIVE_WEIGHT;
+        }
+        total += weights[i];
+    }
+    return total;
+}
+
+/**
+ * Return the prefix that is down and due to be probed first.
+ */
+static size_t
+_nextProbe(const CCNxVLCPrefixSelector *selector)
+{
+    size_t result = 0;
+    for (size_t i = 1; i < selector->count; i++) {
+        if (selector->prefixes[i].probeAtUs < selector->prefixes[result].probeAtUs) {
+            result = i;
+        }
+    }
+    return result;
+}
+
+CCNxVLCPrefixSelector *
+ccnxVLCPrefixSelector_Create(size_t prefixCount)
+{
+    CCNxVLCPrefixSelector *result = calloc(1, sizeof(CCNxVLCPrefixSelector) + prefixCount * sizeof(_CCNxVLCPrefix));
+    if (result != NULL) {
+        result->count = prefixCount;
+        for (size_t i = 0; i < prefixCount; i++) {
+            result->prefixes[i].probeIntervalUs = _FIRST_PROBE_US;
+        }
+    }
+    return result;
+}
+
+void
+ccnxVLCPrefixSelector_Release(CCNxVLCPrefixSelector **selectorP)
+{
+    free(*selectorP);
+    *selectorP = NULL;
+}
+
+size_t
+ccnxVLCPrefixSelector_GetCount(const CCNxVLCPrefixSelector *selector)
+{
+    return selector->count;
+}
+
+size_t
+ccnxVLCPrefixSelector_Choose(CCNxVLCPrefixSelector *selector, uint64_t nowUs)
+{
+    size_t chosen = selector->count;
+
+    for (size_t i = 0; i < selector->count && chosen == selector->count; i++) {
+        _CCNxVLCPrefix *prefix = &selector->prefixes[i];
+        if (prefix->stats.down && !prefix->probing && nowUs >= prefix->probeAtUs) {
+            prefix->probing = true;
+            prefix->probeAtUs = nowUs + prefix->probeIntervalUs;
+            prefix->probeIntervalUs = (prefix->probeIntervalUs * 2 < _MAX_PROBE_US) ? prefix->probeIntervalUs * 2 : _MAX_PROBE_US;
+            chosen = i;
+        }
+    }
+
+    if (chosen == selector->count) {
+        double weights[selector->count];
+        double total = _creditedWeights(selector, weights);
+
+        if (total > 0.0) {
+            // Smooth weighted round robin: every prefix earns its share, and the one with the
+            // most credit pays for the Interest. Over any run of Interests each prefix gets
+            // close to its share, without the bursts a random choice would give it.
+            for (size_t i = 0; i < selector->count; i++) {
+                _CCNxVLCPrefix *prefix = &selector->prefixes[i];
+                prefix->credit += weights[i] / total;
+                if (!prefix->stats.down && (chosen == selector->count || prefix->credit > selector->prefixes[chosen].credit)) {
+                    chosen = i;
+                }
+            }
+            selector->prefixes[chosen].credit -= 1.0;
+        } else {
+            chosen = _nextProbe(selector);
+        }
+    }
+
+    selector->prefixes[chosen].stats.interestsSent++;
+    return chosen;
+}
+
+size_t
+ccnxVLCPrefixSelector_GetBest(const CCNxVLCPrefixSelector *selector)
+{
+    uint64_t unmeasuredRttUs = _unmeasuredRtt(selector);
+    size_t result = selector->count;
+    double best = 0.0;
+
+    for (size_t i = 0; i < selector->count; i++) {
+        double weight = _estimateWeight(&selector->prefixes[i], unmeasuredRttUs);
+        if (!selector->prefixes[i].stats.down && (result == selector->count || weight > best)) {
+            result = i;
+            best = weight;
+        }
+    }
+    return (result < selector->count) ? result : _nextProbe(selector);
+}
+
+void
+ccnxVLCPrefixSelector_OnContent(CCNxVLCPrefixSelector *selector, size_t prefixNumber, uint64_t rttUs)
+{
+    _CCNxVLCPrefix *prefix = &selector->prefixes[prefixNumber];
+
+    prefix->stats.contentObjectsReceived++;
+    prefix->stats.loss *= 1.0 - _LOSS_WEIGHT;
+    prefix->consecutiveTimeouts = 0;
+    if (rttUs > 0) {
+        prefix->stats.srttUs = (prefix->stats.srttUs == 0)
+                               ? rttUs
+                               : (uint64_t) ((1.0 - _RTT_WEIGHT) * prefix->stats.srttUs + _RTT_WEIGHT * rttUs);
+    }
+
+    if (prefix->stats.down) {
+        prefix->stats.down = false;
+        prefix->probing = false;
+        prefix->probeIntervalUs = _FIRST_PROBE_US;
+        prefix->credit = 0.0;
+    }
+}
+
+void
+ccnxVLCPrefixSelector_OnTimeout(CCNxVLCPrefixSelector *selector, size_t prefixNumber, uint64_t nowUs)
+{
+    _CCNxVLCPrefix *prefix = &selector->prefixes[prefixNumber];
+
+    prefix->stats.timeouts++;
+    prefix->stats.loss = (1.0 - _LOSS_WEIGHT) * prefix->stats.loss + _LOSS_WEIGHT;
+    prefix->consecutiveTimeouts++;
+
+    if (prefix->stats.down) {
+        // The probe, or an Interest sent before we found the prefix down; either way we may
+        // probe again when due.
+        prefix->probing = false;
+    } else if (prefix->consecutiveTimeouts >= _DOWN_AFTER_TIMEOUTS) {
+        prefix->stats.down = true;
+        prefix->stats.failovers++;
+        prefix->probeAtUs = nowUs + prefix->probeIntervalUs;
+        prefix->probing = false;
+    }
+}
+
+void
+ccnxVLCPrefixSelector_GetStats(const CCNxVLCPrefixSelector *selector, size_t prefixNumber, CCNxVLCPrefixStats *stats)
+{
+    double weights[selector->count];
+    double total = _creditedWeights(selector, weights);
+
+    *stats = selector->prefixes[prefixNumber].stats;
+    stats->share = (total > 0.0) ? weights[prefixNumber] / total : 0.0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCPrefixSelector_h
+#define ccnxVLCPrefixSelector_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+struct ccnx_vlc_prefix_selector;
+typedef struct ccnx_vlc_prefix_selector CCNxVLCPrefixSelector;
+
+/**
+ * A snapshot of what a CCNxVLCPrefixSelector knows about one prefix.
+ */
+typedef struct ccnx_vlc_prefix_stats {
+    uint64_t srttUs;                 // Smoothed RTT, or 0 before the first sample
+    double loss;                     // Smoothed fraction of Interests that timed out
+    double share;                    // Fraction of Interests it currently gets; 0 while it is down
+    bool down;                       // It stopped answering, and is only probed until it answers again
+    uint64_t interestsSent;
+    uint64_t contentObjectsReceived;
+    uint64_t timeouts;
+    uint64_t failovers;              // Number of times it was found down
+} CCNxVLCPrefixStats;
+
+/**
+ * Create a selector that spreads the Interests for a title over `prefixCount` prefixes,
+ * each naming a replica of it, numbered from 0.
+ *
+ * Each prefix gets a share of the Interests proportional to (1 - loss) / RTT^2, so that a
+ * replica that is far away or busy gets fewer, though never so few that we would miss it
+ * getting better. That favours the fastest replicas more than their delivery rate alone
+ * would, since chunks are played in order and a slow one holds up those after it. A prefix whose Interests time out several
+ * times in a row is considered down: it gets none, apart from one probe after a while
+ * (doubling each time the probe goes unanswered), until it answers again. If every prefix
+ * is down, the one due to be probed first is used anyway.
+ *
+ * The selector is not thread-safe. The returned instance must eventually be released by
+ * calling ccnxVLCPrefixSelector_Release().
+ *
+ * @param [in] prefixCount The number of prefixes. Must be > 0.
+ *
+ * @return A new CCNxVLCPrefixSelector instance, or NULL if memory could not be allocated.
+ */
+CCNxVLCPrefixSelector *ccnxVLCPrefixSelector_Create(size_t prefixCount);
+
+/**
+ * Release the prefix selector.
+ *
+ * @param [in,out] selectorP A pointer to the instance to release. It is set to NULL.
+ */
+void ccnxVLCPrefixSelector_Release(CCNxVLCPrefixSelector **selectorP);
+
+/**
+ * Return the number of prefixes the selector chooses from.
+ *
+ * @param [in] selector The prefix selector.
+ *
+ * @return The number of prefixes.
+ */
+size_t ccnxVLCPrefixSelector_GetCount(const CCNxVLCPrefixSelector *selector);
+
+/**
+ * Choose the prefix to send the next Interest to, and count it as sent there.
+ *
+ * @param [in] selector The prefix selector.
+ * @param [in] nowUs The current time, in microseconds.
+ *
+ * @return The number of the prefix.
+ */
+size_t ccnxVLCPrefixSelector_Choose(CCNxVLCPrefixSelector *selector, uint64_t nowUs);
+
+/**
+ * Return the prefix that is up and has the highest weight, for traffic that can't be
+ * spread, e.g. a chunked flow. Nothing is counted as sent.
+ *
+ * @param [in] selector The prefix selector.
+ *
+ * @return The number of the prefix.
+ */
+size_t ccnxVLCPrefixSelector_GetBest(const CCNxVLCPrefixSelector *selector);
+
+/**
+ * Report that an Interest sent to `prefix` was answered.
+ *
+ * @param [in] selector The prefix selector.
+ * @param [in] prefix The prefix the Interest was sent to.
+ * @param [in] rttUs The RTT sample, or 0 if there is none (e.g. after a retransmission).
+ */
+void ccnxVLCPrefixSelector_OnContent(CCNxVLCPrefixSelector *selector, size_t prefix, uint64_t rttUs);
+
+/**
+ * Report that an Interest sent to `prefix` went unanswered for a retransmission timeout.
+ *
+ * @param [in] selector The prefix selector.
+ * @param [in] prefix The prefix the Interest was sent to.
+ * @param [in] nowUs The current time, in microseconds.
+ */
+void ccnxVLCPrefixSelector_OnTimeout(CCNxVLCPrefixSelector *selector, size_t prefix, uint64_t nowUs);
+
+/**
+ * Fill in a snapshot of what the selector knows about `prefix`.
+ *
+ * @param [in] selector The prefix selector.
+ * @param [in] prefix The prefix.
+ * @param [out] stats The structure to fill in.
+ */
+void ccnxVLCPrefixSelector_GetStats(const CCNxVLCPrefixSelector *selector, size_t prefix, CCNxVLCPrefixStats *stats);
+
+#endif // ccnxVLCPrefixSelector_h
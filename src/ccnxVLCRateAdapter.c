@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCRateAdapter.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+// Rates are measured over intervals at least this long, then smoothed with this weight
+// for the newest sample.
+#define _RATE_INTERVAL_US 500000
+#define _RATE_WEIGHT      0.3
+
+// Read-ahead watermarks, as fractions of its capacity.
+#define _LOW_BUFFER  0.25
+#define _HIGH_BUFFER 0.9
+
+// How long the buffer must stay beyond a watermark before we act on it. A buffer that
+// stays low without refilling means the network can only just keep up. It counts as
+// refilling while the goodput exceeds the consumption by this fraction.
+#define _LOW_HOLD_US  2000000
+#define _HIGH_HOLD_US 4000000
+#define _REFILL_MARGIN 0.05
+
+// If we have to step down this soon after stepping up, the higher level didn't fit, and
+// the time the buffer must stay high before trying that level again is doubled, up to a
+// limit. It is reset once the level has been held for longer.
+#define _FAILED_PROBE_US    15000000
+#define _MAX_HIGH_HOLD_US   64000000
+
+// The least time after any switch before stepping down again, or up. Stepping up is
+// deliberately slower, so we don't oscillate between two levels.
+#define _DOWN_DWELL_US 2000000
+#define _UP_DWELL_US   8000000
+
+typedef struct {
+    uint64_t startUs;              // Start of the current interval, or 0 before the first
+    uint64_t bytes;                // Bytes counted since then
+    uint64_t rateBps;              // Smoothed rate
+    bool valid;                    // At least one interval has been measured
+} _Rate;
+
+struct ccnx_vlc_rate_adapter {
+    unsigned minLevel;
+    unsigned maxLevel;
+
+    CCNxVLCRateAdapterStats stats;
+
+    _Rate goodput;
+    _Rate consumption;
+    uint64_t lastBytesConsumed;
+
+    uint64_t lowSinceUs;           // When the buffer fell below _LOW_BUFFER, or 0 if it isn't
+    uint64_t highSinceUs;          // When the buffer rose above _HIGH_BUFFER, or 0 if it isn't
+    uint64_t lastSwitchUs;
+    bool lastSwitchUp;
+
+    // How long the buffer must stay high before stepping up to each level, indexed by level.
+    uint64_t highHoldUs[];
+};
+
+static void
+_rateRestart(_Rate *rate, uint64_t nowUs)
+{
+    rate->startUs = nowUs;
+    rate->bytes = 0;
+}
+
+/**
+ * Close the current interval if it is long enough, and fold it into the smoothed rate.
+ */
+static void
+_rateSample(_Rate *rate, uint64_t nowUs)
+{
+    if (rate->startUs == 0) {
+        _rateRestart(rate, nowUs);
+        return;
+    }
+
+    uint64_t elapsedUs = nowUs - rate->startUs;
+    if (elapsedUs < _RATE_INTERVAL_US) {
+        return;
+    }
+
+    uint64_t sampleBps = rate->bytes * 1000000 / elapsedUs;
+    if (rate->valid) {
+        rate->rateBps = (uint64_t) (_RATE_WEIGHT * sampleBps + (1.0 - _RATE_WEIGHT) * rate->rateBps);
+    } else {
+        rate->rateBps = sampleBps;
+        rate->valid = true;
+    }
+    _rateRestart(rate, nowUs);
+}
+
+static void
+_switchTo(CCNxVLCRateAdapter *adapter, unsigned level, uint64_t nowUs)
+{
+    bool up = level > adapter->stats.level;
+    if (up) {
+        adapter->stats.switchesUp++;
+    } else {
+        adapter->stats.switchesDown++;
+        if (adapter->lastSwitchUp) {
+            uint64_t *holdUs = &adapter->highHoldUs[adapter->stats.level];
+            if (nowUs - adapter->lastSwitchUs < _FAILED_PROBE_US) {
+                *holdUs = *holdUs * 2 < _MAX_HIGH_HOLD_US ? *holdUs * 2 : _MAX_HIGH_HOLD_US;
+            } else {
+                *holdUs = _HIGH_HOLD_US;
+            }
+        }
+    }
+    adapter->stats.level = level;
+    adapter->lastSwitchUs = nowUs;
+    adapter->lastSwitchUp = up;
+
+    // The buffer has to show the effect of this level before we judge it.
+    adapter->lowSinceUs = 0;
+    adapter->highSinceUs = 0;
+}
+
+CCNxVLCRateAdapter *
+ccnxVLCRateAdapter_Create(unsigned minLevel, unsigned maxLevel)
+{
+    CCNxVLCRateAdapter *result = calloc(1, sizeof(CCNxVLCRateAdapter) + (maxLevel + 1) * sizeof(uint64_t));
+    if (result != NULL) {
+        result->minLevel = minLevel;
+        result->maxLevel = maxLevel;
+        result->stats.level = maxLevel;
+        for (unsigned level = 0; level <= maxLevel; level++) {
+            result->highHoldUs[level] = _HIGH_HOLD_US;
+        }
+    }
+    return result;
+}
+
+void
+ccnxVLCRateAdapter_Release(CCNxVLCRateAdapter **adapterP)
+{
+    free(*adapterP);
+    *adapterP = NULL;
+}
+
+void
+ccnxVLCRateAdapter_OnChunkReceived(CCNxVLCRateAdapter *adapter, size_t bytes, uint64_t nowUs)
+{
+    if (adapter->goodput.startUs == 0) {
+        _rateRestart(&adapter->goodput, nowUs);
+    }
+    adapter->goodput.bytes += bytes;
+}
+
+unsigned
+ccnxVLCRateAdapter_Update(CCNxVLCRateAdapter *adapter, uint64_t nowUs,
+                          size_t bufferedChunks, size_t bufferCapacity, uint64_t bytesConsumed)
+{
+    adapter->consumption.bytes += bytesConsumed - adapter->lastBytesConsumed;
+    adapter->lastBytesConsumed = bytesConsumed;
+    _rateSample(&adapter->consumption, nowUs);
+
+    // While the buffer is full the fetcher is idle, which says nothing about the network.
+    if (bufferedChunks >= bufferCapacity) {
+        _rateRestart(&adapter->goodput, nowUs);
+    } else {
+        _rateSample(&adapter->goodput, nowUs);
+    }
+
+    adapter->stats.goodputBps = adapter->goodput.rateBps;
+    adapter->stats.consumptionBps = adapter->consumption.rateBps;
+
+    double fill = bufferCapacity > 0 ? (double) bufferedChunks / bufferCapacity : 0.0;
+
+    if (fill <= _LOW_BUFFER) {
+        if (adapter->lowSinceUs == 0) {
+            adapter->lowSinceUs = nowUs;
+        }
+    } else {
+        adapter->lowSinceUs = 0;
+    }
+
+    if (fill >= _HIGH_BUFFER) {
+        if (adapter->highSinceUs == 0) {
+            adapter->highSinceUs = nowUs;
+        }
+    } else {
+        adapter->highSinceUs = 0;
+    }
+
+    unsigned level = adapter->stats.level;
+    uint64_t sinceSwitchUs = adapter->lastSwitchUs == 0 ? UINT64_MAX : nowUs - adapter->lastSwitchUs;
+
+    if (adapter->lowSinceUs != 0 && level > adapter->minLevel && sinceSwitchUs >= _DOWN_DWELL_US) {
+        bool measured = adapter->goodput.valid && adapter->consumption.valid;
+        bool draining = measured && adapter->goodput.rateBps < adapter->consumption.rateBps;
+        bool refilling = measured && adapter->goodput.rateBps > (1.0 + _REFILL_MARGIN) * adapter->consumption.rateBps;
+        if (draining || (!refilling && nowUs - adapter->lowSinceUs >= _LOW_HOLD_US)) {
+            _switchTo(adapter, level - 1, nowUs);
+        }
+    } else if (adapter->highSinceUs != 0 && level < adapter->maxLevel && sinceSwitchUs >= _UP_DWELL_US
+               && nowUs - adapter->highSinceUs >= adapter->highHoldUs[level + 1]) {
+        _switchTo(adapter, level + 1, nowUs);
+    }
+
+    return adapter->stats.level;
+}
+
+unsigned
+ccnxVLCRateAdapter_GetLevel(const CCNxVLCRateAdapter *adapter)
+{
+    return adapter->stats.level;
+}
+
+void
+ccnxVLCRateAdapter_GetStats(const CCNxVLCRateAdapter *adapter, CCNxVLCRateAdapterStats *stats)
+{
+    *stats = adapter->stats;
+}
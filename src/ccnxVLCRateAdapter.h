@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCRateAdapter_h
+#define ccnxVLCRateAdapter_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct ccnx_vlc_rate_adapter;
+typedef struct ccnx_vlc_rate_adapter CCNxVLCRateAdapter;
+
+/**
+ * A snapshot of the state of a CCNxVLCRateAdapter instance.
+ */
+typedef struct ccnx_vlc_rate_adapter_stats {
+    unsigned level;            // The level currently requested, e.g. the number of layers
+    uint64_t goodputBps;       // Smoothed rate at which chunk payloads arrive, in bytes per second
+    uint64_t consumptionBps;   // Smoothed rate at which the player takes them, in bytes per second
+    uint64_t switchesUp;       // Number of times the level was raised
+    uint64_t switchesDown;     // Number of times the level was lowered
+} CCNxVLCRateAdapterStats;
+
+/**
+ * Create a controller that picks which quality level to request, from `minLevel` (the
+ * cheapest) to `maxLevel` (the best), based on the goodput of the fetch path and how full
+ * the read-ahead buffer is.
+ *
+ * The level steps down when the buffer is draining and chunks arrive more slowly than the
+ * player consumes them, and steps up only after the buffer has stayed nearly full for a
+ * while. Switches are spaced out so that the buffer can respond to one before the next.
+ *
+ * The adapter is not thread-safe. The returned instance must eventually be released by
+ * calling ccnxVLCRateAdapter_Release().
+ *
+ * @param [in] minLevel The lowest level that may be requested.
+ * @param [in] maxLevel The highest level that may be requested. Must be >= `minLevel`.
+ *                      The adapter starts at this level.
+ *
+ * @return A new CCNxVLCRateAdapter instance, or NULL if memory could not be allocated.
+ */
+CCNxVLCRateAdapter *ccnxVLCRateAdapter_Create(unsigned minLevel, unsigned maxLevel);
+
+/**
+ * Release the rate adapter.
+ *
+ * @param [in,out] adapterP A pointer to the instance to release. It is set to NULL.
+ */
+void ccnxVLCRateAdapter_Release(CCNxVLCRateAdapter **adapterP);
+
+/**
+ * Report that a chunk arrived from the network.
+ *
+ * @param [in] adapter The rate adapter.
+ * @param [in] bytes The size of the chunk's payload.
+ * @param [in] nowUs The current time, in microseconds.
+ */
+void ccnxVLCRateAdapter_OnChunkReceived(CCNxVLCRateAdapter *adapter, size_t bytes, uint64_t nowUs);
+
+/**
+ * Report the state of the read-ahead buffer and decide which level to request next.
+ * Call this regularly, including while no chunks are arriving.
+ *
+ * @param [in] adapter The rate adapter.
+ * @param [in] nowUs The current time, in microseconds.
+ * @param [in] bufferedChunks The number of chunks waiting in the read-ahead buffer.
+ * @param [in] bufferCapacity The number of chunks the read-ahead buffer can hold.
+ * @param [in] bytesConsumed The total payload bytes the player has taken from the buffer so far.
+ *
+ * @return The level to request for the following chunks.
+ */
+unsigned ccnxVLCRateAdapter_Update(CCNxVLCRateAdapter *adapter, uint64_t nowUs,
+                                   size_t bufferedChunks, size_t bufferCapacity, uint64_t bytesConsumed);
+
+/**
+ * Return the level currently requested.
+ *
+ * @param [in] adapter The rate adapter.
+ *
+ * @return The current level.
+ */
+unsigned ccnxVLCRateAdapter_GetLevel(const CCNxVLCRateAdapter *adapter);
+
+/**
+ * Fill in a snapshot of the rate adapter's state.
+ *
+ * @param [in] adapter The rate adapter.
+ * @param [out] stats The structure to fill in.
+ */
+void ccnxVLCRateAdapter_GetStats(const CCNxVLCRateAdapter *adapter, CCNxVLCRateAdapterStats *stats);
+
+#endif // ccnxVLCRateAdapter_h
@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#include "ccnxVLCTrace.h"
+#include "ccnxVLCUtils.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+    uint64_t timestampUs;
+    uint64_t durationUs;           // Only for complete ('X') events
+    uint64_t value;
+    const char *name;
+    const char *argName;
+    char phase;                    // The trace-event phase: 'i', 'X', or 'b', 'n' and 'e' for chunk spans
+} _CCNxVLCTraceEvent;
+
+struct ccnx_vlc_trace_buffer {
+    CCNxVLCTrace *trace;
+    CCNxVLCTraceBuffer *next;
+    unsigned threadId;             // The tid of the buffer's events; the trace numbers its buffers from 1
+    size_t capacity;
+    size_t count;                  // Events recorded since the buffer was last written out
+    _CCNxVLCTraceEvent *events;
+};
+
+struct ccnx_vlc_trace {
+    pthread_mutex_t lock;          // Guards everything below
+    FILE *file;
+    bool eventWritten;             // An event is in the file, so the next needs a comma before it
+    uint64_t startUs;              // Timestamps in the file count from here
+    int processId;
+    unsigned threadCount;
+    CCNxVLCTraceBuffer *buffers;
+};
+
+/**
+ * Write `string` to `file` as a JSON string, quotes included.
+ */
+static void
+_writeString(FILE *file, const char *string)
+{
+    fputc('"', file);
+    for (const unsigned char *c = (const unsigned char *) string; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(file, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(file, "\\u%04x", *c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+/**
+ * Write a metadata event naming the process or thread `threadId` (0 for the process).
+ * Must be called with the trace's lock held, or before it is shared.
+ */
+static void
+_writeName(CCNxVLCTrace *trace, unsigned threadId, const char *name)
+{
+    fprintf(trace->file, "%s{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":",
+            trace->eventWritten ? ",\n" : "\n", (threadId == 0) ? "process_name" : "thread_name",
+            trace->processId, threadId);
+    _writeString(trace->file, name);
+    fprintf(trace->file, "}}");
+    trace->eventWritten = true;
+}
+
+/**
+ * Write out the events in `buffer` and empty it. Must be called with the trace's lock held,
+ * or once no thread is recording.
+ */
+static void
+_writeEvents(CCNxVLCTrace *trace, CCNxVLCTraceBuffer *buffer)
+{
+    for (size_t i = 0; i < buffer->count; i++) {
+        const _CCNxVLCTraceEvent *event = &buffer->events[i];
+        uint64_t timestampUs = (event->timestampUs > trace->startUs) ? event->timestampUs - trace->startUs : 0;
+
+        fprintf(trace->file, "%s{\"name\":", trace->eventWritten ? ",\n" : "\n");
+        _writeString(trace->file, event->name);
+        fprintf(trace->file, ",\"ph\":\"%c\",\"ts\":%"PRIu64",\"pid\":%d,\"tid\":%u",
+                event->phase, timestampUs, trace->processId, buffer->threadId);
+        switch (event->phase) {
+            case 'X':
+                fprintf(trace->file, ",\"dur\":%"PRIu64, event->durationUs);
+                break;
+            case 'i':
+                fprintf(trace->file, ",\"s\":\"t\"");
+                break;
+            default:
+                // Spans about a chunk are matched up, and drawn on a track, by category and id.
+                fprintf(trace->file, ",\"cat\":\"chunk\",\"id\":%"PRIu64, event->value);
+                break;
+        }
+        fprintf(trace->file, ",\"args\":{");
+        _writeString(trace->file, event->argName);
+        fprintf(trace->file, ":%"PRIu64"}}", event->value);
+        trace->eventWritten = true;
+    }
+    buffer->count = 0;
+}
+
+static void _record(CCNxVLCTraceBuffer *buffer, char phase, const char *name, uint64_t timestampUs,
+                    uint64_t durationUs, const char *argName, uint64_t value);
+
+/**
+ * Make room in a full buffer by writing it out, showing how long that took in the trace.
+ */
+static void
+_flushFullBuffer(CCNxVLCTraceBuffer *buffer)
+{
+    CCNxVLCTrace *trace = buffer->trace;
+    uint64_t startUs = ccnxVLCUtils_NowMicroseconds();
+    size_t count = buffer->count;
+
+    pthread_mutex_lock(&trace->lock);
+    _writeEvents(trace, buffer);
+    pthread_mutex_unlock(&trace->lock);
+
+    uint64_t nowUs = ccnxVLCUtils_NowMicroseconds();
+    _record(buffer, 'X', "trace flush", startUs, nowUs - startUs, "events", count);
+}
+
+static void
+_record(CCNxVLCTraceBuffer *buffer, char phase, const char *name, uint64_t timestampUs,
+        uint64_t durationUs, const char *argName, uint64_t value)
+{
+    if (buffer->count == buffer->capacity) {
+        _flushFullBuffer(buffer);
+    }
+
+    _CCNxVLCTraceEvent *event = &buffer->events[buffer->count++];
+    event->timestampUs = timestampUs;
+    event->durationUs = durationUs;
+    event->value = value;
+    event->name = name;
+    event->argName = argName;
+    event->phase = phase;
+}
+
+CCNxVLCTrace *
+ccnxVLCTrace_Create(const char *path, const char *processName)
+{
+    CCNxVLCTrace *result = calloc(1, sizeof(CCNxVLCTrace));
+    if (result == NULL) {
+        return NULL;
+    }
+
+    result->file = fopen(path, "w");
+    if (result->file == NULL) {
+        free(result);
+        return NULL;
+    }
+    pthread_mutex_init(&result->lock, NULL);
+    result->startUs = ccnxVLCUtils_NowMicroseconds();
+    result->processId = (int) getpid();
+
+    fprintf(result->file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    _writeName(result, 0, processName);
+
+    return result;
+}
+
+void
+ccnxVLCTrace_Release(CCNxVLCTrace **traceP)
+{
+    CCNxVLCTrace *trace = *traceP;
+
+    while (trace->buffers != NULL) {
+        CCNxVLCTraceBuffer *buffer = trace->buffers;
+        trace->buffers = buffer->next;
+
+        _writeEvents(trace, buffer);
+        free(buffer->events);
+        free(buffer);
+    }
+    fprintf(trace->file, "\n]}\n");
+    fclose(trace->file);
+    pthread_mutex_destroy(&trace->lock);
+    free(trace);
+
+    *traceP = NULL;
+}
+
+CCNxVLCTraceBuffer *
+ccnxVLCTrace_AddThread(CCNxVLCTrace *trace, const char *threadName, size_t capacity)
+{
+    CCNxVLCTraceBuffer *result = calloc(1, sizeof(CCNxVLCTraceBuffer));
+    if (result == NULL) {
+        return NULL;
+    }
+
+    // A full buffer records its own flush, so it needs room for at least that.
+    result->capacity = (capacity > 1) ? capacity : 2;
+    result->events = calloc(result->capacity, sizeof(_CCNxVLCTraceEvent));
+    if (result->events == NULL) {
+        free(result);
+        return NULL;
+    }
+    result->trace = trace;
+
+    pthread_mutex_lock(&trace->lock);
+    result->threadId = ++trace->threadCount;
+    result->next = trace->buffers;
+    trace->buffers = result;
+    _writeName(trace, result->threadId, threadName);
+    pthread_mutex_unlock(&trace->lock);
+
+    return result;
+}
+
+void
+ccnxVLCTraceBuffer_Instant(CCNxVLCTraceBuffer *buffer, const char *name, const char *argName, uint64_t value)
+{
+    if (buffer != NULL) {
+        _record(buffer, 'i', name, ccnxVLCUtils_NowMicroseconds(), 0, argName, value);
+    }
+}
+
+void
+ccnxVLCTraceBuffer_Complete(CCNxVLCTraceBuffer *buffer, const char *name, uint64_t startUs,
+                            const char *argName, uint64_t value)
+{
+    if (buffer != NULL) {
+        uint64_t nowUs = ccnxVLCUtils_NowMicroseconds();
+        _record(buffer, 'X', name, startUs, (nowUs > startUs) ? nowUs - startUs : 0, argName, value);
+    }
+}
+
+void
+ccnxVLCTraceBuffer_BeginChunk(CCNxVLCTraceBuffer *buffer, const char *name, uint64_t chunkNumber)
+{
+    if (buffer != NULL) {
+        _record(buffer, 'b', name, ccnxVLCUtils_NowMicroseconds(), 0, "chunk", chunkNumber);
+    }
+}
+
+void
+ccnxVLCTraceBuffer_MarkChunk(CCNxVLCTraceBuffer *buffer, const char *name, uint64_t chunkNumber)
+{
+    if (buffer != NULL) {
+        _record(buffer, 'n', name, ccnxVLCUtils_NowMicroseconds(), 0, "chunk", chunkNumber);
+    }
+}
+
+void
+ccnxVLCTraceBuffer_EndChunk(CCNxVLCTraceBuffer *buffer, const char *name, uint64_t chunkNumber)
+{
+    if (buffer != NULL) {
+        _record(buffer, 'e', name, ccnxVLCUtils_NowMicroseconds(), 0, "chunk", chunkNumber);
+    }
+}
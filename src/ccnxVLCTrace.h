@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2014-2015, Xerox Corporation (Xerox) and Palo Alto Research Center, Inc (PARC)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL XEROX OR PARC BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ################################################################################
+ * #
+ * # PATENT NOTICE
+ * #
+ * # This software is distributed under the BSD 2-clause License (see LICENSE
+ * # file).  This BSD License does not make any patent claims and as such, does
+ * # not act as a patent grant.  The purpose of this section is for each contributor
+ * # to define their intentions with respect to intellectual property.
+ * #
+ * # Each contributor to this source code is encouraged to state their patent
+ * # claims and licensing mechanisms for any contributions made. At the end of
+ * # this section contributors may each make their own statements.  Contributor's
+ * # claims and grants only apply to the pieces (source code, programs, text,
+ * # media, etc) that they have contributed directly to this software.
+ * #
+ * # There is no guarantee that this section is complete, up to date or accurate. It
+ * # is up to the contributors to maintain their portion of this section and up to
+ * # the user of the software to verify any claims herein.
+ * #
+ * # Do not remove this header notification.  The contents of this section must be
+ * # present in all distributions of the software.  You may only modify your own
+ * # intellectual property statements.  Please provide contact information.
+ *
+ * - Palo Alto Research Center, Inc
+ * This software distribution does not grant any rights to patents owned by Palo
+ * Alto Research Center, Inc (PARC). Rights to these patents are available via
+ * various mechanisms. As of January 2016 PARC has committed to FRAND licensing any
+ * intellectual property used by its contributions to this software. You may
+ * contact PARC at cipo@parc.com for more information or visit http://www.ccnx.org
+ */
+
+#ifndef ccnxVLCTrace_h
+#define ccnxVLCTrace_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct ccnx_vlc_trace;
+typedef struct ccnx_vlc_trace CCNxVLCTrace;
+
+struct ccnx_vlc_trace_buffer;
+typedef struct ccnx_vlc_trace_buffer CCNxVLCTraceBuffer;
+
+/**
+ * Create a trace written to `path` in the Chrome trace-event JSON format, which
+ * chrome://tracing and ui.perfetto.dev open. Events are recorded into buffers, one per
+ * thread, allocated up front so that recording an event costs a clock read and a few
+ * stores; a buffer is only written out when it fills (which is itself shown in the trace as
+ * a "trace flush" slice) and when the trace is released.
+ *
+ * @param [in] path The file to write, which is truncated.
+ * @param [in] processName The name shown for the process the events belong to.
+ *
+ * @return A new CCNxVLCTrace instance, or NULL if the file could not be created or memory
+ *         could not be allocated. It must eventually be released by calling
+ *         ccnxVLCTrace_Release().
+ */
+CCNxVLCTrace *ccnxVLCTrace_Create(const char *path, const char *processName);
+
+/**
+ * Write out the events still buffered, finish the file and release the trace with its
+ * buffers. No thread may be recording into them.
+ *
+ * @param [in,out] traceP A pointer to the trace to release. It is set to NULL.
+ */
+void ccnxVLCTrace_Release(CCNxVLCTrace **traceP);
+
+/**
+ * Add a buffer of `capacity` events for one thread to record into. Only that thread may
+ * record into it, though which thread that is may change if the previous one is done with it.
+ *
+ * @param [in] trace The trace instance.
+ * @param [in] threadName The name shown for the events of the buffer.
+ * @param [in] capacity How many events the buffer holds before it is written out.
+ *
+ * @return The new buffer, owned by the trace, or NULL if memory could not be allocated.
+ */
+CCNxVLCTraceBuffer *ccnxVLCTrace_AddThread(CCNxVLCTrace *trace, const char *threadName, size_t capacity);
+
+/*
+ * The functions below record one event into a buffer. They do nothing if `buffer` is NULL,
+ * so callers can leave tracing disabled by passing NULL. Every name must be a string
+ * literal, or otherwise outlive the trace: only the pointer is recorded. An event carries
+ * one named number, e.g. the chunk it is about.
+ */
+
+/**
+ * Record that something happened now.
+ *
+ * @param [in] buffer The buffer of the calling thread, or NULL.
+ * @param [in] name The name of the event.
+ * @param [in] argName The name of `value`.
+ * @param [in] value The number the event carries.
+ */
+void ccnxVLCTraceBuffer_Instant(CCNxVLCTraceBuffer *buffer, const char *name, const char *argName, uint64_t value);
+
+/**
+ * Record something that started at `startUs` and has just finished.
+ *
+ * @param [in] buffer The buffer of the calling thread, or NULL.
+ * @param [in] name The name of the event.
+ * @param [in] startUs When it started, from ccnxVLCUtils_NowMicroseconds().
+ * @param [in] argName The name of `value`.
+ * @param [in] value The number the event carries.
+ */
+void ccnxVLCTraceBuffer_Complete(CCNxVLCTraceBuffer *buffer, const char *name, uint64_t startUs,
+                                 const char *argName, uint64_t value);
+
+/**
+ * Record the start of the lifetime of chunk `chunkNumber`'s Interest, or of some other span
+ * named `name` about that chunk which may end on another thread. Each chunk is shown on its
+ * own track.
+ *
+ * @param [in] buffer The buffer of the calling thread, or NULL.
+ * @param [in] name The name of the span.
+ * @param [in] chunkNumber The chunk the span is about.
+ */
+void ccnxVLCTraceBuffer_BeginChunk(CCNxVLCTraceBuffer *buffer, const char *name, uint64_t chunkNumber);
+
+/**
+ * Record something that happened to chunk `chunkNumber`, on its track.
+ *
+ * @param [in] buffer The buffer of the calling thread, or NULL.
+ * @param [in] name The name of the event.
+ * @param [in] chunkNumber The chunk the event is about.
+ */
+void ccnxVLCTraceBuffer_MarkChunk(CCNxVLCTraceBuffer *buffer, const char *name, uint64_t chunkNumber);
+
+/**
+ * Record the end of the span begun by ccnxVLCTraceBuffer_BeginChunk() with the same name.
+ *
+ * @param [in] buffer The buffer of the calling thread, or NULL.
+ * @param [in] name The name of the span.
+ * @param [in] chunkNumber The chunk the span is about.
+ */
+void ccnxVLCTraceBuffer_EndChunk(CCNxVLCTraceBuffer *buffer, const char *name, uint64_t chunkNumber);
+
+#endif // ccnxVLCTrace_h
@@ -55,6 +55,13 @@
 
 #include "ccnxVLCUtils.h"
 
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
 #include <LongBow/runtime.h>
 
 #include <ccnx/common/ccnx_ContentObject.h>
@@ -68,21 +75,92 @@
 #include <parc/security/parc_IdentityFile.h>
 #include <parc/security/parc_Pkcs12KeyStore.h>
 
+#include <openssl/pkcs12.h>
+#include <openssl/x509.h>
 
-PARCIdentity *
-ccnxVLCUtils_CreateAndGetIdentity(const char *keystoreName, const char *keystorePassword, const char *subjectName)
-{
-    parcSecurity_Init();
 
+// A keystore whose certificate expires within this many seconds is replaced rather than
+// reused, so that it doesn't expire while a stream is playing.
+#define _KEYSTORE_MIN_REMAINING_VALIDITY_S (24 * 60 * 60)
+
+// The portal factory shared by every stream of the process, created on first use.
+static CCNxPortalFactory *_sharedPortalFactory = NULL;
+static pthread_mutex_t _sharedPortalFactoryLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Generate a keystore under a temporary name and move it into place, so that a process
+ * opening the keystore never reads a partly written file, even if another process is
+ * generating one at the same time.
+ */
+static void
+_createKeystore(const char *keystoreName, const char *keystorePassword, const char *subjectName)
+{
     unsigned int keyLength = 1024;
     unsigned int validityDays = 30;
 
-    bool success = parcPkcs12KeyStore_CreateFile(keystoreName, keystorePassword, subjectName, keyLength, validityDays);
+    size_t temporaryLength = strlen(keystoreName) + 32;
+    char *temporaryName = malloc(temporaryLength);
+    assertNotNull(temporaryName, "Could not allocate the name of the temporary keystore");
+    snprintf(temporaryName, temporaryLength, "%s.%ld.tmp", keystoreName, (long) getpid());
+
+    bool success = parcPkcs12KeyStore_CreateFile(temporaryName, keystorePassword, subjectName, keyLength, validityDays);
     assertTrue(success,
                "parcPublicKeySignerPkcs12Store_CreateFile('%s', '%s', '%s', %d, %d) failed.",
-               keystoreName, keystorePassword, subjectName, keyLength, validityDays);
+               temporaryName, keystorePassword, subjectName, keyLength, validityDays);
+
+    success = (rename(temporaryName, keystoreName) == 0);
+    assertTrue(success, "rename('%s', '%s') failed.", temporaryName, keystoreName);
+
+    free(temporaryName);
+}
+
+/**
+ * Return true if the keystore `keystoreName` opens with `keystorePassword` and holds a
+ * private key and a certificate that is valid now and for a while yet. PARC only tells us
+ * whether the file exists, so the keystore is read with OpenSSL, which PARC uses itself.
+ */
+static bool
+_isKeystoreUsable(const char *keystoreName, const char *keystorePassword)
+{
+    FILE *file = fopen(keystoreName, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    PKCS12 *pkcs12 = d2i_PKCS12_fp(file, NULL);
+    fclose(file);
+    if (pkcs12 == NULL) {
+        return false;
+    }
+
+    EVP_PKEY *key = NULL;
+    X509 *certificate = NULL;
+    bool result = false;
+    if (PKCS12_parse(pkcs12, keystorePassword, &key, &certificate, NULL) == 1
+        && key != NULL && certificate != NULL) {
+        time_t expiryLimit = time(NULL) + _KEYSTORE_MIN_REMAINING_VALIDITY_S;
+        result = (X509_cmp_current_time(X509_get_notBefore(certificate)) < 0
+                  && X509_cmp_time(X509_get_notAfter(certificate), &expiryLimit) > 0);
+    }
+
+    EVP_PKEY_free(key);
+    X509_free(certificate);
+    PKCS12_free(pkcs12);
+    return result;
+}
+
+PARCIdentity *
+ccnxVLCUtils_CreateAndGetIdentity(const char *keystoreName, const char *keystorePassword, const char *subjectName)
+{
+    parcSecurity_Init();
 
+    // Generating the key pair takes far longer than anything else in opening a stream, so a
+    // keystore left by an earlier run is reused, unless it is unreadable with our password or
+    // its certificate has expired or is about to.
     PARCIdentityFile *identityFile = parcIdentityFile_Create(keystoreName, keystorePassword);
+    if (!parcIdentityFile_Exists(identityFile) || !_isKeystoreUsable(keystoreName, keystorePassword)) {
+        _createKeystore(keystoreName, keystorePassword, subjectName);
+    }
+
     PARCIdentity *result = parcIdentity_Create(identityFile, PARCIdentityFileAsPARCIdentity);
     parcIdentityFile_Release(&identityFile);
 
@@ -101,19 +179,48 @@ ccnxVLCUtils_SetupPortalFactory(const char *keystoreName, const char *keystorePa
     return result;
 }
 
+CCNxPortalFactory *
+ccnxVLCUtils_AcquireSharedPortalFactory(const char *keystoreName, const char *keystorePassword, const char *subjectName)
+{
+    pthread_mutex_lock(&_sharedPortalFactoryLock);
+
+    if (_sharedPortalFactory == NULL) {
+        _sharedPortalFactory = ccnxVLCUtils_SetupPortalFactory(keystoreName, keystorePassword, subjectName);
+    }
+    CCNxPortalFactory *result = NULL;
+    if (_sharedPortalFactory != NULL) {
+        result = ccnxPortalFactory_Acquire(_sharedPortalFactory);
+    }
+
+    pthread_mutex_unlock(&_sharedPortalFactoryLock);
+    return result;
+}
+
 uint64_t
 ccnxVLCUtils_GetChunkNumberFromName(const CCNxName *name)
 {
-    size_t numberOfSegmentsInName = ccnxName_GetSegmentCount(name);
-    CCNxNameSegment *chunkNumberSegment = ccnxName_GetSegment(name, numberOfSegmentsInName - 3);//changedByUs
+    // Our name schemas may put segments after the chunk number, so look for it by type,
+    // starting from the end where it usually is.
+    CCNxNameSegment *chunkNumberSegment = NULL;
+    for (size_t i = ccnxName_GetSegmentCount(name); i > 0 && chunkNumberSegment == NULL; i--) {
+        CCNxNameSegment *segment = ccnxName_GetSegment(name, i - 1);
+        if (ccnxNameSegment_GetType(segment) == CCNxNameLabelType_CHUNK) {
+            chunkNumberSegment = segment;
+        }
+    }
 
-    assertTrue(ccnxNameSegment_GetType(chunkNumberSegment) == CCNxNameLabelType_CHUNK,
-               "Last segment is the wrong type, expected CCNxNameLabelType %02X got %02X",
-               CCNxNameLabelType_CHUNK,
-               ccnxNameSegment_GetType(chunkNumberSegment)) {
+    assertNotNull(chunkNumberSegment, "Name has no segment of type CCNxNameLabelType %02X", CCNxNameLabelType_CHUNK) {
         ccnxName_Display(name, 0); // This executes only if the enclosing assertion fails
     }
 
     return ccnxNameSegmentNumber_Value(chunkNumberSegment);
 }
 
+uint64_t
+ccnxVLCUtils_NowMicroseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000 + (uint64_t) now.tv_nsec / 1000;
+}
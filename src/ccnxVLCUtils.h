@@ -66,42 +66,69 @@
 
 
 /**
- * Creates and returns a new randomly generated Identity, which is required for signing.
- * In a real application, you would actually use a real Identity. The returned instance
- * must eventually be released by calling parcIdentity_Release().
+ * Returns the Identity, which is required for signing, held in the keystore `keystoreName`.
+ * If there is no such keystore, or it can't be opened with `keystorePassword`, or its
+ * certificate has expired or expires within a day, a randomly generated one replaces it
+ * first. In a real application, you would actually use a real Identity. The returned
+ * instance must eventually be released by calling parcIdentity_Release().
  *
- * @param [in] keystoreName The name of the file to save the new identity.
+ * @param [in] keystoreName The name of the file holding the identity, or to save a new one.
  * @param [in] keystorePassword The password of the file holding the identity.
- * @param [in] subjectName The name of the owner of the identity.
+ * @param [in] subjectName The name of the owner of the identity, if a new one is created.
  *
  *
- * @return A new, randomly generated, PARCIdentity instance.
+ * @return A PARCIdentity instance, read from the keystore or randomly generated.
  */
 PARCIdentity *ccnxVLCUtils_CreateAndGetIdentity(const char *keystoreName, const char *keystorePassword, const char *subjectName);
 
 
 /**
- * Initialize and return a new instance of CCNxPortalFactory. A randomly generated identity is
- * used to initialize the factory. The returned instance must eventually be released by calling
- * ccnxPortalFactory_Release().
+ * Initialize and return a new instance of CCNxPortalFactory, using the identity returned by
+ * ccnxVLCUtils_CreateAndGetIdentity(). The returned instance must eventually be released by
+ * calling ccnxPortalFactory_Release().
  *
- * @param [in] keystoreName The name of the file to save the new identity.
+ * @param [in] keystoreName The name of the file holding the identity, or to save a new one.
  * @param [in] keystorePassword The password of the file holding the identity.
- * @param [in] subjectName The name of the owner of the identity.
+ * @param [in] subjectName The name of the owner of the identity, if a new one is created.
  *
- * @return A new instance of a CCNxPortalFactory initialized with a randomly created identity.
+ * @return A new instance of a CCNxPortalFactory initialized with the identity.
  */
 CCNxPortalFactory *ccnxVLCUtils_SetupPortalFactory(const char *keystoreName, const char *keystorePassword, const char *subjectName);
 
+/**
+ * Return the CCNxPortalFactory shared by the whole process, creating it with
+ * ccnxVLCUtils_SetupPortalFactory() on first use. Only the first call's arguments are used.
+ * This function is thread-safe, so concurrent callers wait for one identity to be set up
+ * rather than each making its own. The returned reference must eventually be released by
+ * calling ccnxPortalFactory_Release(); the factory itself lives as long as the process.
+ *
+ * @param [in] keystoreName The name of the file holding the identity, or to save a new one.
+ * @param [in] keystorePassword The password of the file holding the identity.
+ * @param [in] subjectName The name of the owner of the identity, if a new one is created.
+ *
+ * @return A new reference to the shared CCNxPortalFactory, or NULL if it could not be created.
+ */
+CCNxPortalFactory *ccnxVLCUtils_AcquireSharedPortalFactory(const char *keystoreName, const char *keystorePassword,
+                                                           const char *subjectName);
+
 
 /**
  * Given a CCNxName instance, return the numeric value of the chunk specified by the Name.
- * The chunk number is contained in the final NameSegment of the Name.
+ * The chunk number is contained in the last NameSegment of type CCNxNameLabelType_CHUNK,
+ * wherever it is in the Name.
  *
  * @param [in] name A CCNxName instance from which to extract the chunk number.
  * @return The chunk number encoded in the supplied CCNxName instance.
  */
 uint64_t ccnxVLCUtils_GetChunkNumberFromName(const CCNxName *name);
 
+/**
+ * Return the current time from a monotonic clock, in microseconds. Only differences between
+ * two values are meaningful.
+ *
+ * @return The current monotonic time in microseconds.
+ */
+uint64_t ccnxVLCUtils_NowMicroseconds(void);
+
 #endif // ccnxVLCUtils_h
 